@@ -30,13 +30,15 @@ www.navitia.io
 
 #include "autocomplete.h"
 #include "type/pt_data.h"
+#include "utils/parallel.h"
 namespace navitia { namespace autocomplete {
 
 static void compute_score_poi(type::PT_Data&, georef::GeoRef& georef) {
-    for (auto it = georef.fl_poi.word_quality_list.begin(); it != georef.fl_poi.word_quality_list.end(); ++it){
-        for (navitia::georef::Admin* admin : georef.pois[it->first]->admin_list){
+    auto& word_quality_list = georef.fl_poi.word_quality_list;
+    for (size_t idx = 0; idx < word_quality_list.size(); ++idx){
+        for (navitia::georef::Admin* admin : georef.pois[idx]->admin_list){
             if(admin->level == 8){
-                it->second.score = georef.fl_admin.word_quality_list.at(admin->idx).score;
+                word_quality_list[idx].score = georef.fl_admin.word_quality_list.at(admin->idx).score;
             }
         }
     }
@@ -45,10 +47,11 @@ static void compute_score_poi(type::PT_Data&, georef::GeoRef& georef) {
 
 static void compute_score_way(type::PT_Data&, georef::GeoRef& georef) {
     //The scocre of each admin(level 8) is attributed to all its ways
-    for (auto it = georef.fl_way.word_quality_list.begin(); it != georef.fl_way.word_quality_list.end(); ++it){
-        for (navitia::georef::Admin* admin : georef.ways[it->first]->admin_list){
+    auto& word_quality_list = georef.fl_way.word_quality_list;
+    for (size_t idx = 0; idx < word_quality_list.size(); ++idx){
+        for (navitia::georef::Admin* admin : georef.ways[idx]->admin_list){
             if (admin->level == 8){
-                it->second.score = georef.fl_admin.word_quality_list.at(admin->idx).score;
+                word_quality_list[idx].score = georef.fl_admin.word_quality_list.at(admin->idx).score;
             }
         }
     }
@@ -57,10 +60,11 @@ static void compute_score_way(type::PT_Data&, georef::GeoRef& georef) {
 
 static void compute_score_stop_point(type::PT_Data& pt_data, georef::GeoRef& georef) {
     //The scocre of each admin(level 8) is attributed to all its stop_points
-    for (auto it = pt_data.stop_point_autocomplete.word_quality_list.begin(); it != pt_data.stop_point_autocomplete.word_quality_list.end(); ++it){
-        for(navitia::georef::Admin* admin : pt_data.stop_points[it->first]->admin_list){
+    auto& word_quality_list = pt_data.stop_point_autocomplete.word_quality_list;
+    for (size_t idx = 0; idx < word_quality_list.size(); ++idx){
+        for(navitia::georef::Admin* admin : pt_data.stop_points[idx]->admin_list){
             if (admin->level == 8){
-                it->second.score = georef.fl_admin.word_quality_list.at(admin->idx).score;
+                word_quality_list[idx].score = georef.fl_admin.word_quality_list.at(admin->idx).score;
             }
         }
     }
@@ -84,9 +88,10 @@ static void compute_score_stop_area(type::PT_Data& pt_data, const georef::GeoRef
 
     //Ajust the score of each stop_area from 0 to 100 using maximum score (max_score)
     if (max_score > 0){
-        for (auto & it : pt_data.stop_area_autocomplete.word_quality_list){
-            const size_t ad_score = admin_score(pt_data.stop_areas[it.first]->admin_list, georef);
-            it.second.score = ad_score + (pt_data.stop_areas[it.first]->stop_point_list.size() * 100)/max_score;
+        auto& word_quality_list = pt_data.stop_area_autocomplete.word_quality_list;
+        for (size_t idx = 0; idx < word_quality_list.size(); ++idx){
+            const size_t ad_score = admin_score(pt_data.stop_areas[idx]->admin_list, georef);
+            word_quality_list[idx].score = ad_score + (pt_data.stop_areas[idx]->stop_point_list.size() * 100)/max_score;
         }
     }
 }
@@ -126,8 +131,8 @@ static void compute_score_admin(type::PT_Data& pt_data, georef::GeoRef& georef)
     }
 
     //Ajust the score of each admin using natural logarithm as : log(n+2)*10
-    for (auto it = georef.fl_admin.word_quality_list.begin(); it != georef.fl_admin.word_quality_list.end(); ++it){
-        it->second.score = log(it->second.score + 2) * 10;
+    for (auto& quality : georef.fl_admin.word_quality_list){
+        quality.score = log(quality.score + 2) * 10;
     }
 }
 
@@ -153,6 +158,12 @@ void Autocomplete<type::idx_t>::compute_score(type::PT_Data &pt_data, georef::Ge
         default:
             break;
     }
+    //The posting lists are sorted by score, so the best objects are found first
+    rank_by_score();
+}
+
+void build_in_parallel(const std::vector<std::function<void()>>& builds) {
+    for_each_in_threads(builds.size(), builds.size(), [&](size_t i) { builds[i](); });
 }
 
 }}
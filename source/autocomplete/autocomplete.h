@@ -29,34 +29,24 @@ www.navitia.io
 */
 
 #pragma once
-#include <boost/tokenizer.hpp>
 #include <boost/algorithm/string.hpp>
 #include <boost/serialization/serialization.hpp>
 #include <boost/serialization/vector.hpp>
 #include <boost/serialization/utility.hpp>
 #include <boost/serialization/map.hpp>
 #include <algorithm>
-#include <regex>
-#include <boost/regex.hpp>
+#include <numeric>
 #include <map>
 #include <unordered_map>
 #include <set>
+#include <functional>
 #include "type/type.h"
 #include "utils/functions.h"
+#include "autocomplete/dictionary.h"
+#include "autocomplete/tokenizer.h"
 
 namespace navitia { namespace autocomplete {
 
-struct Compare {
-    bool operator()(const  std::string& str_a, const std::string& str_b) const {
-        if(str_a.length() == str_b.length()){
-            return str_a >= str_b;
-        }else{
-            return (str_a.length() > str_b.length());
-        }
-    }
-};
-
-using autocomplete_map = std::map<std::string, std::string, Compare>;
 /** Map de type Autocomplete
   *
   * On associe une chaine de caractères, par exemple "rue jean jaures" à une valeur T (typiquement un pointeur
@@ -102,33 +92,54 @@ struct Autocomplete
     /// Type of object
     navitia::type::Type_e object_type;
 
-    /// Structure temporaire pour construire l'indexe
-    std::map<std::string, std::set<T> > temp_word_map;
-
-    /// À chaque mot (par exemple "rue" ou "jaures") on associe un tableau de T qui contient la liste des éléments contenant ce mot
-    typedef std::pair<std::string, std::vector<T> > vec_elt;
+    /** Structures temporaires pour construire l'indexe
+      *
+      * Each word gets a number the first time it is seen, and each (word, position) is appended to a vector.
+      * build() sorts the vectors, which is much cheaper than inserting in a map of sets.
+      */
+    std::unordered_map<std::string, uint32_t> temp_word_ids;
+    std::vector<std::pair<uint32_t, T>> temp_word_postings;
 
+    /// À chaque mot (par exemple "rue" ou "jaures") on associe la liste des éléments contenant ce mot
     /// Structure principale de notre indexe
-    std::vector<vec_elt> word_dictionnary;
+    Dictionary<T> word_dictionnary;
 
     /// Structure temporaire pour garder les patterns et leurs indexs
-    std::map<std::string, std::set<T> > temp_pattern_map;
-    std::vector<vec_elt> pattern_dictionnary;
+    /// The patterns have at most 2 bytes, they are stored as (first byte << 8) | second byte, 0 if none,
+    /// which keeps the order of the strings
+    std::vector<std::pair<uint16_t, T>> temp_pattern_postings;
+    Dictionary<T> pattern_dictionnary;
+
+    /// Structure pour garder les informations comme nombre des mots, la distance des mots...dans chaque Autocomplete, indexée par la position
+    std::vector<word_quality> word_quality_list;
+
+    /// Les positions triées par score, puis par nombre de mots
+    /// The posting lists store the ranks instead of the positions, so the best elements of a list are read first
+    std::vector<T> rank_to_idx;
+    std::vector<T> idx_to_rank;
 
-    /// Structure pour garder les informations comme nombre des mots, la distance des mots...dans chaque Autocomplete (Position)
-    std::map<T, word_quality> word_quality_list;
+    /// Rangs des éléments de chaque admin : the ranks of the elements of the admin a are
+    /// admin_elements[admin_offsets[a], admin_offsets[a + 1]), sorted
+    std::vector<uint32_t> admin_offsets;
+    std::vector<T> admin_elements;
 
     template<class Archive> void serialize(Archive & ar, const unsigned int) {
-        ar & word_dictionnary & word_quality_list &pattern_dictionnary &object_type;
+        ar & word_dictionnary & word_quality_list &pattern_dictionnary &object_type & rank_to_idx & idx_to_rank
+           & admin_offsets & admin_elements;
     }
 
     /// Efface les structures de données sérialisées
     void clear() {
-        temp_word_map.clear();
+        temp_word_ids.clear();
+        temp_word_postings.clear();
         word_dictionnary.clear();
-        temp_pattern_map.clear();
+        temp_pattern_postings.clear();
         pattern_dictionnary.clear();
         word_quality_list.clear();
+        rank_to_idx.clear();
+        idx_to_rank.clear();
+        admin_offsets.clear();
+        admin_elements.clear();
     }
 
     // Méthodes permettant de construire l'indexe
@@ -137,43 +148,66 @@ struct Autocomplete
       * – on découpe en mots la chaîne (tokens)
       * — on rajoute la position à la liste de chaque mot
       */
-    void add_string(std::string str, T position,
-                    const autocomplete_map& synonyms){
+    void add_string(const std::string& str, T position,
+                    const SynonymAutomaton& synonyms){
         word_quality wc;
         int distance = 0;
 
         //Appeler la méthode pour traiter les synonymes avant de les ajouter dans le dictionaire:
-        auto vec_word = tokenize(str, synonyms);
+        thread_local Tokens vec_word;
+        synonyms.tokenize(str, vec_word);
+        vec_word.sort_unique();
 
-        //créer des patterns pour chaque mot et les ajouter dans temp_pattern_map:
+        //créer des patterns pour chaque mot et les ajouter dans temp_pattern_postings:
         add_vec_pattern(vec_word, position);
 
         int count = vec_word.size();
-        auto vec = vec_word.begin();
-        while(vec != vec_word.end()){
-            temp_word_map[*vec].insert(position);
-            distance += (*vec).size();
-            ++vec;
+        for (const auto& word: vec_word) {
+            auto it = temp_word_ids.find(word);
+            if (it == temp_word_ids.end()) {
+                it = temp_word_ids.emplace(word, uint32_t(temp_word_ids.size())).first;
+            }
+            temp_word_postings.emplace_back(it->second, position);
+            distance += word.size();
         }
         wc.word_count = count;
         wc.word_distance = distance;
         wc.score = 0;
+        if (word_quality_list.size() <= size_t(position)) {
+            word_quality_list.resize(size_t(position) + 1);
+        }
         word_quality_list[position] = wc;
     }
 
-    void add_vec_pattern(const std::set<std::string> &vec_words, T position){
-        //Créer les patterns:
-        std::vector<std::string> vec_patt = make_vec_pattern(vec_words, 2);
-        auto v_patt = vec_patt.begin();
-        while(v_patt != vec_patt.end()){
-            temp_pattern_map[*v_patt].insert(position);
-            ++v_patt;
+    /// Créer les 2-grams de chaque mot, sans passer par des strings
+    template<class Words>
+    void add_vec_pattern(const Words& vec_words, T position){
+        for (const std::string& word: vec_words) {
+            if (word.empty()) { continue; }
+            if (word.length() <= 2) {
+                temp_pattern_postings.emplace_back(pattern_key(word[0], word.length() > 1 ? word[1] : 0), position);
+                continue;
+            }
+            for (size_t i = 0; i + 2 <= word.length(); ++i) {
+                temp_pattern_postings.emplace_back(pattern_key(word[i], word[i + 1]), position);
+            }
         }
     }
 
+    static uint16_t pattern_key(char first, char second) {
+        return uint16_t((static_cast<unsigned char>(first) << 8) | static_cast<unsigned char>(second));
+    }
+
+    static std::string pattern_string(uint16_t key) {
+        std::string pattern(1, char(key >> 8));
+        if (key & 0xFF) { pattern.push_back(char(key & 0xFF)); }
+        return pattern;
+    }
+
     // Example of 2-gram : bateau :> ba, at, te, ea, au
     // Example of 3-gram : bateau :> bat, ate, tea, eau
-    std::vector<std::string> make_vec_pattern(const std::set<std::string> &vec_words, size_t n_gram) const{
+    template<class Words>
+    std::vector<std::string> make_vec_pattern(const Words& vec_words, size_t n_gram) const{
         std::vector<std::string> pattern;
         auto vec = vec_words.begin();
         while(vec != vec_words.end()){
@@ -198,218 +232,548 @@ struct Autocomplete
       * Les map et les set sont bien pratiques, mais leurs performances sont mauvaises avec des petites données (comme des ints)
       */
     void build(){
-        word_dictionnary.reserve(temp_word_map.size());
-        for(auto key_val: temp_word_map){
-            word_dictionnary.push_back(std::make_pair(key_val.first, std::vector<T>(key_val.second.begin(), key_val.second.end())));
-        }
+        compute_ranks();
+
+        // the words are renumbered in the alphabetical order, so that sorting the postings sorts the words
+        std::vector<const std::string*> words(temp_word_ids.size());
+        for (const auto& word_id: temp_word_ids) { words[word_id.second] = &word_id.first; }
+        std::vector<uint32_t> sorted_ids(words.size());
+        std::iota(sorted_ids.begin(), sorted_ids.end(), uint32_t(0));
+        std::sort(sorted_ids.begin(), sorted_ids.end(), [&](uint32_t a, uint32_t b) { return *words[a] < *words[b]; });
+        std::vector<uint32_t> word_order(words.size());
+        for (size_t i = 0; i < sorted_ids.size(); ++i) { word_order[sorted_ids[i]] = uint32_t(i); }
+        for (auto& posting: temp_word_postings) { posting.first = word_order[posting.first]; }
+
+        word_dictionnary.clear();
+        fill_dictionary(word_dictionnary, temp_word_postings,
+                        [&](uint32_t word) -> const std::string& { return *words[sorted_ids[word]]; });
+        std::vector<std::pair<uint32_t, T>>().swap(temp_word_postings);
+        std::unordered_map<std::string, uint32_t>().swap(temp_word_ids);
 
         //Dictionnaire des patterns:
-        pattern_dictionnary.reserve((temp_pattern_map.size()));
-        for(auto key_val:temp_pattern_map){
-            pattern_dictionnary.push_back(std::make_pair(key_val.first, std::vector<T>(key_val.second.begin(), key_val.second.end())));
+        pattern_dictionnary.clear();
+        fill_dictionary(pattern_dictionnary, temp_pattern_postings, pattern_string);
+        std::vector<std::pair<uint16_t, T>>().swap(temp_pattern_postings);
+    }
+
+    /// Remplit dictionary avec les (key, position) : the positions are changed in ranks and the postings sorted,
+    /// so each key is a run of sorted ranks
+    template<class Key, class KeyString>
+    void fill_dictionary(Dictionary<T>& dictionary, std::vector<std::pair<Key, T>>& postings,
+                         KeyString key_string) const {
+        for (auto& posting: postings) { posting.second = idx_to_rank[posting.second]; }
+        std::sort(postings.begin(), postings.end());
+        postings.erase(std::unique(postings.begin(), postings.end()), postings.end());
+        std::vector<T> ranks;
+        for (auto it = postings.begin(); it != postings.end();) {
+            const Key key = it->first;
+            ranks.clear();
+            for (; it != postings.end() && it->first == key; ++it) { ranks.push_back(it->second); }
+            dictionary.push_back(key_string(key), ranks);
         }
+        dictionary.finalize();
     }
 
-    //Méthode pour calculer le score de chaque élément par son admin.
-    void compute_score(type::PT_Data &pt_data, georef::GeoRef &georef,
-                       const type::Type_e type);
-    // Méthodes premettant de retrouver nos éléments
-    /** Définit un fonctor permettant de parcourir notre structure un peu particulière */
-    struct comp{
-        /** Utilisé pour trouver la borne inf. Quand on cherche av, on veux que avenue soit également trouvé
-          * Il faut donc que "av" < "avenue" soit false
-          */
-        bool operator()(const std::string & a, const std::pair<std::string, std::vector<T> > & b){
-            if(b.first.find(a) == 0) return false;
-            return (a < b.first);
+    /// Trie les positions par score décroissant, puis par nombre de mots croissant (the shortest names match
+    /// the query the best), then by position to be stable
+    void compute_ranks() {
+        rank_to_idx.resize(word_quality_list.size());
+        std::iota(rank_to_idx.begin(), rank_to_idx.end(), T(0));
+        std::sort(rank_to_idx.begin(), rank_to_idx.end(), [&](T a, T b) {
+            const word_quality& qa = word_quality_list[a];
+            const word_quality& qb = word_quality_list[b];
+            if (qa.score != qb.score) { return qa.score > qb.score; }
+            if (qa.word_count != qb.word_count) { return qa.word_count < qb.word_count; }
+            return a < b;
+        });
+        idx_to_rank.resize(rank_to_idx.size());
+        for (size_t rank = 0; rank < rank_to_idx.size(); ++rank) {
+            idx_to_rank[rank_to_idx[rank]] = T(rank);
         }
+    }
 
-        /** Utilisé pour la borne sup. Ici rien d'extraordinaire */
-        bool operator()(const std::pair<std::string, std::vector<T> > & b, const std::string & a){
-            return (b.first < a);
+    /// À appeler une fois les scores calculés : the posting lists are sorted again by the new ranks
+    void rank_by_score() {
+        const std::vector<T> old_rank_to_idx = rank_to_idx;
+        compute_ranks();
+        std::vector<T> new_ranks(old_rank_to_idx.size());
+        for (size_t rank = 0; rank < old_rank_to_idx.size(); ++rank) {
+            new_ranks[rank] = idx_to_rank[old_rank_to_idx[rank]];
         }
-    };
+        word_dictionnary = word_dictionnary.remap(new_ranks);
+        pattern_dictionnary = pattern_dictionnary.remap(new_ranks);
+        for (T& rank: admin_elements) { rank = new_ranks[rank]; }
+        for (size_t admin = 0; admin + 1 < admin_offsets.size(); ++admin) {
+            std::sort(admin_elements.begin() + admin_offsets[admin], admin_elements.begin() + admin_offsets[admin + 1]);
+        }
+    }
 
-    /** Retrouve toutes les positions des élements contenant le mot des mots qui commencent par token */
-    std::vector<T> match(const std::string &token, const std::vector<vec_elt> &vec_source) const {
-        // Les éléments dans vec_map sont triés par ordre alphabétiques, il suffit donc de trouver la borne inf et sup
-        auto lower = std::lower_bound(vec_source.begin(), vec_source.end(), token, comp());
-        auto upper = std::upper_bound(vec_source.begin(), vec_source.end(), token, comp());
+    /** Construit la liste des rangs des éléments de chaque admin, à appeler après build
+      *
+      * objects are the indexed objects (having an admin_list), by position
+      */
+    template<typename Object>
+    void build_admin_index(const std::vector<Object*>& objects, size_t nb_admins) {
+        std::vector<std::pair<type::idx_t, T>> admin_ranks;
+        for (size_t idx = 0; idx < word_quality_list.size() && idx < objects.size(); ++idx) {
+            // the objects without words are not in the dictionnary
+            if (word_quality_list[idx].word_count == 0) { continue; }
+            for (const auto* admin: objects[idx]->admin_list) {
+                if (admin->idx >= nb_admins) { continue; }
+                admin_ranks.push_back({admin->idx, idx_to_rank[idx]});
+            }
+        }
+        std::sort(admin_ranks.begin(), admin_ranks.end());
+        admin_ranks.erase(std::unique(admin_ranks.begin(), admin_ranks.end()), admin_ranks.end());
+
+        admin_offsets.assign(nb_admins + 1, 0);
+        admin_elements.clear();
+        admin_elements.reserve(admin_ranks.size());
+        for (const auto& admin_rank: admin_ranks) {
+            ++admin_offsets[admin_rank.first + 1];
+            admin_elements.push_back(admin_rank.second);
+        }
+        for (size_t admin = 0; admin < nb_admins; ++admin) {
+            admin_offsets[admin + 1] += admin_offsets[admin];
+        }
+    }
 
+    /// rangs triés des éléments d'au moins un des admins
+    std::vector<T> ranks_in_admins(const std::vector<type::idx_t>& admins) const {
         std::vector<T> result;
-
-        // On concatène tous les indexes
-        // Pour les raisons de perfs mesurées expérimentalement, on accepte des doublons
-        for(; lower != upper; ++lower){
-            std::vector<T> other = lower->second;
-            result.insert(result.end(), other.begin(), other.end());
+        for (const type::idx_t admin: admins) {
+            if (admin + 1 >= admin_offsets.size()) { continue; }
+            result.insert(result.end(), admin_elements.begin() + admin_offsets[admin],
+                          admin_elements.begin() + admin_offsets[admin + 1]);
+        }
+        if (admins.size() > 1) {
+            std::sort(result.begin(), result.end());
+            result.erase(std::unique(result.begin(), result.end()), result.end());
         }
         return result;
     }
 
-    /** On passe une chaîne de charactère contenant des mots et on trouve toutes les positions contenant tous ces mots*/
-    std::vector<T> find(std::set<std::string> vecStr) const {
-        std::vector<T> result;
-        auto vec = vecStr.begin();
-        if(vec != vecStr.end()){
-            // Premier résultat. Il y aura au plus ces indexes
-            result = match(*vec, word_dictionnary);
-
-            for(++vec; vec != vecStr.end(); ++vec){
-                std::vector<T> new_result;
-                std::sort(result.begin(), result.end());
-                for(auto i : match(*vec, word_dictionnary)){
-                    // Binary search fait une recherche dichotomique pour savoir si l'élément i existe
-                    // S'il existe dans les deux cas, on le garde
-                    if(binary_search(result.begin(), result.end(), i)){
-                        new_result.push_back(i);
-                    }
-                }
-                //The function "unique" works only if the vector new_result is sorted.
-                std::sort(new_result.begin(), new_result.end());
+    /// Keep in elements (sorted by rank) only the ones whose rank is in filter (sorted)
+    template<typename Elt, typename RankOf>
+    static void keep_ranks(std::vector<Elt>& elements, const std::vector<T>& filter, RankOf rank_of) {
+        size_t pos = 0;
+        size_t nb_kept = 0;
+        for (const auto& elt: elements) {
+            pos = gallop(filter, pos, rank_of(elt));
+            if (pos == filter.size()) { break; }
+            if (filter[pos] == rank_of(elt)) { elements[nb_kept++] = elt; }
+        }
+        elements.resize(nb_kept);
+    }
 
-                // std::unique retrie les donnée et fout les doublons à la fin
-                // La fonction retourne un itérateur vers le premier doublon
-                // Expérimentalement le gain est très faible
-                result.assign(new_result.begin(), std::unique(new_result.begin(), new_result.end()));
-            }
+    //Méthode pour calculer le score de chaque élément par son admin, puis trier les listes par score.
+    void compute_score(type::PT_Data &pt_data, georef::GeoRef &georef,
+                       const type::Type_e type);
+    // Méthodes premettant de retrouver nos éléments
+    /** Retrouve tous les rangs (triés et sans doublon) des élements contenant un des mots de range */
+    std::vector<T> match(std::pair<uint32_t, uint32_t> range, const Dictionary<T> &dict) const {
+        std::vector<T> result;
+        dict.for_each_posting(range, [&](T idx) { result.push_back(idx); });
+        // each posting list is sorted, we only have to merge them if there are several words
+        if (range.second - range.first > 1) {
+            std::sort(result.begin(), result.end());
+            result.erase(std::unique(result.begin(), result.end()), result.end());
         }
         return result;
     }
 
-    /** Définit un fonctor permettant de parcourir notqualityre structure un peu particulière : trier par la valeur "nb_found"*/
-    /** associé au valeur du vector<T> */
-    struct Compare{
-        const std::unordered_map<T, fl_quality>  & fl_result;// Pointeur au fl_result
-        Compare(const std::unordered_map<T, fl_quality>  & fl_result) : fl_result(fl_result) {} //initialisation
+    /** Retrouve tous les rangs des élements contenant le mot des mots qui commencent par token */
+    std::vector<T> match(const std::string &token, const Dictionary<T> &dict) const {
+        return match(dict.prefix_range(token), dict);
+    }
 
-        bool operator()(T a, T b) const{
-            return fl_result.at(a).nb_found > fl_result.at(b).nb_found;
+    /// first position of result not lower than value, searched from the position from
+    static size_t gallop(const std::vector<T>& result, size_t from, T value) {
+        if (from >= result.size() || result[from] >= value) { return from; }
+        // exponential search, then binary search in the last step
+        size_t step = 1;
+        while (from + step < result.size() && result[from + step] < value) {
+            from += step;
+            step *= 2;
         }
-    };
+        const auto end = result.begin() + std::min(from + step + 1, result.size());
+        return std::lower_bound(result.begin() + from + 1, end, value) - result.begin();
+    }
+
+    /** Keep in result (sorted) only the elements containing one of the words of range */
+    void intersect(std::vector<T>& result, std::pair<uint32_t, uint32_t> range) const {
+        std::vector<char> found(result.size(), false);
+        for (uint32_t word = range.first; word < range.second; ++word) {
+            // for a frequent word, testing each element of result is cheaper than reading the list
+            const uint64_t* bitmap = word_dictionnary.bitmap(word);
+            if (bitmap && result.size() < word_dictionnary.nb_bytes({word, word + 1})) {
+                for (size_t i = 0; i < result.size(); ++i) {
+                    if (word_dictionnary.bitmap_contains(bitmap, result[i])) { found[i] = true; }
+                }
+                continue;
+            }
+            // the posting list is sorted, so we gallop in result from the last position found
+            size_t pos = 0;
+            word_dictionnary.for_each_posting_while(word, [&](T idx) {
+                pos = gallop(result, pos, idx);
+                if (pos == result.size()) { return false; }
+                if (result[pos] == idx) { found[pos] = true; }
+                return true;
+            });
+        }
+        size_t nb_kept = 0;
+        for (size_t i = 0; i < result.size(); ++i) {
+            if (found[i]) { result[nb_kept++] = result[i]; }
+        }
+        result.resize(nb_kept);
+    }
 
-    /** Définit un fonctor permettant de parcourir notre structure un peu particulière : trier par la valeur "nb_found"*/
-    /** associé au valeur du vector<T> */
-    struct compare_by_quality{
-        const std::unordered_map<T, fl_quality> & fl_result;
-        compare_by_quality(const std::unordered_map<T, fl_quality>  & fl_result) : fl_result(fl_result) {} //initialisation
+    /** On passe une chaîne de charactère contenant des mots et on trouve toutes les positions contenant tous ces mots
+      *
+      * The result is sorted and without duplicates.
+      */
+    std::vector<T> find(std::set<std::string> vecStr) const {
+        std::vector<T> result = find_ranks(vecStr);
+        for (T& elt: result) { elt = rank_to_idx[elt]; }
+        std::sort(result.begin(), result.end());
+        return result;
+    }
 
-        bool operator()(T a, T b) const{
-            return fl_result.at(a).quality > fl_result.at(b).quality;
+    /** Rangs (triés et sans doublon) des éléments contenant tous les mots
+      *
+      * The words are intersected from the one with the fewest elements, so the result stays small.
+      */
+    template<class Words>
+    std::vector<T> find_ranks(const Words& vecStr, const std::vector<T>* admin_ranks = nullptr) const {
+        std::vector<std::pair<uint32_t, uint32_t>> ranges;
+        for (const auto& token: vecStr) {
+            const auto range = word_dictionnary.prefix_range(token);
+            if (range.first == range.second) { return {}; }
+            ranges.push_back(range);
         }
-    };
+        if (ranges.empty()) { return {}; }
+        std::sort(ranges.begin(), ranges.end(), [&](std::pair<uint32_t, uint32_t> a, std::pair<uint32_t, uint32_t> b) {
+            return word_dictionnary.nb_bytes(a) < word_dictionnary.nb_bytes(b);
+        });
+
+        std::vector<T> result = match(ranges.front(), word_dictionnary);
+        if (admin_ranks) {
+            keep_ranks(result, *admin_ranks, [](T rank) { return rank; });
+        }
+        for (auto range = ranges.begin() + 1; range != ranges.end() && ! result.empty(); ++range) {
+            intersect(result, *range);
+        }
+        return result;
+    }
+
+    /** Appelle f sur les positions contenant tous les mots, de la meilleure à la moins bonne, tant que f renvoie true
+      *
+      * For a single word, the posting lists of the words begining with it are merged lazily,
+      * so only the first elements of the lists are read.
+      * If admin_ranks is given, only its elements are kept.
+      */
+    template<class Words, typename F>
+    void for_each_by_rank(const Words& vecStr, F f, const std::vector<T>* admin_ranks = nullptr) const {
+        if (vecStr.size() != 1) {
+            for (const T rank: find_ranks(vecStr, admin_ranks)) {
+                if (! f(rank_to_idx[rank])) { return; }
+            }
+            return;
+        }
+        typedef typename Dictionary<T>::PostingIterator Iterator;
+        const auto greater = [](const Iterator& a, const Iterator& b) { return a.value > b.value; };
+        const auto range = word_dictionnary.prefix_range(*vecStr.begin());
+        std::vector<Iterator> heap;
+        for (uint32_t word = range.first; word < range.second; ++word) {
+            Iterator it(word_dictionnary, word);
+            if (it.valid()) { heap.push_back(it); }
+        }
+        std::make_heap(heap.begin(), heap.end(), greater);
+        bool has_last = false;
+        T last = 0;
+        size_t admin_pos = 0;
+        while (! heap.empty()) {
+            std::pop_heap(heap.begin(), heap.end(), greater);
+            const T rank = heap.back().value;
+            heap.back().next();
+            if (heap.back().valid()) {
+                std::push_heap(heap.begin(), heap.end(), greater);
+            } else {
+                heap.pop_back();
+            }
+            // an element can be in several lists
+            if (has_last && rank == last) { continue; }
+            has_last = true;
+            last = rank;
+            if (admin_ranks) {
+                admin_pos = gallop(*admin_ranks, admin_pos, rank);
+                if (admin_pos == admin_ranks->size()) { return; }
+                if ((*admin_ranks)[admin_pos] != rank) { continue; }
+            }
+            if (! f(rank_to_idx[rank])) { return; }
+        }
+    }
 
     std::vector<fl_quality> sort_and_truncate_by_score(std::vector<fl_quality> input, size_t nbmax) const {
-        sort_and_truncate(input, nbmax, [](fl_quality a, fl_quality b){return a.score > b.score;});
+        // the ties are sorted by idx to have a stable result
+        sort_and_truncate(input, nbmax, [](const fl_quality& a, const fl_quality& b){
+            return a.score > b.score || (a.score == b.score && a.idx < b.idx);
+        });
         return input;
     }
 
     std::vector<fl_quality> sort_and_truncate_by_quality(std::vector<fl_quality> input, size_t nbmax) const {
-        sort_and_truncate(input, nbmax, [](fl_quality a, fl_quality b){return a.quality > b.quality;});
+        // the ties are sorted by rank to have a stable result
+        sort_and_truncate(input, nbmax, [&](const fl_quality& a, const fl_quality& b){
+            return a.quality > b.quality || (a.quality == b.quality && idx_to_rank[a.idx] < idx_to_rank[b.idx]);
+        });
         return input;
     }
 
-    /** On passe une chaîne de charactère contenant des mots et on trouve toutes les positions contenant au moins un des mots*/
+    /** On passe une chaîne de charactère contenant des mots et on trouve les nbmax meilleures positions contenant tous les mots
+      *
+      * The elements are read by rank, so we stop as soon as nbmax of them are kept.
+      * If admin_ranks is given (see ranks_in_admins), only its elements are searched.
+      */
     std::vector<fl_quality> find_complete(const std::string & str,
-                                          const autocomplete_map& synonyms,
+                                          const SynonymAutomaton& synonyms,
                                           size_t nbmax,
-                                          std::function<bool(T)> keep_element)
+                                          std::function<bool(T)> keep_element,
+                                          const std::vector<T>* admin_ranks = nullptr)
                                           const{
-        auto vec = tokenize(str, synonyms);
-        int wordLength = 0;
-        fl_quality quality;
-        std::vector<T> index_result;
-        //Vector des ObjetTC index trouvés
-        index_result = find(vec);
-        wordLength = words_length(vec);
+        const auto& vec = tokenize(str, synonyms);
+        const int wordLength = words_length(vec);
 
         // Créer un vector de réponse:
         std::vector<fl_quality> vec_quality;
+        if (nbmax == 0) { return vec_quality; }
 
-        for(auto i : index_result){
-            if(keep_element(i)) {
-                quality.idx = i;
-                quality.nb_found = word_quality_list.at(quality.idx).word_count;
+        for_each_by_rank(vec, [&](T idx) {
+            if(keep_element(idx)) {
+                fl_quality quality;
+                quality.idx = idx;
+                quality.nb_found = word_quality_list[idx].word_count;
                 quality.word_len = wordLength;
-                quality.score = word_quality_list.at(quality.idx).score;
+                quality.score = word_quality_list[idx].score;
                 quality.quality = 100;
                 vec_quality.push_back(quality);
             }
-        }
-        return sort_and_truncate_by_score(vec_quality, nbmax);
+            return vec_quality.size() < nbmax;
+        }, admin_ranks);
+        return vec_quality;
     }
 
 
-    /** Recherche des patterns les plus proche : faute de frappe */
+    /** Recherche des patterns les plus proche : faute de frappe
+      *
+      * An object is kept if it is found by at least 75% of the patterns. Like in MaxScore, only the
+      * smallest posting lists, the ones an object can not miss all, give the candidates; the other
+      * lists are only used to count the patterns found by the candidates.
+      */
     std::vector<fl_quality> find_partial_with_pattern(const std::string &str,
-                                                      const autocomplete_map& synonyms, const int word_weight,
+                                                      const SynonymAutomaton& synonyms, const int word_weight,
                                                       size_t nbmax,
-                                                      std::function<bool(T)> keep_element)
+                                                      std::function<bool(T)> keep_element,
+                                                      const std::vector<T>* admin_ranks = nullptr)
                                                       const{
-        //Map temporaire pour garder les patterns trouvé:
-        std::unordered_map<T, fl_quality> fl_result;
-
-        //Vector temporaire des indexs
-        std::vector<T> index_result;
-
         //Créer un vector de réponse
         std::vector<fl_quality> vec_quality;
-        fl_quality quality;
 
-        auto vec_word = tokenize(str, synonyms);
+        const auto& vec_word = tokenize(str, synonyms);
         std::vector<std::string> vec_pattern = make_vec_pattern(vec_word, 2); //2-grams
         int wordLength = words_length(vec_word);
         int pattern_count = vec_pattern.size();
+        if (pattern_count == 0 || nbmax == 0) { return vec_quality; }
 
-        //recherche pour le premier pattern:
-        auto vec = vec_pattern.begin();
-        if (vec != vec_pattern.end()){
-            //Premier résultat:
-            index_result = match(*vec, pattern_dictionnary);
+        std::vector<std::pair<uint32_t, uint32_t>> ranges;
+        for (const auto& pattern: vec_pattern) {
+            ranges.push_back(pattern_dictionnary.prefix_range(pattern));
+        }
 
-            //Incrémenter la propriété "nb_found" pour chaque index des mots autocomplete dans vec_map
-            add_word_quality(fl_result,index_result);
+        //Compute de highest score of objects found by the last pattern:
+        //the lists being sorted by score, it is the first object kept of each list
+        int max_score = 0;
+        for (uint32_t word = ranges.back().first; word < ranges.back().second; ++word) {
+            size_t admin_pos = 0;
+            pattern_dictionnary.for_each_posting_while(word, [&](T rank) {
+                if (admin_ranks) {
+                    admin_pos = gallop(*admin_ranks, admin_pos, rank);
+                    if (admin_pos == admin_ranks->size()) { return false; }
+                    if ((*admin_ranks)[admin_pos] != rank) { return true; }
+                }
+                const T idx = rank_to_idx[rank];
+                if (! keep_element(idx)) { return true; }
+                max_score = std::max(max_score, word_quality_list[idx].score);
+                return false;
+            });
+        }
 
-            //Recherche des mots qui restent
-            for (++vec; vec != vec_pattern.end(); ++vec){
-                index_result = match(*vec, pattern_dictionnary);
+        //Here we keep object with match of patternized words >= 75%
+        int max_missing = 0;
+        while (max_missing < pattern_count && ((max_missing + 1) * 100) / pattern_count <= 25) {
+            ++max_missing;
+        }
+        const int min_found = pattern_count - max_missing;
+
+        //Each word of a range adds 1 to "nb_found", so a candidate found by none of the smallest lists
+        //can only get the number of words of the other ranges
+        std::sort(ranges.begin(), ranges.end(), [&](std::pair<uint32_t, uint32_t> a, std::pair<uint32_t, uint32_t> b) {
+            return pattern_dictionnary.nb_bytes(a) < pattern_dictionnary.nb_bytes(b);
+        });
+        size_t nb_candidate_lists = ranges.size();
+        int others_max_found = 0;
+        while (nb_candidate_lists > 0) {
+            const auto& range = ranges[nb_candidate_lists - 1];
+            const int nb_words = range.second - range.first;
+            if (others_max_found + nb_words >= min_found) { break; }
+            others_max_found += nb_words;
+            --nb_candidate_lists;
+        }
 
-                //For each match of n-gram pattern word 1 is added to "nb_found"
-                add_word_quality(fl_result,index_result);
+        //candidates (rank, nb_found), sorted by rank
+        std::vector<std::pair<T, int>> candidates;
+        for (size_t i = 0; i < nb_candidate_lists; ++i) {
+            pattern_dictionnary.for_each_posting(ranges[i], [&](T rank) { candidates.push_back({rank, 1}); });
+        }
+        std::sort(candidates.begin(), candidates.end());
+        size_t nb_candidates = 0;
+        for (const auto& candidate: candidates) {
+            if (nb_candidates > 0 && candidates[nb_candidates - 1].first == candidate.first) {
+                ++candidates[nb_candidates - 1].second;
+            } else {
+                candidates[nb_candidates++] = candidate;
             }
+        }
+        candidates.resize(nb_candidates);
+        if (admin_ranks) {
+            keep_ranks(candidates, *admin_ranks, [](const std::pair<T, int>& candidate) { return candidate.first; });
+        }
+        for (size_t i = nb_candidate_lists; i < ranges.size() && ! candidates.empty(); ++i) {
+            add_word_quality(candidates, ranges[i]);
+        }
 
-            //Compute de highest score of objects found
-            int max_score = 0;
-            for (auto ir : index_result){
-                if (keep_element(ir)){
-                    max_score = word_quality_list.at(ir).score > max_score ? word_quality_list.at(ir).score : max_score;
-                }
+        for (const auto& candidate: candidates) {
+            const T idx = rank_to_idx[candidate.first];
+            if (candidate.second >= min_found && keep_element(idx)) {
+                fl_quality quality;
+                quality.idx = idx;
+                quality.nb_found = candidate.second;
+                quality.word_len = wordLength;
+                quality.score = word_quality_list[idx].score;
+                quality.quality = calc_quality_pattern(quality, word_weight, max_score, pattern_count);
+                vec_quality.push_back(quality);
             }
+        }
+        return sort_and_truncate_by_quality(vec_quality, nbmax);
+    }
+
 
-            //Here we keep object with match of patternized words >= 75%
-            for(auto pair : fl_result){
-                if (keep_element(pair.first) && (((pattern_count - pair.second.nb_found) * 100) / pattern_count <= 25)){
-                    quality.idx = pair.first;
-                    quality.nb_found = pair.second.nb_found;
-                    quality.word_len = wordLength;
-                    quality.score = word_quality_list.at(quality.idx).score;
-                    quality.quality = calc_quality_pattern(quality, word_weight, max_score, pattern_count);
-                    vec_quality.push_back(quality);
+    /** Recherche tolérante aux fautes de frappe : chaque mot de la recherche doit être à une distance d'édition
+      * d'au plus max_distance du début d'un mot de l'objet (1 for the short words, 0 for the very short ones)
+      *
+      * The objects are sorted by the sum of the distances of the words, then by rank.
+      */
+    std::vector<fl_quality> find_fuzzy(const std::string &str,
+                                       const SynonymAutomaton& synonyms, const int word_weight,
+                                       size_t nbmax,
+                                       std::function<bool(T)> keep_element,
+                                       const std::vector<T>* admin_ranks = nullptr,
+                                       uint32_t max_distance = 2)
+                                       const{
+        std::vector<fl_quality> vec_quality;
+        const auto& vec_word = tokenize(str, synonyms);
+        if (vec_word.empty() || nbmax == 0) { return vec_quality; }
+        const int wordLength = words_length(vec_word);
+
+        //(rank, distance), sorted by rank
+        std::vector<std::pair<T, uint32_t>> result;
+        bool first_word = true;
+        for (const auto& token: vec_word) {
+            std::vector<std::pair<T, uint32_t>> token_result;
+            word_dictionnary.for_each_fuzzy_word(token, allowed_distance(token, max_distance),
+                                                 [&](uint32_t word, uint32_t distance) {
+                word_dictionnary.for_each_posting(word, [&](T rank) { token_result.push_back({rank, distance}); });
+            });
+            //an object only keeps the distance of its closest word
+            std::sort(token_result.begin(), token_result.end());
+            token_result.erase(std::unique(token_result.begin(), token_result.end(),
+                                           [](const std::pair<T, uint32_t>& a, const std::pair<T, uint32_t>& b) {
+                                               return a.first == b.first;
+                                           }), token_result.end());
+            if (first_word) {
+                result = std::move(token_result);
+                first_word = false;
+                if (admin_ranks) {
+                    keep_ranks(result, *admin_ranks, [](const std::pair<T, uint32_t>& elt) { return elt.first; });
+                }
+            } else {
+                size_t nb_kept = 0;
+                auto it = token_result.begin();
+                for (const auto& elt: result) {
+                    while (it != token_result.end() && it->first < elt.first) { ++it; }
+                    if (it != token_result.end() && it->first == elt.first) {
+                        result[nb_kept++] = {elt.first, elt.second + it->second};
+                    }
                 }
+                result.resize(nb_kept);
             }
+            if (result.empty()) { return vec_quality; }
         }
-        return sort_and_truncate_by_quality(vec_quality, nbmax);
+
+        std::sort(result.begin(), result.end(), [](const std::pair<T, uint32_t>& a, const std::pair<T, uint32_t>& b) {
+            return a.second < b.second || (a.second == b.second && a.first < b.first);
+        });
+        for (const auto& elt: result) {
+            const T idx = rank_to_idx[elt.first];
+            if (! keep_element(idx)) { continue; }
+            fl_quality quality;
+            quality.idx = idx;
+            quality.nb_found = word_quality_list[idx].word_count;
+            quality.word_len = wordLength;
+            quality.score = word_quality_list[idx].score;
+            quality.quality = 100 - int(elt.second) * word_weight;
+            vec_quality.push_back(quality);
+            if (vec_quality.size() == nbmax) { break; }
+        }
+        return vec_quality;
+    }
+
+    /// the short words can not have as many typos as the long ones
+    static uint32_t allowed_distance(const std::string& token, uint32_t max_distance) {
+        if (token.size() <= 2) { return 0; }
+        if (token.size() <= 5) { return std::min(max_distance, uint32_t(1)); }
+        return max_distance;
     }
 
 
-    /** pour chaque mot trouvé dans la liste des mots il faut incrémenter la propriété : nb_found*/
+    /** pour chaque mot trouvé dans la liste des mots il faut incrémenter la propriété : nb_found des candidats*/
     /** Utilisé que pour une recherche partielle */
-    void add_word_quality(std::unordered_map<T, fl_quality> & fl_result, const std::vector<T> &found) const{
-        for(auto i : found){
-            fl_result[i].nb_found++;
+    void add_word_quality(std::vector<std::pair<T, int>>& candidates, std::pair<uint32_t, uint32_t> found) const{
+        for (uint32_t word = found.first; word < found.second; ++word) {
+            // the posting list is sorted, so we gallop in the candidates from the last position found
+            size_t pos = 0;
+            pattern_dictionnary.for_each_posting_while(word, [&](T rank) {
+                pos = gallop_candidates(candidates, pos, rank);
+                if (pos == candidates.size()) { return false; }
+                if (candidates[pos].first == rank) { ++candidates[pos].second; }
+                return true;
+            });
         }
     }
 
+    /// first position of candidates not lower than rank, searched from the position from
+    static size_t gallop_candidates(const std::vector<std::pair<T, int>>& candidates, size_t from, T rank) {
+        const auto lower = [](const std::pair<T, int>& candidate, T value) { return candidate.first < value; };
+        if (from >= candidates.size() || ! lower(candidates[from], rank)) { return from; }
+        size_t step = 1;
+        while (from + step < candidates.size() && lower(candidates[from + step], rank)) {
+            from += step;
+            step *= 2;
+        }
+        const auto end = candidates.begin() + std::min(from + step + 1, candidates.size());
+        return std::lower_bound(candidates.begin() + from + 1, end, rank, lower) - candidates.begin();
+    }
+
     int calc_quality_pattern(const fl_quality & ql,  int wordweight, int max_score, int patt_count) const {
         int result = 100;
 
@@ -417,14 +781,15 @@ struct Autocomplete
         result -= (patt_count - ql.nb_found) * wordweight;//coeff  WordFound
 
         //Qualité sur la distance globale des mots.
-        result -= abs(word_quality_list.at(ql.idx).word_distance - ql.word_len);//Coeff de la distance = 1
+        result -= abs(word_quality_list[ql.idx].word_distance - ql.word_len);//Coeff de la distance = 1
 
         //Qualité sur le score
-        result -= (max_score - word_quality_list.at(ql.idx).score)/10;
+        result -= (max_score - word_quality_list[ql.idx].score)/10;
         return result;
     }
 
-    int words_length(std::set<std::string> & words) const{
+    template<class Words>
+    int words_length(const Words& words) const{
         int distance = 0;
         auto vec = words.begin();
         while(vec != words.end()){
@@ -434,74 +799,26 @@ struct Autocomplete
         return distance;
     }
 
-    std::string strip_accents(std::string str) const {
-        std::vector< std::pair<std::string, std::string> > vec_str;
-        vec_str.push_back(std::make_pair("à","a"));
-        vec_str.push_back(std::make_pair("À","a"));
-        vec_str.push_back(std::make_pair("â","a"));
-        vec_str.push_back(std::make_pair("Â","a"));
-        vec_str.push_back(std::make_pair("ä","a"));
-        vec_str.push_back(std::make_pair("Ä","a"));
-        vec_str.push_back(std::make_pair("æ","ae"));
-        vec_str.push_back(std::make_pair("é","e"));
-        vec_str.push_back(std::make_pair("É","e"));
-        vec_str.push_back(std::make_pair("è","e"));
-        vec_str.push_back(std::make_pair("È","e"));
-        vec_str.push_back(std::make_pair("ê","e"));
-        vec_str.push_back(std::make_pair("Ê","e"));
-        vec_str.push_back(std::make_pair("ë","e"));
-        vec_str.push_back(std::make_pair("Ë","e"));
-        vec_str.push_back(std::make_pair("ô","o"));
-        vec_str.push_back(std::make_pair("Ô","o"));
-        vec_str.push_back(std::make_pair("ö","o"));
-        vec_str.push_back(std::make_pair("Ö","o"));
-        vec_str.push_back(std::make_pair("û","u"));
-        vec_str.push_back(std::make_pair("Û","u"));
-        vec_str.push_back(std::make_pair("ù","u"));
-        vec_str.push_back(std::make_pair("Ù","u"));
-        vec_str.push_back(std::make_pair("ü","u"));
-        vec_str.push_back(std::make_pair("Ü","u"));
-        vec_str.push_back(std::make_pair("ç","c"));
-        vec_str.push_back(std::make_pair("Ç","c"));
-        vec_str.push_back(std::make_pair("ï","i"));
-        vec_str.push_back(std::make_pair("Ï","i"));
-        vec_str.push_back(std::make_pair("î","i"));
-        vec_str.push_back(std::make_pair("Î","i"));
-        vec_str.push_back(std::make_pair("œ","oe"));
-
-        auto vec = vec_str.begin();
-        while(vec != vec_str.end()){
-            boost::algorithm::replace_all(str, vec->first, vec->second);
-            ++vec;
-        }
-        return str;
+    std::string strip_accents(const std::string& str) const {
+        return navitia::autocomplete::strip_accents(str);
     }
 
-    std::set<std::string> tokenize(std::string strFind, const autocomplete_map& synonyms) const{
-        std::set<std::string> vec;
-        boost::to_lower(strFind);
-        strFind = boost::regex_replace(strFind, boost::regex("( ){2,}"), " ");
-
-        //traiter les caractères accentués
-        strFind = strip_accents(strFind);
-
-       for(const auto& it : synonyms){
-            strFind = boost::regex_replace(strFind,boost::regex("\\<" + it.first + "\\>"), it.second);
-        }
-
-        boost::tokenizer <> tokens(strFind);
-        for (auto token_it: tokens){
-            if (!token_it.empty()){
-                vec.insert(token_it);
-            }
-        }
-        return vec;
+    /** Mots (triés et sans doublon) de str, les synonymes remplacés
+      *
+      * The words are in a buffer of the thread, reused by the next call of the thread:
+      * they must be read before tokenizing another string.
+      */
+    const Tokens& tokenize(const std::string& str, const SynonymAutomaton& synonyms) const{
+        thread_local Tokens tokens;
+        synonyms.tokenize(str, tokens);
+        tokens.sort_unique();
+        return tokens;
     }
 
     bool is_address_type(const std::string & str,
-                         const autocomplete_map& synonyms) const{
+                         const SynonymAutomaton& synonyms) const{
         bool result = false;
-        auto vec_token = tokenize(str, synonyms);
+        const auto& vec_token = tokenize(str, synonyms);
         std::vector<std::string> vecTpye = {"rue", "avenue", "place", "boulevard","chemin", "impasse"};
         auto vtok = vec_token.begin();
         while(vtok != vec_token.end() && (result == false)){
@@ -520,4 +837,11 @@ struct Autocomplete
     }
 };
 
+/** Lance les constructions d'indexes en parallèle, one thread by build
+  *
+  * The builds must not share anything they write. The first exception thrown by a build is rethrown once
+  * all the running builds are over, the builds not started yet are skipped.
+  */
+void build_in_parallel(const std::vector<std::function<void()>>& builds);
+
 }} // namespace navitia::autocomplete
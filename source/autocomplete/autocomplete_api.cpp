@@ -147,38 +147,6 @@ static int get_embedded_type_order(pbnavitia::NavitiaType type){
     }
 }
 
-template<class T>
-struct ValidAdminPtr {
-    const std::vector<T*>& objects;
-    const std::vector<const georef::Admin*> required_admins;
-
-    ValidAdminPtr(const std::vector<T*> & objects,
-            const std::vector<const georef::Admin*> required_admins) :
-                objects(objects), required_admins(required_admins) {}
-
-    bool operator()(type::idx_t idx) const {
-        const T* object = objects[idx];
-        if (required_admins.empty()){
-            return true;
-        }
-
-        for(const georef::Admin* admin : required_admins) {
-            const auto & admin_list = object->admin_list;
-            if(std::find(admin_list.begin(), admin_list.end(), admin) != admin_list.end())
-                return true;
-        }
-
-        return false;
-    }
-};
-
-template<class T>
-ValidAdminPtr<T> valid_admin_ptr (const std::vector<T*> & objects,
-        const std::vector<const georef::Admin*>& required_admins)  {
-    return ValidAdminPtr<T>(objects, required_admins);
-}
-
-
 static std::vector<const georef::Admin*>
 admin_uris_to_admin_ptr(const std::vector<std::string>& admin_uris,
                         const nt::Data& d){
@@ -204,6 +172,34 @@ static void update_quality(std::vector<Autocomplete<nt::idx_t>::fl_quality>& ac_
 }
 
 
+/// search_type : 0 the words of the objects begin with the words of q, 1 the 2-grams of q are searched,
+/// 2 the words of q can have typos
+/// If admins is not empty, only the objects of one of these admins are searched
+static std::vector<Autocomplete<nt::idx_t>::fl_quality>
+find_autocomplete(const Autocomplete<nt::idx_t>& ac,
+                  const std::string &q,
+                  int nbmax,
+                  int search_type,
+                  const navitia::type::Data &d,
+                  const std::vector<nt::idx_t>& admins) {
+    const auto keep_element = [](nt::idx_t){return true;};
+    std::vector<nt::idx_t> admin_ranks;
+    if (! admins.empty()) {
+        admin_ranks = ac.ranks_in_admins(admins);
+    }
+    const std::vector<nt::idx_t>* filter = admins.empty() ? nullptr : &admin_ranks;
+    switch (search_type) {
+    case 0:
+        return ac.find_complete(q, d.geo_ref->synonym_automaton, nbmax, keep_element, filter);
+    case 2:
+        return ac.find_fuzzy(q, d.geo_ref->synonym_automaton, d.geo_ref->word_weight, nbmax, keep_element, filter);
+    default:
+        return ac.find_partial_with_pattern(q, d.geo_ref->synonym_automaton, d.geo_ref->word_weight, nbmax, keep_element,
+                                            filter);
+    }
+}
+
+
 pbnavitia::Response autocomplete(const std::string &q,
                                  const std::vector<nt::Type_e> &filter,
                                  uint32_t depth,
@@ -223,110 +219,51 @@ pbnavitia::Response autocomplete(const std::string &q,
     //unwanted objects.
     nbmax = nbmax * 3;
     //bool addType = d.pt_data->stop_area_autocomplete.is_address_type(q, d.geo_ref->synonyms);
-    std::vector<const georef::Admin*> admin_ptr = admin_uris_to_admin_ptr(admins, d);
+    std::vector<nt::idx_t> admin_idxs;
+    for (const georef::Admin* admin: admin_uris_to_admin_ptr(admins, d)) {
+        admin_idxs.push_back(admin->idx);
+    }
 
     //Compute number of words in the query:
-    std::set<std::string> query_word_vec = d.geo_ref->fl_admin.tokenize(q,d.geo_ref->synonyms);
+    const size_t nb_query_words = d.geo_ref->fl_admin.tokenize(q, d.geo_ref->synonym_automaton).size();
 
     ///Find max(100, count) éléments for each pt_object
     for(nt::Type_e type : filter) {
         std::vector<Autocomplete<nt::idx_t>::fl_quality> result;
         switch(type){
         case nt::Type_e::StopArea:
-            if (search_type==0) {
-                result = d.pt_data->stop_area_autocomplete.find_complete(q,
-                        d.geo_ref->synonyms, nbmax,
-                        valid_admin_ptr(d.pt_data->stop_areas, admin_ptr));
-            } else {
-                result = d.pt_data->stop_area_autocomplete.find_partial_with_pattern(q,
-                        d.geo_ref->synonyms, d.geo_ref->word_weight,
-                        nbmax, valid_admin_ptr(d.pt_data->stop_areas, admin_ptr));
-            }
+            result = find_autocomplete(d.pt_data->stop_area_autocomplete, q, nbmax, search_type, d, admin_idxs);
             break;
         case nt::Type_e::StopPoint:
-            if (search_type==0) {
-                result = d.pt_data->stop_point_autocomplete.find_complete(q,
-                        d.geo_ref->synonyms,
-                        nbmax, valid_admin_ptr(d.pt_data->stop_points, admin_ptr));
-            } else {
-                result = d.pt_data->stop_point_autocomplete.find_partial_with_pattern(q,
-                        d.geo_ref->synonyms, d.geo_ref->word_weight, nbmax,
-                        valid_admin_ptr(d.pt_data->stop_points, admin_ptr));
-            }
+            result = find_autocomplete(d.pt_data->stop_point_autocomplete, q, nbmax, search_type, d, admin_idxs);
             break;
         case nt::Type_e::Admin:
-            if (search_type==0) {
-                result = d.geo_ref->fl_admin.find_complete(q,
-                        d.geo_ref->synonyms,
-                        nbmax, valid_admin_ptr(d.geo_ref->admins, admin_ptr));
-            } else {
-                result = d.geo_ref->fl_admin.find_partial_with_pattern(q,
-                        d.geo_ref->synonyms, d.geo_ref->word_weight,
-                        nbmax, valid_admin_ptr(d.geo_ref->admins, admin_ptr));
-            }
+            result = find_autocomplete(d.geo_ref->fl_admin, q, nbmax, search_type, d, admin_idxs);
             break;
         case nt::Type_e::Address:
-            result = d.geo_ref->find_ways(q, nbmax, search_type,
-                    valid_admin_ptr(d.geo_ref->ways, admin_ptr));
+            result = d.geo_ref->find_ways(q, nbmax, search_type, [](nt::idx_t){return true;}, admin_idxs);
             break;
         case nt::Type_e::POI:
-            if (search_type==0) {
-                result = d.geo_ref->fl_poi.find_complete(q,
-                        d.geo_ref->synonyms,
-                        nbmax, valid_admin_ptr(d.geo_ref->pois, admin_ptr));
-            } else {
-                result = d.geo_ref->fl_poi.find_partial_with_pattern(q,
-                        d.geo_ref->synonyms, d.geo_ref->word_weight, nbmax,
-                        valid_admin_ptr(d.geo_ref->pois, admin_ptr));
-            }
+            result = find_autocomplete(d.geo_ref->fl_poi, q, nbmax, search_type, d, admin_idxs);
             break;
         case nt::Type_e::Network:
-            if (search_type==0) {
-                result = d.pt_data->network_autocomplete.find_complete(q,
-                         d.geo_ref->synonyms, nbmax, [](type::idx_t){return true;});
-            } else {
-                result = d.pt_data->network_autocomplete.find_partial_with_pattern(q,
-                         d.geo_ref->synonyms, d.geo_ref->word_weight, nbmax,
-                         [](type::idx_t){return true;});
-            }
+            result = find_autocomplete(d.pt_data->network_autocomplete, q, nbmax, search_type, d, {});
             break;
         case nt::Type_e::CommercialMode:
-            if (search_type==0) {
-                result = d.pt_data->mode_autocomplete.find_complete(q,
-                            d.geo_ref->synonyms, nbmax, [](type::idx_t){return true;});
-            } else {
-                result = d.pt_data->mode_autocomplete.find_partial_with_pattern(q,
-                            d.geo_ref->synonyms, d.geo_ref->word_weight, nbmax,
-                            [](type::idx_t){return true;});
-            }
+            result = find_autocomplete(d.pt_data->mode_autocomplete, q, nbmax, search_type, d, {});
             break;
         case nt::Type_e::Line:
-            if (search_type==0) {
-                result = d.pt_data->line_autocomplete.find_complete(q,
-                        d.geo_ref->synonyms,
-                        nbmax, [](type::idx_t){return true;});
-            } else {
-                result = d.pt_data->line_autocomplete.find_partial_with_pattern(q,
-                                            d.geo_ref->synonyms, d.geo_ref->word_weight,
-                                            nbmax, [](type::idx_t){return true;});
-            }
+            result = find_autocomplete(d.pt_data->line_autocomplete, q, nbmax, search_type, d, {});
             break;
         case nt::Type_e::Route:
-            if (search_type==0) {
-                result = d.pt_data->route_autocomplete.find_complete(q,
-                            d.geo_ref->synonyms, nbmax, [](type::idx_t){return true;});
-            } else {
-                result = d.pt_data->route_autocomplete.find_partial_with_pattern(q,
-                            d.geo_ref->synonyms, d.geo_ref->word_weight,
-                            nbmax, [](type::idx_t){return true;});
-            }
+            result = find_autocomplete(d.pt_data->route_autocomplete, q, nbmax, search_type, d, {});
             break;
         default: break;
         }
 
         //Compute quality based on difference of word count in the result and the query
         if (search_type == 0) {
-            update_quality(result, query_word_vec.size());
+            update_quality(result, nb_query_words);
         }
 
         create_place_pb(result, type, depth, d, pb_response);
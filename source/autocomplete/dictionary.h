@@ -0,0 +1,418 @@
+/* Copyright © 2001-2014, Canal TP and/or its affiliates. All rights reserved.
+
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+Stay tuned using
+twitter @navitia
+IRC #navitia on freenode
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#pragma once
+#include <boost/serialization/serialization.hpp>
+#include <boost/serialization/vector.hpp>
+#include <boost/serialization/string.hpp>
+#include <string>
+#include <vector>
+#include <utility>
+#include <type_traits>
+#include <cstdint>
+#include <algorithm>
+
+namespace navitia { namespace autocomplete {
+
+/// append v to out, 7 bits by byte, the high bit telling if another byte follows
+inline void write_varint(std::vector<uint8_t>& out, uint32_t v) {
+    while (v >= 0x80) {
+        out.push_back(uint8_t(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(uint8_t(v));
+}
+
+inline void write_varint(std::string& out, uint32_t v) {
+    while (v >= 0x80) {
+        out.push_back(char(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(char(v));
+}
+
+/// read a varint and move p after it
+template<typename Byte>
+inline uint32_t read_varint(const Byte*& p) {
+    uint32_t res = 0;
+    for (int shift = 0; ; shift += 7) {
+        const uint8_t b = uint8_t(*p++);
+        res |= uint32_t(b & 0x7f) << shift;
+        if (b < 0x80) { return res; }
+    }
+}
+
+/** Dictionnaire immuable associant à chaque mot la liste triée des éléments le contenant
+  *
+  * The words are sorted and front coded by blocks of block_size words: the first word of a block
+  * is stored entirely, the others only store the length of the prefix shared with the previous
+  * word and their suffix. It is the flatten form of a trie: the words sharing a prefix are
+  * contiguous, and the prefix is only stored once by block.
+  *
+  * The posting lists are stored one after the other in the words order, each one being delta
+  * encoded with varints. They are read in place, without any copy.
+  *
+  * The very frequent words (like "rue" or "de") also have a bitmap of their elements, so
+  * intersecting them with a small list only costs a bit test by element.
+  *
+  * T has to be an integral type
+  */
+template<class T>
+struct Dictionary {
+    static_assert(std::is_integral<T>::value, "the posting lists are delta encoded");
+    static constexpr uint32_t block_size = 16;
+    /// a word has a bitmap if it is in more than 1/dense_ratio of the elements
+    static constexpr uint32_t dense_ratio = 32;
+    static constexpr uint32_t min_dense_size = 256;
+
+    /// front coded words (varint shared length, varint suffix length, suffix)
+    std::string words;
+    /// offset in words of the first word of each block
+    std::vector<uint32_t> block_offsets;
+    /// delta encoded posting lists
+    std::vector<uint8_t> postings;
+    /// offset in postings of the posting list of each word (nb_words + 1 elements)
+    std::vector<uint32_t> posting_offsets = {0};
+    /// sorted indexes of the words having a bitmap
+    std::vector<uint32_t> dense_words;
+    /// bitmaps of the dense words, one after the other
+    std::vector<uint64_t> bitmaps;
+    /// number of uint64_t by bitmap
+    uint32_t bitmap_size = 0;
+
+    template<class Archive> void serialize(Archive & ar, const unsigned int) {
+        ar & words & block_offsets & postings & posting_offsets & dense_words & bitmaps & bitmap_size;
+    }
+
+    uint32_t size() const { return posting_offsets.size() - 1; }
+    bool empty() const { return size() == 0; }
+
+    void clear() {
+        words.clear();
+        block_offsets.clear();
+        postings.clear();
+        posting_offsets = {0};
+        dense_words.clear();
+        bitmaps.clear();
+        bitmap_size = 0;
+        counts.clear();
+        nb_elements = 0;
+    }
+
+    /// add a word and its posting list. The words must be added in order, the list must be sorted
+    template<typename Range>
+    void push_back(const std::string& word, const Range& posting_list) {
+        if (size() % block_size == 0) {
+            block_offsets.push_back(words.size());
+            last_word.clear();
+        }
+        uint32_t shared = 0;
+        while (shared < last_word.size() && shared < word.size() && last_word[shared] == word[shared]) {
+            ++shared;
+        }
+        write_varint(words, shared);
+        write_varint(words, word.size() - shared);
+        words.append(word, shared, std::string::npos);
+        last_word = word;
+
+        T previous = 0;
+        uint32_t count = 0;
+        for (const T elt: posting_list) {
+            write_varint(postings, uint32_t(elt - previous));
+            previous = elt;
+            ++count;
+        }
+        posting_offsets.push_back(postings.size());
+        counts.push_back(count);
+        if (count > 0) { nb_elements = std::max(nb_elements, uint32_t(previous) + 1); }
+    }
+
+    /// to call once all the words are added: build the bitmaps and release the extra capacity
+    void finalize() {
+        bitmap_size = (nb_elements + 63) / 64;
+        for (uint32_t w = 0; w < counts.size(); ++w) {
+            if (counts[w] < min_dense_size || uint64_t(counts[w]) * dense_ratio < nb_elements) { continue; }
+            dense_words.push_back(w);
+            const size_t offset = bitmaps.size();
+            bitmaps.resize(offset + bitmap_size, 0);
+            for_each_posting(w, [&](T elt) {
+                bitmaps[offset + elt / 64] |= uint64_t(1) << (elt % 64);
+            });
+        }
+        counts.clear();
+        counts.shrink_to_fit();
+        last_word.clear();
+        last_word.shrink_to_fit();
+        words.shrink_to_fit();
+        block_offsets.shrink_to_fit();
+        postings.shrink_to_fit();
+        posting_offsets.shrink_to_fit();
+        dense_words.shrink_to_fit();
+        bitmaps.shrink_to_fit();
+    }
+
+    /// Sequential reader of the words, starting at a word index
+    struct WordCursor {
+        const Dictionary& dict;
+        uint32_t idx;
+        /// the current word
+        std::string word;
+        /// length of the prefix shared with the previous word read by the cursor
+        uint32_t shared = 0;
+
+        WordCursor(const Dictionary& d, uint32_t start): dict(d), idx(start) {
+            // we have to decode from the begining of the block
+            const uint32_t block_start = start - start % block_size;
+            pos = block_start < dict.size() ? dict.block_offsets[block_start / block_size] : dict.words.size();
+            for (idx = block_start; idx < start; ++idx) { read(); }
+            if (valid()) { read(); }
+        }
+        bool valid() const { return idx < dict.size(); }
+        void next() {
+            ++idx;
+            if (valid()) { read(); }
+        }
+    private:
+        size_t pos;
+        void read() {
+            const char* p = dict.words.data() + pos;
+            shared = read_varint(p);
+            const uint32_t len = read_varint(p);
+            word.resize(shared);
+            word.append(p, len);
+            pos = p + len - dict.words.data();
+        }
+    };
+
+    std::string word(uint32_t idx) const {
+        return WordCursor(*this, idx).word;
+    }
+
+    /// index of the first word not lower than key
+    uint32_t lower_bound(const std::string& key) const {
+        // binary search on the first word of the blocks, which are stored entirely
+        size_t first = 0, count = block_offsets.size();
+        while (count > 0) {
+            const size_t step = count / 2;
+            if (block_first_word_lower(first + step, key)) {
+                first += step + 1;
+                count -= step + 1;
+            } else {
+                count = step;
+            }
+        }
+        if (first == 0) { return 0; }
+        // the key is in the block before
+        WordCursor cursor(*this, (first - 1) * block_size);
+        while (cursor.valid() && cursor.idx < first * block_size && cursor.word < key) {
+            cursor.next();
+        }
+        return cursor.idx;
+    }
+
+    /// range [first, last) of the words begining with prefix
+    std::pair<uint32_t, uint32_t> prefix_range(const std::string& prefix) const {
+        const uint32_t first = lower_bound(prefix);
+        // the first word after the prefix is the lower bound of the next prefix
+        std::string next = prefix;
+        while (! next.empty() && uint8_t(next.back()) == 0xff) { next.pop_back(); }
+        if (next.empty()) { return {first, size()}; }
+        next.back() = char(uint8_t(next.back()) + 1);
+        return {first, lower_bound(next)};
+    }
+
+    /// call f on each element of the posting list of the word, read in place
+    template<typename F>
+    void for_each_posting(uint32_t word_idx, F f) const {
+        const uint8_t* p = postings.data() + posting_offsets[word_idx];
+        const uint8_t* end = postings.data() + posting_offsets[word_idx + 1];
+        T value = 0;
+        while (p != end) {
+            value += T(read_varint(p));
+            f(value);
+        }
+    }
+
+    /// call f on each element of the posting list of the word while f returns true
+    template<typename F>
+    void for_each_posting_while(uint32_t word_idx, F f) const {
+        const uint8_t* p = postings.data() + posting_offsets[word_idx];
+        const uint8_t* end = postings.data() + posting_offsets[word_idx + 1];
+        T value = 0;
+        while (p != end) {
+            value += T(read_varint(p));
+            if (! f(value)) { return; }
+        }
+    }
+
+    /** Call f(word_idx, distance) on each word having a prefix at an edit distance of key lower or equal to
+      * max_distance, the distance being the one of its closest prefix
+      *
+      * The words are walked in order like the nodes of a trie: the rows of the Levenshtein matrix of the
+      * prefix shared with the previous word are kept, and once the distance of a prefix can not change
+      * anymore, all the words begining with it are given at once or skipped.
+      */
+    template<typename F>
+    void for_each_fuzzy_word(const std::string& key, uint32_t max_distance, F f) const {
+        const size_t width = key.size() + 1;
+        // rows[k * width + j]: distance between the k first chars of prefix and the j first chars of key
+        std::vector<uint32_t> rows(width);
+        for (size_t j = 0; j < width; ++j) { rows[j] = j; }
+        // best[k]: distance of the closest prefix of length lower or equal to k
+        std::vector<uint32_t> best = {uint32_t(key.size())};
+        std::string prefix;
+
+        uint32_t idx = 0;
+        while (idx < size()) {
+            WordCursor cursor(*this, idx);
+            idx = size();
+            while (cursor.valid()) {
+                const std::string& word = cursor.word;
+                size_t depth = 0;
+                while (depth < prefix.size() && depth < word.size() && prefix[depth] == word[depth]) { ++depth; }
+                prefix.resize(depth);
+                best.resize(depth + 1);
+                rows.resize((depth + 1) * width);
+
+                bool prefix_done = false;
+                while (! prefix_done && prefix.size() < word.size()) {
+                    const char c = word[prefix.size()];
+                    prefix.push_back(c);
+                    const size_t prev = rows.size() - width;
+                    const size_t cur = rows.size();
+                    rows.resize(cur + width);
+                    rows[cur] = rows[prev] + 1;
+                    uint32_t row_min = rows[cur];
+                    for (size_t j = 1; j < width; ++j) {
+                        rows[cur + j] = std::min(std::min(rows[prev + j], rows[cur + j - 1]) + 1,
+                                                 rows[prev + j - 1] + (key[j - 1] == c ? 0 : 1));
+                        row_min = std::min(row_min, rows[cur + j]);
+                    }
+                    best.push_back(std::min(best.back(), rows[cur + width - 1]));
+                    // the next chars can not give a distance lower than row_min
+                    prefix_done = row_min >= best.back() || row_min > max_distance;
+                }
+
+                const uint32_t distance = best.back();
+                if (! prefix_done) {
+                    if (distance <= max_distance) { f(cursor.idx, distance); }
+                    cursor.next();
+                } else if (distance <= max_distance) {
+                    // all the words begining with prefix have this distance
+                    while (cursor.valid() && cursor.word.compare(0, prefix.size(), prefix) == 0) {
+                        f(cursor.idx, distance);
+                        cursor.next();
+                    }
+                } else {
+                    // no word begining with prefix can match, we jump after them
+                    idx = prefix_range(prefix).second;
+                    break;
+                }
+            }
+        }
+    }
+
+    /// Sequential reader of a posting list, to merge several lists lazily
+    struct PostingIterator {
+        /// the current element
+        T value = 0;
+
+        PostingIterator(const Dictionary& dict, uint32_t word_idx):
+            p(dict.postings.data() + dict.posting_offsets[word_idx]),
+            end(dict.postings.data() + dict.posting_offsets[word_idx + 1]) {
+            next();
+        }
+        bool valid() const { return is_valid; }
+        void next() {
+            if (p == end) {
+                is_valid = false;
+                return;
+            }
+            value += T(read_varint(p));
+        }
+    private:
+        const uint8_t* p;
+        const uint8_t* end;
+        bool is_valid = true;
+    };
+
+    /// the same dictionary, each element e being replaced by new_values[e]
+    Dictionary remap(const std::vector<T>& new_values) const {
+        Dictionary res;
+        std::vector<T> list;
+        for (WordCursor cursor(*this, 0); cursor.valid(); cursor.next()) {
+            list.clear();
+            for_each_posting(cursor.idx, [&](T elt) { list.push_back(new_values[elt]); });
+            std::sort(list.begin(), list.end());
+            res.push_back(cursor.word, list);
+        }
+        res.finalize();
+        return res;
+    }
+
+    /// size in bytes of the posting lists of the range, a cheap estimation of their length
+    uint32_t nb_bytes(std::pair<uint32_t, uint32_t> range) const {
+        return posting_offsets[range.second] - posting_offsets[range.first];
+    }
+
+    /// bitmap of the word if it is a frequent one, nullptr otherwise
+    const uint64_t* bitmap(uint32_t word_idx) const {
+        const auto it = std::lower_bound(dense_words.begin(), dense_words.end(), word_idx);
+        if (it == dense_words.end() || *it != word_idx) { return nullptr; }
+        return bitmaps.data() + size_t(it - dense_words.begin()) * bitmap_size;
+    }
+
+    bool bitmap_contains(const uint64_t* bitmap, T elt) const {
+        return uint32_t(elt) / 64 < bitmap_size && (bitmap[elt / 64] >> (elt % 64)) & 1;
+    }
+
+    /// call f on each element of the posting lists of the words in [first, last)
+    template<typename F>
+    void for_each_posting(std::pair<uint32_t, uint32_t> range, F f) const {
+        for (uint32_t w = range.first; w < range.second; ++w) {
+            for_each_posting(w, f);
+        }
+    }
+
+private:
+    /// only used during the construction
+    std::string last_word;
+    std::vector<uint32_t> counts;
+    uint32_t nb_elements = 0;
+
+    bool block_first_word_lower(size_t block, const std::string& key) const {
+        const char* p = words.data() + block_offsets[block];
+        read_varint(p);
+        const uint32_t len = read_varint(p);
+        return key.compare(0, std::string::npos, p, len) > 0;
+    }
+};
+
+}} // namespace navitia::autocomplete
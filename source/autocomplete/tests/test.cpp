@@ -52,42 +52,47 @@ namespace pt = boost::posix_time;
 using namespace navitia::autocomplete;
 using namespace navitia::georef;
 
+static std::set<std::string> to_set(const Tokens& tokens) {
+    return std::set<std::string>(tokens.begin(), tokens.end());
+}
+
 BOOST_AUTO_TEST_CASE(parse_find_with_synonym_and_synonyms_test){
     int nbmax = 10;
     std::vector<std::string> admins;
     std::string admin_uri = "";
 
-    autocomplete_map synonyms;
-    synonyms["hotel de ville"]="mairie";
-    synonyms["c c"]="centre commercial";
-    synonyms["cc"]="centre commercial";
-    synonyms["c.h.u"]="hopital";
-    synonyms["c.h.r"]="hopital";
-    synonyms["ld"]="Lieu-Dit";
-    synonyms["de"]="";
-    synonyms["la"]="";
-    synonyms["les"]="";
-    synonyms["des"]="";
-    synonyms["d"]="";
-    synonyms["l"]="";
-
-    synonyms["st"]="saint";
-    synonyms["ste"]="sainte";
-    synonyms["cc"]="centre commercial";
-    synonyms["chu"]="hopital";
-    synonyms["chr"]="hopital";
-    synonyms["c.h.u"]="hopital";
-    synonyms["c.h.r"]="hopital";
-    synonyms["all"]="allée";
-    synonyms["allee"]="allée";
-    synonyms["ave"]="avenue";
-    synonyms["av"]="avenue";
-    synonyms["bvd"]="boulevard";
-    synonyms["bld"]="boulevard";
-    synonyms["bd"]="boulevard";
-    synonyms["b"]="boulevard";
-    synonyms["r"]="rue";
-    synonyms["pl"]="place";
+    autocomplete_map synonym_map;
+    synonym_map["hotel de ville"]="mairie";
+    synonym_map["c c"]="centre commercial";
+    synonym_map["cc"]="centre commercial";
+    synonym_map["c.h.u"]="hopital";
+    synonym_map["c.h.r"]="hopital";
+    synonym_map["ld"]="Lieu-Dit";
+    synonym_map["de"]="";
+    synonym_map["la"]="";
+    synonym_map["les"]="";
+    synonym_map["des"]="";
+    synonym_map["d"]="";
+    synonym_map["l"]="";
+
+    synonym_map["st"]="saint";
+    synonym_map["ste"]="sainte";
+    synonym_map["cc"]="centre commercial";
+    synonym_map["chu"]="hopital";
+    synonym_map["chr"]="hopital";
+    synonym_map["c.h.u"]="hopital";
+    synonym_map["c.h.r"]="hopital";
+    synonym_map["all"]="allée";
+    synonym_map["allee"]="allée";
+    synonym_map["ave"]="avenue";
+    synonym_map["av"]="avenue";
+    synonym_map["bvd"]="boulevard";
+    synonym_map["bld"]="boulevard";
+    synonym_map["bd"]="boulevard";
+    synonym_map["b"]="boulevard";
+    synonym_map["r"]="rue";
+    synonym_map["pl"]="place";
+    const SynonymAutomaton synonyms(synonym_map);
 
     Autocomplete<unsigned int> ac;
     ac.add_string("hotel de ville paris", 0, synonyms);
@@ -172,28 +177,29 @@ BOOST_AUTO_TEST_CASE(regex_replace_tests){
 
 BOOST_AUTO_TEST_CASE(regex_toknize_tests){
 
-    autocomplete_map synonyms;
-    synonyms["hotel de ville"]="mairie";
-    synonyms["c c"]="centre commercial";
-    synonyms["cc"]="centre commercial";
-    synonyms["c.h.u"]="hopital";
-    synonyms["c.h.r"]="hopital";
-    synonyms["ld"]="Lieu-Dit";
-    synonyms["de"]="";
-    synonyms["la"]="";
-    synonyms["les"]="";
-    synonyms["des"]="";
-    synonyms["d"]="";
-    synonyms["l"]="";
-    synonyms["st"]="saint";
-    synonyms["r"]="rue";
+    autocomplete_map synonym_map;
+    synonym_map["hotel de ville"]="mairie";
+    synonym_map["c c"]="centre commercial";
+    synonym_map["cc"]="centre commercial";
+    synonym_map["c.h.u"]="hopital";
+    synonym_map["c.h.r"]="hopital";
+    synonym_map["ld"]="Lieu-Dit";
+    synonym_map["de"]="";
+    synonym_map["la"]="";
+    synonym_map["les"]="";
+    synonym_map["des"]="";
+    synonym_map["d"]="";
+    synonym_map["l"]="";
+    synonym_map["st"]="saint";
+    synonym_map["r"]="rue";
+    const SynonymAutomaton synonyms(synonym_map);
 
     Autocomplete<unsigned int> ac;
     std::set<std::string> vec;
 
     //synonyme : "cc" = "centre commercial" / synonym : de = ""
     //"cc Carré de Soie" -> "centre commercial carré de soie"
-    vec = ac.tokenize("cc Carré de Soie", synonyms);
+    vec = to_set(ac.tokenize("cc Carré de Soie", synonyms));
     BOOST_CHECK(vec.find("carre") != vec.end());
     BOOST_CHECK(vec.find("centre") != vec.end());
     BOOST_CHECK(vec.find("commercial") != vec.end());
@@ -202,27 +208,90 @@ BOOST_AUTO_TEST_CASE(regex_toknize_tests){
     vec.clear();
     //synonyme : "c c"= "centre commercial" / synonym : de = ""
     //"c c Carré de Soie" -> "centre commercial carré de soie"
-    vec = ac.tokenize("c c Carré de Soie", synonyms);
+    vec = to_set(ac.tokenize("c c Carré de Soie", synonyms));
     BOOST_CHECK(vec.find("carre") != vec.end());
     BOOST_CHECK(vec.find("centre") != vec.end());
     BOOST_CHECK(vec.find("commercial") != vec.end());
     BOOST_CHECK(vec.find("soie") != vec.end());
+
+    //the words are sorted and without duplicates, in a buffer reused by the thread
+    const SynonymAutomaton no_synonyms;
+    const Tokens& tokens = ac.tokenize("soie carre soie", no_synonyms);
+    BOOST_REQUIRE_EQUAL(tokens.size(), 2);
+    BOOST_CHECK_EQUAL(tokens[0], "carre");
+    BOOST_CHECK_EQUAL(tokens[1], "soie");
+    BOOST_CHECK_EQUAL(&ac.tokenize("gare", no_synonyms), &tokens);
 }
 
-BOOST_AUTO_TEST_CASE(regex_address_type_tests){
+BOOST_AUTO_TEST_CASE(normalize_tests){
+    Tokens tokens;
+    normalize("  Œuvre  l'Haÿ-les-Roses, Straße «Ñandú» 12 ", tokens);
+    std::vector<std::string> words(tokens.begin(), tokens.end());
+    std::vector<std::string> expected = {"oeuvre", "l", "hay", "les", "roses", "strasse", "nandu", "12"};
+    BOOST_CHECK_EQUAL_COLLECTIONS(words.begin(), words.end(), expected.begin(), expected.end());
+
+    // the buffers are reused
+    normalize("", tokens);
+    BOOST_CHECK(tokens.empty());
+    normalize("Gare", tokens);
+    BOOST_REQUIRE_EQUAL(tokens.size(), 1);
+    BOOST_CHECK_EQUAL(tokens[0], "gare");
+}
 
+BOOST_AUTO_TEST_CASE(synonym_automaton_tests){
     autocomplete_map synonyms;
-    synonyms["hotel de ville"]="mairie";
-    synonyms["c c"]="centre commercial";
-    synonyms["cc"]="centre commercial";
+    synonyms["gare sncf"]="gare";
+    synonyms["gare s"]="gare";
     synonyms["c.h.u"]="hopital";
-    synonyms["c.h.r"]="hopital";
-    synonyms["ld"]="Lieu-Dit";
-    synonyms["av"]="avenue";
-    synonyms["r"]="rue";
-    synonyms["bvd"]="boulevard";
-    synonyms["bld"]="boulevard";
-    synonyms["bd"]="boulevard";
+    synonyms["st"]="saint";
+    synonyms["saint"]="st";
+    synonyms["allee"]="allée";
+    synonyms["all"]="allée";
+    synonyms["de"]="";
+    const SynonymAutomaton automaton(synonyms);
+
+    Tokens words, result;
+    auto apply = [&](const std::string& str) {
+        normalize(str, words);
+        automaton.apply(words, result);
+        return std::vector<std::string>(result.begin(), result.end());
+    };
+    // the longest key is replaced
+    std::vector<std::string> expected = {"gare", "nantes"};
+    auto found = apply("Gare SNCF de Nantes");
+    BOOST_CHECK_EQUAL_COLLECTIONS(found.begin(), found.end(), expected.begin(), expected.end());
+    // the punctuation of the keys splits the words as in the names
+    expected = {"hopital", "nord"};
+    found = apply("C-H-U nord");
+    BOOST_CHECK_EQUAL_COLLECTIONS(found.begin(), found.end(), expected.begin(), expected.end());
+    // a value is not rewritten by another synonym
+    expected = {"saint", "st", "allee"};
+    found = apply("st saint allée");
+    BOOST_CHECK_EQUAL_COLLECTIONS(found.begin(), found.end(), expected.begin(), expected.end());
+    expected = {"allee", "allee"};
+    found = apply("all allee");
+    BOOST_CHECK_EQUAL_COLLECTIONS(found.begin(), found.end(), expected.begin(), expected.end());
+    // a key in a word is not a key
+    expected = {"stade", "gares"};
+    found = apply("stade gares");
+    BOOST_CHECK_EQUAL_COLLECTIONS(found.begin(), found.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(regex_address_type_tests){
+
+    autocomplete_map synonym_map;
+    synonym_map["hotel de ville"]="mairie";
+    synonym_map["c c"]="centre commercial";
+    synonym_map["cc"]="centre commercial";
+    synonym_map["c.h.u"]="hopital";
+    synonym_map["c.h.r"]="hopital";
+    synonym_map["ld"]="Lieu-Dit";
+    synonym_map["av"]="avenue";
+    synonym_map["r"]="rue";
+    synonym_map["bvd"]="boulevard";
+    synonym_map["bld"]="boulevard";
+    synonym_map["bd"]="boulevard";
+    const SynonymAutomaton synonyms(synonym_map);
     //AddressType = {"rue", "avenue", "place", "boulevard","chemin", "impasse"}
 
     Autocomplete<unsigned int> ac;
@@ -232,56 +301,57 @@ BOOST_AUTO_TEST_CASE(regex_address_type_tests){
 
 BOOST_AUTO_TEST_CASE(regex_synonyme_gare_sncf_tests){
 
-    autocomplete_map synonyms;
-    synonyms["gare sncf"]="gare";
-    synonyms["gare snc"]="gare";
-    synonyms["gare sn"]="gare";
-    synonyms["gare s"]="gare";
-    synonyms["de"]="";
-    synonyms["la"]="";
-    synonyms["les"]="";
-    synonyms["des"]="";
-    synonyms["d"]="";
-    synonyms["l"]="";
-    synonyms["st"]="saint";
-    synonyms["av"]="avenue";
-    synonyms["r"]="rue";
-    synonyms["bvd"]="boulevard";
-    synonyms["bld"]="boulevard";
-    synonyms["bd"]="boulevard";
+    autocomplete_map synonym_map;
+    synonym_map["gare sncf"]="gare";
+    synonym_map["gare snc"]="gare";
+    synonym_map["gare sn"]="gare";
+    synonym_map["gare s"]="gare";
+    synonym_map["de"]="";
+    synonym_map["la"]="";
+    synonym_map["les"]="";
+    synonym_map["des"]="";
+    synonym_map["d"]="";
+    synonym_map["l"]="";
+    synonym_map["st"]="saint";
+    synonym_map["av"]="avenue";
+    synonym_map["r"]="rue";
+    synonym_map["bvd"]="boulevard";
+    synonym_map["bld"]="boulevard";
+    synonym_map["bd"]="boulevard";
+    const SynonymAutomaton synonyms(synonym_map);
 
     Autocomplete<unsigned int> ac;
     std::set<std::string> vec;
 
     //synonyme : "gare sncf" = "gare"
     //"gare sncf" -> "gare"
-    vec = ac.tokenize("gare sncf", synonyms);
+    vec = to_set(ac.tokenize("gare sncf", synonyms));
     BOOST_CHECK_EQUAL(vec.size(),1);
     vec.clear();
 
     //synonyme : "gare snc" = "gare"
     //"gare snc" -> "gare"
-    vec = ac.tokenize("gare snc", synonyms);
+    vec = to_set(ac.tokenize("gare snc", synonyms));
     BOOST_CHECK_EQUAL(vec.size(),1);
     vec.clear();
 
     //synonyme : "gare sn" = "gare"
     //"gare sn" -> "gare"
-    vec = ac.tokenize("gare sn", synonyms);
+    vec = to_set(ac.tokenize("gare sn", synonyms));
     BOOST_CHECK(vec.find("gare") != vec.end());
     BOOST_CHECK_EQUAL(vec.size(),1);
     vec.clear();
 
     //synonyme : "gare s" = "gare"
     //"gare s" -> "gare"
-    vec = ac.tokenize("gare s", synonyms);
+    vec = to_set(ac.tokenize("gare s", synonyms));
     BOOST_CHECK(vec.find("gare") != vec.end());
     BOOST_CHECK_EQUAL(vec.size(),1);
     vec.clear();
 
     //synonyme : "gare sn nantes" = "gare nantes"
     //"gare sn nantes" -> "gare nantes"
-    vec = ac.tokenize("gare sn nantes", synonyms);
+    vec = to_set(ac.tokenize("gare sn nantes", synonyms));
     BOOST_CHECK(vec.find("gare") != vec.end());
     BOOST_CHECK(vec.find("nantes") != vec.end());
     BOOST_CHECK_EQUAL(vec.size(),2);
@@ -289,7 +359,7 @@ BOOST_AUTO_TEST_CASE(regex_synonyme_gare_sncf_tests){
 
     //synonyme : "gare sn nantes" = "gare nantes"
     //"gare sn  nantes" -> "gare nantes"
-    vec = ac.tokenize("gare sn  nantes", synonyms);
+    vec = to_set(ac.tokenize("gare sn  nantes", synonyms));
     BOOST_CHECK(vec.find("gare") != vec.end());
     BOOST_CHECK(vec.find("nantes") != vec.end());
     BOOST_CHECK_EQUAL(vec.size(),2);
@@ -297,7 +367,7 @@ BOOST_AUTO_TEST_CASE(regex_synonyme_gare_sncf_tests){
 
     //synonyme : "gare sn nantes" = "gare nantes"
     //"gare s  nantes" -> "gare nantes"
-    vec = ac.tokenize("gare  s  nantes", synonyms);
+    vec = to_set(ac.tokenize("gare  s  nantes", synonyms));
     BOOST_CHECK(vec.find("gare") != vec.end());
     BOOST_CHECK(vec.find("nantes") != vec.end());
     BOOST_CHECK_EQUAL(vec.size(),2);
@@ -305,7 +375,7 @@ BOOST_AUTO_TEST_CASE(regex_synonyme_gare_sncf_tests){
 
     //synonyme : "gare sn nantes" = "gare nantes"
     //"gare s    nantes" -> "gare nantes"
-    vec = ac.tokenize("gare  s    nantes", synonyms);
+    vec = to_set(ac.tokenize("gare  s    nantes", synonyms));
     BOOST_CHECK(vec.find("gare") != vec.end());
     BOOST_CHECK(vec.find("nantes") != vec.end());
     BOOST_CHECK_EQUAL(vec.size(),2);
@@ -313,7 +383,7 @@ BOOST_AUTO_TEST_CASE(regex_synonyme_gare_sncf_tests){
 }
 
 BOOST_AUTO_TEST_CASE(parse_find_with_name_in_vector_test){
-    autocomplete_map synonyms;
+    const SynonymAutomaton synonyms;
     std::set<std::string> vec;
     std::string admin_uri = "";
 
@@ -408,7 +478,7 @@ BOOST_AUTO_TEST_CASE(parse_find_with_name_in_vector_test){
 
 BOOST_AUTO_TEST_CASE(Faute_de_frappe_One){
 
-        autocomplete_map synonyms;
+        const SynonymAutomaton synonyms;
         int word_weight = 5;
         int nbmax = 10;
 
@@ -429,10 +499,12 @@ BOOST_AUTO_TEST_CASE(Faute_de_frappe_One){
 
         auto res1 = ac.find_partial_with_pattern("gare patea", synonyms,word_weight, nbmax, [](int){return true;});
         BOOST_REQUIRE_EQUAL(res1.size(), 3);
-        BOOST_CHECK_EQUAL(res1.at(0).idx, 4);
-        BOOST_CHECK_EQUAL(res1.at(1).idx, 1);
+        // same quality, the results are sorted by rank
+        BOOST_CHECK_EQUAL(res1.at(0).idx, 1);
+        BOOST_CHECK_EQUAL(res1.at(1).idx, 4);
         BOOST_CHECK_EQUAL(res1.at(2).idx, 0);
         BOOST_CHECK_EQUAL(res1.at(0).quality, 94);
+        BOOST_CHECK_EQUAL(res1.at(1).quality, 94);
 
 
     }
@@ -458,7 +530,7 @@ sort
 
 BOOST_AUTO_TEST_CASE(autocomplete_find_quality_test){
 
-    autocomplete_map synonyms;
+    const SynonymAutomaton synonyms;
     std::vector<std::string> admins;
     std::string admin_uri = "";
     int nbmax = 10;
@@ -477,22 +549,22 @@ BOOST_AUTO_TEST_CASE(autocomplete_find_quality_test){
     ac.build();
 
     auto res = ac.find_complete("rue jean", synonyms, nbmax,[](int){return true;});
-    std::vector<int> expected = {6,7,0,2};
     BOOST_REQUIRE_EQUAL(res.size(), 4);
     BOOST_CHECK_EQUAL(res.at(0).quality, 100);
     BOOST_CHECK_EQUAL(res.at(1).quality, 100);
     BOOST_CHECK_EQUAL(res.at(2).quality, 100);
     BOOST_CHECK_EQUAL(res.at(3).quality, 100);
-    BOOST_CHECK_EQUAL(res.at(0).idx, 2);
+    // same score, the results with the fewest words are the first ones
+    BOOST_CHECK_EQUAL(res.at(0).idx, 6);
     BOOST_CHECK_EQUAL(res.at(1).idx, 7);
     BOOST_CHECK_EQUAL(res.at(2).idx, 0);
-    BOOST_CHECK_EQUAL(res.at(3).idx, 6);
+    BOOST_CHECK_EQUAL(res.at(3).idx, 2);
 }
 
 ///Test pour verifier que - entres les deux mots est ignoré.
 BOOST_AUTO_TEST_CASE(autocomplete_add_string_with_Line){
 
-    autocomplete_map synonyms;
+    const SynonymAutomaton synonyms;
     std::vector<std::string> admins;
     std::string admin_uri = "";
     int nbmax = 10;
@@ -515,35 +587,36 @@ BOOST_AUTO_TEST_CASE(autocomplete_add_string_with_Line){
 
 BOOST_AUTO_TEST_CASE(autocompletesynonym_and_weight_test){
 
-        autocomplete_map synonyms;
+        autocomplete_map synonym_map;
         std::vector<std::string> admins;
         std::string admin_uri;
         int nbmax = 10;
 
-        synonyms["de"]="";
-        synonyms["la"]="";
-        synonyms["les"]="";
-        synonyms["des"]="";
-        synonyms["d"]="";
-        synonyms["l"]="";
-
-        synonyms["st"]="saint";
-        synonyms["ste"]="sainte";
-        synonyms["cc"]="centre commercial";
-        synonyms["chu"]="hopital";
-        synonyms["chr"]="hopital";
-        synonyms["c.h.u"]="hopital";
-        synonyms["c.h.r"]="hopital";
-        synonyms["all"]="allée";
-        synonyms["allee"]="allée";
-        synonyms["ave"]="avenue";
-        synonyms["av"]="avenue";
-        synonyms["bvd"]="boulevard";
-        synonyms["bld"]="boulevard";
-        synonyms["bd"]="boulevard";
-        synonyms["b"]="boulevard";
-        synonyms["r"]="rue";
-        synonyms["pl"]="place";
+        synonym_map["de"]="";
+        synonym_map["la"]="";
+        synonym_map["les"]="";
+        synonym_map["des"]="";
+        synonym_map["d"]="";
+        synonym_map["l"]="";
+
+        synonym_map["st"]="saint";
+        synonym_map["ste"]="sainte";
+        synonym_map["cc"]="centre commercial";
+        synonym_map["chu"]="hopital";
+        synonym_map["chr"]="hopital";
+        synonym_map["c.h.u"]="hopital";
+        synonym_map["c.h.r"]="hopital";
+        synonym_map["all"]="allée";
+        synonym_map["allee"]="allée";
+        synonym_map["ave"]="avenue";
+        synonym_map["av"]="avenue";
+        synonym_map["bvd"]="boulevard";
+        synonym_map["bld"]="boulevard";
+        synonym_map["bd"]="boulevard";
+        synonym_map["b"]="boulevard";
+        synonym_map["r"]="rue";
+        synonym_map["pl"]="place";
+        const SynonymAutomaton synonyms(synonym_map);
 
         Autocomplete<unsigned int> ac;
         ac.add_string("rue jeanne d'arc", 0, synonyms);
@@ -592,36 +665,37 @@ BOOST_AUTO_TEST_CASE(autocompletesynonym_and_weight_test){
 
 BOOST_AUTO_TEST_CASE(autocomplete_duplicate_words_and_weight_test){
 
-    autocomplete_map synonyms;
+    autocomplete_map synonym_map;
     std::vector<std::string> admins;
     std::string admin_uri;
     int nbmax = 10;
 
-    synonyms["de"]="";
-    synonyms["la"]="";
-    synonyms["le"]="";
-    synonyms["les"]="";
-    synonyms["des"]="";
-    synonyms["d"]="";
-    synonyms["l"]="";
-
-    synonyms["st"]="saint";
-    synonyms["ste"]="sainte";
-    synonyms["cc"]="centre commercial";
-    synonyms["chu"]="hopital";
-    synonyms["chr"]="hopital";
-    synonyms["c.h.u"]="hopital";
-    synonyms["c.h.r"]="hopital";
-    synonyms["all"]="allée";
-    synonyms["allee"]="allée";
-    synonyms["ave"]="avenue";
-    synonyms["av"]="avenue";
-    synonyms["bvd"]="boulevard";
-    synonyms["bld"]="boulevard";
-    synonyms["bd"]="boulevard";
-    synonyms["b"]="boulevard";
-    synonyms["r"]="rue";
-    synonyms["pl"]="place";
+    synonym_map["de"]="";
+    synonym_map["la"]="";
+    synonym_map["le"]="";
+    synonym_map["les"]="";
+    synonym_map["des"]="";
+    synonym_map["d"]="";
+    synonym_map["l"]="";
+
+    synonym_map["st"]="saint";
+    synonym_map["ste"]="sainte";
+    synonym_map["cc"]="centre commercial";
+    synonym_map["chu"]="hopital";
+    synonym_map["chr"]="hopital";
+    synonym_map["c.h.u"]="hopital";
+    synonym_map["c.h.r"]="hopital";
+    synonym_map["all"]="allée";
+    synonym_map["allee"]="allée";
+    synonym_map["ave"]="avenue";
+    synonym_map["av"]="avenue";
+    synonym_map["bvd"]="boulevard";
+    synonym_map["bld"]="boulevard";
+    synonym_map["bd"]="boulevard";
+    synonym_map["b"]="boulevard";
+    synonym_map["r"]="rue";
+    synonym_map["pl"]="place";
+    const SynonymAutomaton synonyms(synonym_map);
 
     Autocomplete<unsigned int> ac;
     ac.add_string("gare de Tours Tours", 0, synonyms);
@@ -649,14 +723,11 @@ BOOST_AUTO_TEST_CASE(autocomplete_duplicate_words_and_weight_test){
     auto res = ac.find_complete("gare", synonyms, nbmax, [](int){return true;});
     BOOST_REQUIRE_EQUAL(res.size(), 8);
     BOOST_CHECK_EQUAL(res.at(0).quality, 100);
-    BOOST_CHECK_EQUAL(res.at(0).idx, 1);
-    BOOST_CHECK_EQUAL(res.at(1).idx, 5);
-    BOOST_CHECK_EQUAL(res.at(2).idx, 2);
-    BOOST_CHECK_EQUAL(res.at(3).idx, 4);
-    BOOST_CHECK_EQUAL(res.at(4).idx, 6);
-    BOOST_CHECK_EQUAL(res.at(5).idx, 0);
-    BOOST_CHECK_EQUAL(res.at(6).idx, 3);
-    BOOST_CHECK_EQUAL(res.at(7).idx, 7);
+    // same score, the results are sorted by number of words, then by idx
+    const std::vector<unsigned int> expected = {0, 2, 3, 5, 6, 7, 1, 4};
+    for (unsigned int i = 0; i < 8; ++i) {
+        BOOST_CHECK_EQUAL(res.at(i).idx, expected[i]);
+    }
     BOOST_CHECK_EQUAL(res.at(7).quality, 100);
 
 
@@ -673,6 +744,272 @@ BOOST_AUTO_TEST_CASE(autocomplete_duplicate_words_and_weight_test){
     BOOST_CHECK_EQUAL(res3.at(0).quality, 100);
 }
 
+BOOST_AUTO_TEST_CASE(find_with_frequent_words_test){
+    // "rue" and "paris" are frequent enough to have a bitmap
+    const SynonymAutomaton synonyms;
+    Autocomplete<unsigned int> ac;
+    for (unsigned int i = 0; i < 2000; ++i) {
+        std::string name = (i % 3 == 0 ? "avenue " : "rue ") + std::string("nom") + std::to_string(i % 100);
+        if (i % 2 == 0) { name += " paris"; }
+        ac.add_string(name, i, synonyms);
+    }
+    ac.build();
+    BOOST_REQUIRE(ac.word_dictionnary.bitmap(ac.word_dictionnary.prefix_range("rue").first));
+    BOOST_REQUIRE(ac.word_dictionnary.bitmap(ac.word_dictionnary.prefix_range("paris").first));
+
+    std::vector<unsigned int> expected;
+    for (unsigned int i = 0; i < 2000; ++i) {
+        if (i % 3 != 0 && i % 2 == 0 && i % 100 == 42) { expected.push_back(i); }
+    }
+    const auto res = ac.find({"rue", "nom42", "paris"});
+    BOOST_CHECK_EQUAL_COLLECTIONS(res.begin(), res.end(), expected.begin(), expected.end());
+
+    // "nom4" matches nom4 and nom40..nom49
+    expected.clear();
+    for (unsigned int i = 0; i < 2000; ++i) {
+        const auto n = i % 100;
+        if (i % 3 != 0 && i % 2 == 0 && (n == 4 || (n >= 40 && n < 50))) { expected.push_back(i); }
+    }
+    const auto res2 = ac.find({"ru", "nom4", "par"});
+    BOOST_CHECK_EQUAL_COLLECTIONS(res2.begin(), res2.end(), expected.begin(), expected.end());
+
+    BOOST_CHECK(ac.find({"rue", "unknown"}).empty());
+}
+
+BOOST_AUTO_TEST_CASE(find_top_k_by_score_test){
+    const SynonymAutomaton synonyms;
+    Autocomplete<unsigned int> ac;
+    ac.add_string("gare de Tours", 0, synonyms);
+    ac.add_string("gare de Blois", 1, synonyms);
+    ac.add_string("gare de Dreux", 2, synonyms);
+    ac.add_string("gare de Vierzon", 3, synonyms);
+    ac.add_string("gare de Lucé", 4, synonyms);
+    ac.add_string("rue de la gare", 5, synonyms);
+    ac.build();
+
+    std::vector<int> scores = {10, 50, 0, 80, 50, 20};
+    for (unsigned int i = 0; i < scores.size(); ++i) {
+        ac.word_quality_list[i].score = scores[i];
+    }
+    ac.rank_by_score();
+
+    // only the nbmax best scores are read
+    auto res = ac.find_complete("gare", synonyms, 3, [](int){return true;});
+    BOOST_REQUIRE_EQUAL(res.size(), 3);
+    BOOST_CHECK_EQUAL(res.at(0).idx, 3);
+    BOOST_CHECK_EQUAL(res.at(1).idx, 1);
+    BOOST_CHECK_EQUAL(res.at(2).idx, 4);
+
+    res = ac.find_complete("gare de", synonyms, 2, [](int idx){return idx != 3;});
+    BOOST_REQUIRE_EQUAL(res.size(), 2);
+    BOOST_CHECK_EQUAL(res.at(0).idx, 1);
+    BOOST_CHECK_EQUAL(res.at(1).idx, 4);
+
+    // find still gives the positions
+    const auto positions = ac.find({"ga", "de"});
+    const std::vector<unsigned int> expected = {0, 1, 2, 3, 4, 5};
+    BOOST_CHECK_EQUAL_COLLECTIONS(positions.begin(), positions.end(), expected.begin(), expected.end());
+
+    // the max score of the n-gram search is the one of the best object kept
+    res = ac.find_partial_with_pattern("gare vierzo", synonyms, 5, 10, [](int){return true;});
+    BOOST_REQUIRE(! res.empty());
+    BOOST_CHECK_EQUAL(res.at(0).idx, 3);
+    BOOST_CHECK_EQUAL(res.at(0).score, 80);
+}
+
+BOOST_AUTO_TEST_CASE(find_fuzzy_test){
+    const SynonymAutomaton synonyms;
+    int word_weight = 5;
+    Autocomplete<unsigned int> ac;
+    ac.add_string("gare de Versailles Chantiers", 0, synonyms);
+    ac.add_string("gare de Versailles Rive Droite", 1, synonyms);
+    ac.add_string("Vernaison", 2, synonyms);
+    ac.add_string("gare de Lyon", 3, synonyms);
+    ac.add_string("gare de Marseille", 4, synonyms);
+    ac.add_string("gare de Marsillargues", 5, synonyms);
+    ac.build();
+
+    // exact words, distance 0
+    auto res = ac.find_fuzzy("gare versailles", synonyms, word_weight, 10, [](int){return true;});
+    BOOST_REQUIRE_EQUAL(res.size(), 2);
+    BOOST_CHECK_EQUAL(res.at(0).idx, 0);
+    BOOST_CHECK_EQUAL(res.at(1).idx, 1);
+    BOOST_CHECK_EQUAL(res.at(0).quality, 100);
+
+    // a substitution and a missing letter
+    res = ac.find_fuzzy("gare versaiels", synonyms, word_weight, 10, [](int){return true;});
+    BOOST_REQUIRE_EQUAL(res.size(), 2);
+    BOOST_CHECK_EQUAL(res.at(0).idx, 0);
+    BOOST_CHECK_EQUAL(res.at(0).quality, 90);
+
+    // the best distance first: "marseile" is at 1 of "marseille", at 2 of "marsill"
+    res = ac.find_fuzzy("garre marseile", synonyms, word_weight, 10, [](int){return true;});
+    BOOST_REQUIRE_EQUAL(res.size(), 2);
+    BOOST_CHECK_EQUAL(res.at(0).idx, 4);
+    BOOST_CHECK_EQUAL(res.at(0).quality, 90);
+    BOOST_CHECK_EQUAL(res.at(1).idx, 5);
+    BOOST_CHECK_EQUAL(res.at(1).quality, 85);
+
+    // a short word can only have one typo
+    res = ac.find_fuzzy("vrena", synonyms, word_weight, 10, [](int){return true;});
+    BOOST_CHECK(res.empty());
+    res = ac.find_fuzzy("venrais", synonyms, word_weight, 10, [](int){return true;});
+    BOOST_REQUIRE_EQUAL(res.size(), 1);
+    BOOST_CHECK_EQUAL(res.at(0).idx, 2);
+
+    res = ac.find_fuzzy("gare marseile", synonyms, word_weight, 10, [](int idx){return idx != 4;});
+    BOOST_REQUIRE_EQUAL(res.size(), 1);
+    BOOST_CHECK_EQUAL(res.at(0).idx, 5);
+}
+
+BOOST_AUTO_TEST_CASE(find_in_admins_test){
+    const SynonymAutomaton synonyms;
+    int word_weight = 5;
+    Autocomplete<unsigned int> ac;
+    ac.add_string("gare de Quimper", 0, synonyms);
+    ac.add_string("gare de Brest", 1, synonyms);
+    ac.add_string("gare routière de Quimper", 2, synonyms);
+    ac.add_string("gare de Morlaix", 3, synonyms);
+    ac.build();
+
+    Admin quimper, brest, finistere;
+    quimper.idx = 0;
+    brest.idx = 1;
+    finistere.idx = 2;
+    std::vector<navitia::type::StopArea> stop_areas(4);
+    stop_areas[0].admin_list = {&quimper, &finistere};
+    stop_areas[1].admin_list = {&brest, &finistere};
+    stop_areas[2].admin_list = {&quimper, &finistere};
+    stop_areas[3].admin_list = {&finistere};
+    std::vector<navitia::type::StopArea*> objects;
+    for (auto& sa: stop_areas) { objects.push_back(&sa); }
+    ac.build_admin_index(objects, 3);
+
+    // the index follows the ranks when the scores change
+    ac.word_quality_list[2].score = 50;
+    ac.rank_by_score();
+
+    auto ranks = ac.ranks_in_admins({0});
+    auto res = ac.find_complete("gare", synonyms, 10, [](int){return true;}, &ranks);
+    BOOST_REQUIRE_EQUAL(res.size(), 2);
+    BOOST_CHECK_EQUAL(res.at(0).idx, 2);
+    BOOST_CHECK_EQUAL(res.at(1).idx, 0);
+
+    ranks = ac.ranks_in_admins({0, 1});
+    res = ac.find_complete("gare de", synonyms, 10, [](int){return true;}, &ranks);
+    BOOST_REQUIRE_EQUAL(res.size(), 3);
+    BOOST_CHECK_EQUAL(res.at(0).idx, 2);
+    BOOST_CHECK_EQUAL(res.at(1).idx, 0);
+    BOOST_CHECK_EQUAL(res.at(2).idx, 1);
+
+    ranks = ac.ranks_in_admins({2});
+    BOOST_CHECK_EQUAL(ranks.size(), 4);
+
+    ranks = ac.ranks_in_admins({1});
+    res = ac.find_partial_with_pattern("gare brest", synonyms, word_weight, 10, [](int){return true;}, &ranks);
+    BOOST_REQUIRE_EQUAL(res.size(), 1);
+    BOOST_CHECK_EQUAL(res.at(0).idx, 1);
+    res = ac.find_fuzzy("gare quimpre", synonyms, word_weight, 10, [](int){return true;}, &ranks);
+    BOOST_CHECK(res.empty());
+}
+
+BOOST_AUTO_TEST_CASE(dictionary_front_coding_and_posting_lists_test){
+    // more words than a block to check the front coding across the blocks
+    std::map<std::string, std::vector<unsigned int>> words;
+    for (unsigned int i = 0; i < 50; ++i) {
+        words["gare" + std::to_string(100 + i)] = {i, i + 1000, i + 1000000};
+    }
+    words["garennes"] = {3};
+    words["rue"] = {0, 2};
+    words["ru"] = {42};
+
+    Dictionary<unsigned int> dict;
+    for (const auto& word: words) {
+        dict.push_back(word.first, word.second);
+    }
+    BOOST_REQUIRE_EQUAL(dict.size(), words.size());
+
+    unsigned int idx = 0;
+    for (const auto& word: words) {
+        BOOST_CHECK_EQUAL(dict.word(idx), word.first);
+        std::vector<unsigned int> postings;
+        dict.for_each_posting(idx, [&](unsigned int i) { postings.push_back(i); });
+        BOOST_CHECK_EQUAL_COLLECTIONS(postings.begin(), postings.end(), word.second.begin(), word.second.end());
+        ++idx;
+    }
+
+    auto range = dict.prefix_range("gare");
+    BOOST_CHECK_EQUAL(range.first, 0);
+    BOOST_CHECK_EQUAL(range.second, 51);
+    range = dict.prefix_range("gare12");
+    BOOST_CHECK_EQUAL(dict.word(range.first), "gare120");
+    BOOST_CHECK_EQUAL(range.second - range.first, 10);
+    range = dict.prefix_range("garen");
+    BOOST_CHECK_EQUAL(range.second - range.first, 1);
+    BOOST_CHECK_EQUAL(dict.word(range.first), "garennes");
+    range = dict.prefix_range("ru");
+    BOOST_CHECK_EQUAL(range.second - range.first, 2);
+    size_t nb_postings = 0;
+    dict.for_each_posting(range, [&](unsigned int) { ++nb_postings; });
+    BOOST_CHECK_EQUAL(nb_postings, 3);
+    range = dict.prefix_range("avenue");
+    BOOST_CHECK_EQUAL(range.first, range.second);
+    range = dict.prefix_range("zzz");
+    BOOST_CHECK_EQUAL(range.first, dict.size());
+    BOOST_CHECK_EQUAL(range.second, dict.size());
+}
+
+BOOST_AUTO_TEST_CASE(build_by_sorting_test){
+    const SynonymAutomaton synonyms;
+    Autocomplete<unsigned int> ac;
+    ac.add_string("rue de la paix", 2, synonyms);
+    ac.add_string("rue a", 0, synonyms);
+    ac.add_string("paix paix", 5, synonyms);
+    ac.add_string("çà", 3, synonyms);
+    ac.build();
+
+    std::vector<std::string> words;
+    std::vector<std::vector<unsigned int>> postings;
+    for (size_t i = 0; i < ac.word_dictionnary.size(); ++i) {
+        words.push_back(ac.word_dictionnary.word(i));
+        postings.emplace_back();
+        ac.word_dictionnary.for_each_posting(i, [&](unsigned int rank) {
+            postings.back().push_back(ac.rank_to_idx[rank]);
+        });
+    }
+    std::vector<std::string> expected_words = {"a", "ca", "de", "la", "paix", "rue"};
+    BOOST_CHECK_EQUAL_COLLECTIONS(words.begin(), words.end(), expected_words.begin(), expected_words.end());
+    BOOST_REQUIRE_EQUAL(postings.size(), 6);
+    // the elements with the fewest words are first
+    std::vector<unsigned int> expected = {5, 2};
+    BOOST_CHECK_EQUAL_COLLECTIONS(postings[4].begin(), postings[4].end(), expected.begin(), expected.end());
+    expected = {0, 2};
+    BOOST_CHECK_EQUAL_COLLECTIONS(postings[5].begin(), postings[5].end(), expected.begin(), expected.end());
+
+    // the 2-grams of the words, and the words of one letter
+    auto range = ac.pattern_dictionnary.prefix_range("a");
+    words.clear();
+    for (size_t i = range.first; i < range.second; ++i) { words.push_back(ac.pattern_dictionnary.word(i)); }
+    expected_words = {"a", "ai"};
+    BOOST_CHECK_EQUAL_COLLECTIONS(words.begin(), words.end(), expected_words.begin(), expected_words.end());
+    BOOST_CHECK(ac.temp_word_postings.empty());
+    BOOST_CHECK(ac.temp_pattern_postings.empty());
+}
+
+BOOST_AUTO_TEST_CASE(build_in_parallel_test){
+    std::vector<int> built(10, 0);
+    std::vector<std::function<void()>> builds;
+    for (size_t i = 0; i < built.size(); ++i) {
+        builds.push_back([&built, i]() { built[i] = 1; });
+    }
+    build_in_parallel(builds);
+    BOOST_CHECK_EQUAL(std::count(built.begin(), built.end(), 1), 10);
+
+    // an error in a build is given to the caller
+    builds.push_back([]() { throw std::runtime_error("bad data"); });
+    BOOST_CHECK_THROW(build_in_parallel(builds), std::runtime_error);
+}
+
 /*
 1. We have 1 administrative_region and 11  stop_area
 2. All the stop_areas are attached to the same administrative_region.
@@ -0,0 +1,225 @@
+/* Copyright © 2001-2014, Canal TP and/or its affiliates. All rights reserved.
+
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+Stay tuned using
+twitter @navitia
+IRC #navitia on freenode
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#include "tokenizer.h"
+#include <algorithm>
+
+namespace navitia { namespace autocomplete {
+
+namespace {
+
+/// les lettres et chiffres ASCII en minuscules, 0 pour les autres octets qui séparent les mots
+struct AsciiTable {
+    char lower[128];
+    AsciiTable() {
+        for (int c = 0; c < 128; ++c) {
+            lower[c] = 0;
+            if ((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z')) { lower[c] = char(c); }
+            if (c >= 'A' && c <= 'Z') { lower[c] = char(c - 'A' + 'a'); }
+        }
+    }
+};
+const AsciiTable ascii_table;
+
+/// U+00C0 to U+00FF (0xC3 0x80 to 0xC3 0xBF in UTF-8) without accent, nullptr for the signs to keep
+const char* const latin1_letters[64] = {
+    "a", "a", "a", "a", "a", "a", "ae", "c", "e", "e", "e", "e", "i", "i", "i", "i",
+    "d", "n", "o", "o", "o", "o", "o", nullptr, "o", "u", "u", "u", "u", "y", nullptr, "ss",
+    "a", "a", "a", "a", "a", "a", "ae", "c", "e", "e", "e", "e", "i", "i", "i", "i",
+    "d", "n", "o", "o", "o", "o", "o", nullptr, "o", "u", "u", "u", "u", "y", nullptr, "y"
+};
+
+enum class CharKind { ascii, letter, separator, other };
+
+/// lit le caractère UTF-8 commençant à str[i] et retourne sa longueur en octets;
+/// folded is set to the letter without accent for CharKind::letter
+size_t read_char(const std::string& str, size_t i, CharKind& kind, const char*& folded) {
+    const unsigned char c = str[i];
+    if (c < 0x80) {
+        kind = CharKind::ascii;
+        return 1;
+    }
+    const unsigned char next = i + 1 < str.size() ? str[i + 1] : 0;
+    if (c == 0xC3 && next >= 0x80 && next <= 0xBF && latin1_letters[next - 0x80]) {
+        kind = CharKind::letter;
+        folded = latin1_letters[next - 0x80];
+        return 2;
+    }
+    if (c == 0xC5 && (next == 0x92 || next == 0x93)) {
+        kind = CharKind::letter;
+        folded = "oe";
+        return 2;
+    }
+    if (c == 0xC2 && next >= 0x80 && next <= 0xBF) {
+        // latin-1 punctuation: no-break space, «, », °...
+        kind = CharKind::separator;
+        return 2;
+    }
+    // the other characters are copied byte by byte
+    kind = CharKind::other;
+    return 1;
+}
+
+} // namespace
+
+void Tokens::sort_unique() {
+    std::sort(words.begin(), words.begin() + nb_words);
+    nb_words = std::unique(words.begin(), words.begin() + nb_words) - words.begin();
+}
+
+void normalize(const std::string& str, Tokens& tokens) {
+    tokens.clear();
+    std::string* word = nullptr;
+    for (size_t i = 0; i < str.size();) {
+        CharKind kind;
+        const char* folded = nullptr;
+        const size_t len = read_char(str, i, kind, folded);
+        char ascii = 0;
+        if (kind == CharKind::ascii) {
+            ascii = ascii_table.lower[static_cast<unsigned char>(str[i])];
+        }
+        if (kind == CharKind::separator || (kind == CharKind::ascii && ascii == 0)) {
+            word = nullptr;
+        } else {
+            if (! word) { word = &tokens.new_word(); }
+            if (kind == CharKind::ascii) {
+                word->push_back(ascii);
+            } else if (kind == CharKind::letter) {
+                word->append(folded);
+            } else {
+                word->append(str, i, len);
+            }
+        }
+        i += len;
+    }
+}
+
+std::string strip_accents(const std::string& str) {
+    std::string result;
+    result.reserve(str.size());
+    for (size_t i = 0; i < str.size();) {
+        CharKind kind;
+        const char* folded = nullptr;
+        const size_t len = read_char(str, i, kind, folded);
+        if (kind == CharKind::letter) {
+            result.append(folded);
+        } else {
+            result.append(str, i, len);
+        }
+        i += len;
+    }
+    return result;
+}
+
+SynonymAutomaton::SynonymAutomaton(const autocomplete_map& synonyms) {
+    // temporary trie, flattened at the end
+    std::vector<std::map<std::string, uint32_t>> children(1);
+    node_values.push_back(-1);
+    Tokens key, value;
+    for (const auto& synonym: synonyms) {
+        normalize(synonym.first, key);
+        if (key.empty()) { continue; }
+        uint32_t node = 0;
+        for (const auto& word: key) {
+            const auto it = children[node].find(word);
+            if (it != children[node].end()) {
+                node = it->second;
+                continue;
+            }
+            const uint32_t child = children.size();
+            children[node][word] = child;
+            children.emplace_back();
+            node_values.push_back(-1);
+            node = child;
+        }
+        // two keys can be the same once normalized ("c.h.u" and "c h u"), the first one in the map is kept
+        if (node_values[node] != -1) { continue; }
+        normalize(synonym.second, value);
+        node_values[node] = values.size();
+        values.emplace_back(value.begin(), value.end());
+    }
+
+    edge_offsets.reserve(children.size() + 1);
+    for (const auto& node_children: children) {
+        edge_offsets.push_back(edges.size());
+        for (const auto& child: node_children) {
+            edges.push_back({child.first, child.second});
+        }
+    }
+    edge_offsets.push_back(edges.size());
+}
+
+uint32_t SynonymAutomaton::next(uint32_t node, const std::string& word) const {
+    const auto begin = edges.begin() + edge_offsets[node];
+    const auto end = edges.begin() + edge_offsets[node + 1];
+    const auto it = std::lower_bound(begin, end, word,
+                                     [](const Edge& edge, const std::string& w) { return edge.word < w; });
+    if (it == end || it->word != word) { return 0; }
+    return it->to;
+}
+
+void SynonymAutomaton::apply(const Tokens& in, Tokens& out) const {
+    out.clear();
+    for (size_t i = 0; i < in.size();) {
+        // longest key starting at the word i
+        int32_t value = -1;
+        size_t key_end = i;
+        uint32_t node = 0;
+        for (size_t j = i; j < in.size() && ! empty(); ++j) {
+            node = next(node, in[j]);
+            if (node == 0) { break; }
+            if (node_values[node] != -1) {
+                value = node_values[node];
+                key_end = j + 1;
+            }
+        }
+        if (value == -1) {
+            out.new_word() = in[i];
+            ++i;
+            continue;
+        }
+        for (const auto& word: values[value]) {
+            out.new_word() = word;
+        }
+        i = key_end;
+    }
+}
+
+void SynonymAutomaton::tokenize(const std::string& str, Tokens& out) const {
+    if (empty()) {
+        normalize(str, out);
+        return;
+    }
+    thread_local Tokens words;
+    normalize(str, words);
+    apply(words, out);
+}
+
+}} // namespace navitia::autocomplete
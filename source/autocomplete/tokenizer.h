@@ -0,0 +1,126 @@
+/* Copyright © 2001-2014, Canal TP and/or its affiliates. All rights reserved.
+
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+Stay tuned using
+twitter @navitia
+IRC #navitia on freenode
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdint>
+
+namespace navitia { namespace autocomplete {
+
+struct Compare {
+    bool operator()(const  std::string& str_a, const std::string& str_b) const {
+        if(str_a.length() == str_b.length()){
+            return str_a >= str_b;
+        }else{
+            return (str_a.length() > str_b.length());
+        }
+    }
+};
+
+using autocomplete_map = std::map<std::string, std::string, Compare>;
+
+/** Liste de mots réutilisable
+  *
+  * The strings are kept between two uses, so once warm, cutting a string in words does not allocate
+  */
+struct Tokens {
+    std::vector<std::string> words;
+    size_t nb_words = 0;
+
+    void clear() { nb_words = 0; }
+    size_t size() const { return nb_words; }
+    bool empty() const { return nb_words == 0; }
+    const std::string& operator[](size_t i) const { return words[i]; }
+    std::vector<std::string>::const_iterator begin() const { return words.begin(); }
+    std::vector<std::string>::const_iterator end() const { return words.begin() + nb_words; }
+
+    /// ajoute un mot vide à la fin et le retourne
+    std::string& new_word() {
+        if (nb_words == words.size()) { words.emplace_back(); }
+        std::string& word = words[nb_words++];
+        word.clear();
+        return word;
+    }
+    void pop_word() { --nb_words; }
+
+    /// trie les mots et supprime les doublons
+    void sort_unique();
+};
+
+/** Découpe str en mots, en minuscules et sans accents
+  *
+  * One pass on the UTF-8 bytes with a table: the ASCII letters and digits are lowered, the latin-1 letters
+  * lose their accents ("é" -> "e", "œ" -> "oe", "ß" -> "ss"), everything else in ASCII and in the latin-1
+  * punctuation splits the words. The other UTF-8 characters are kept as they are.
+  */
+void normalize(const std::string& str, Tokens& tokens);
+
+/// Retire les accents de str sans changer le reste (no lowering, no split)
+std::string strip_accents(const std::string& str);
+
+/** Automate des synonymes
+  *
+  * The keys and the values are cut in words with normalize, the keys are stored in a trie on the words.
+  * Applying the synonyms is a walk of the trie from each word: the longest key starting at a word is replaced
+  * by its value, and the walk starts again after the key. A value is never rewritten by another synonym.
+  */
+class SynonymAutomaton {
+public:
+    SynonymAutomaton() {}
+    /// explicit: the automaton must be built once, not at each call taking a map
+    explicit SynonymAutomaton(const autocomplete_map& synonyms);
+
+    bool empty() const { return values.empty(); }
+
+    /// écrit dans out les mots de in, les synonymes remplacés
+    void apply(const Tokens& in, Tokens& out) const;
+
+    /// normalize puis apply; les buffers intermédiaires sont par thread
+    void tokenize(const std::string& str, Tokens& out) const;
+
+private:
+    struct Edge {
+        std::string word;
+        uint32_t to;
+    };
+    /// the edges leaving the node n are edges[edge_offsets[n], edge_offsets[n + 1]), sorted by word
+    std::vector<Edge> edges;
+    std::vector<uint32_t> edge_offsets;
+    /// index in values of the synonym ending at each node, -1 if none
+    std::vector<int32_t> node_values;
+    std::vector<std::vector<std::string>> values;
+
+    /// nœud atteint depuis node par word, 0 (the root can not be reached) if none
+    uint32_t next(uint32_t node, const std::string& word) const;
+};
+
+}} // namespace navitia::autocomplete
@@ -37,6 +37,8 @@ www.navitia.io
 #include "utils/init.h"
 #include "utils/functions.h"
 #include "type/meta_data.h"
+#include "type/pt_data.h"
+#include "georef/street_network.h"
 
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/program_options.hpp>
@@ -45,6 +47,7 @@ www.navitia.io
 #include <pqxx/pqxx>
 #include <iostream>
 #include <fstream>
+#include <thread>
 
 namespace po = boost::program_options;
 namespace pt = boost::posix_time;
@@ -134,6 +137,8 @@ int main(int argc, char * argv[])
     auto logger = log4cplus::Logger::getInstance("log");
     std::string output, connection_string, region_name, cities_connection_string;
     double min_non_connected_graph_ratio;
+    int connections_max_duration;
+    size_t nb_threads;
     po::options_description desc("Allowed options");
     desc.add_options()
         ("help,h", "Show this message")
@@ -146,6 +151,11 @@ int main(int argc, char * argv[])
         ("min_non_connected_ratio,m",
          po::value<double>(&min_non_connected_graph_ratio)->default_value(0.1),
          "min ratio for the size of non connected graph")
+        ("connections-max-duration", po::value<int>(&connections_max_duration)->default_value(0),
+         "add the walking connections between stop points up to this duration (in seconds) "
+         "on the street network (0 to disable it)")
+        ("nb-threads", po::value<size_t>(&nb_threads)->default_value(std::max(1u, std::thread::hardware_concurrency())),
+         "number of threads used to compute the walking connections")
         ("connection-string", po::value<std::string>(&connection_string)->required(),
          "database connection parameters: host=localhost user=navitia dbname=navitia password=navitia")
         ("cities-connection-string", po::value<std::string>(&cities_connection_string)->default_value(""),
@@ -204,6 +214,15 @@ int main(int argc, char * argv[])
 
     read = (pt::microsec_clock::local_time() - start).total_milliseconds();
     data.complete();
+
+    if (connections_max_duration > 0) {
+        start = pt::microsec_clock::local_time();
+        LOG4CPLUS_INFO(logger, "Building street network connections");
+        const auto nb_connections = georef::build_street_network_connections(*data.pt_data, *data.geo_ref,
+                navitia::seconds(connections_max_duration), nb_threads);
+        LOG4CPLUS_INFO(logger, nb_connections << " street network connections added in "
+                       << (pt::microsec_clock::local_time() - start).total_milliseconds() << "ms");
+    }
     data.meta->publication_date = pt::microsec_clock::local_time();
 
     LOG4CPLUS_INFO(logger, "line: " << data.pt_data->lines.size());
@@ -36,8 +36,11 @@ www.navitia.io
 #include "utils/configuration.h"
 
 #include <boost/foreach.hpp>
+#include <boost/tokenizer.hpp>
 #include <boost/geometry.hpp>
 #include <boost/math/constants/constants.hpp>
+#include <boost/range/algorithm/sort.hpp>
+#include <boost/range/algorithm/lower_bound.hpp>
 #include <array>
 #include <unordered_map>
 
@@ -387,42 +390,53 @@ static const Admin* find_city_admin(const std::vector<Admin*>& admins) {
 }
 
 void GeoRef::build_autocomplete_list(){
-    int pos = -1;
-    fl_way.clear();
-    for (Way* way: ways) {
-        ++pos;
-        if (way->name.empty()) { continue; }
-        if (auto admin = find_city_admin(way->admin_list)) {
-            std::string key = way->way_type + " " + way->name + " " + admin->name;
-            if (!admin->post_code.empty()) { key += " " + admin->post_code; }
-            fl_way.add_string(key, pos, this->synonyms);
-        }
-    }
-    fl_way.build();
-
-    fl_poi.clear();
-    //Autocomplete poi list
-    for(const POI* poi : pois){
-        if (poi->name.empty() || !poi->visible) { continue; }
-        std::string key = poi->name;
-        if (auto admin = find_city_admin(poi->admin_list)) {
-            key += " " + admin->name;
-        }
-        fl_poi.add_string(key, poi->idx , this->synonyms);
-    }
-    fl_poi.build();
-
-    fl_admin.clear();
-    for(Admin* admin : admins){
-        std::string key="";
-
-        if (!admin->post_code.empty())
-        {
-            key = admin->post_code;
+    synonym_automaton = navitia::autocomplete::SynonymAutomaton(synonyms);
+    // the ways, the pois and the admins are indexed at the same time
+    navitia::autocomplete::build_in_parallel({
+        [&]() {
+            int pos = -1;
+            fl_way.clear();
+            for (Way* way: ways) {
+                ++pos;
+                if (way->name.empty()) { continue; }
+                if (auto admin = find_city_admin(way->admin_list)) {
+                    std::string key = way->way_type + " " + way->name + " " + admin->name;
+                    if (!admin->post_code.empty()) { key += " " + admin->post_code; }
+                    fl_way.add_string(key, pos, this->synonym_automaton);
+                }
+            }
+            fl_way.build();
+            fl_way.build_admin_index(ways, admins.size());
+        },
+        [&]() {
+            fl_poi.clear();
+            //Autocomplete poi list
+            for(const POI* poi : pois){
+                if (poi->name.empty() || !poi->visible) { continue; }
+                std::string key = poi->name;
+                if (auto admin = find_city_admin(poi->admin_list)) {
+                    key += " " + admin->name;
+                }
+                fl_poi.add_string(key, poi->idx , this->synonym_automaton);
+            }
+            fl_poi.build();
+            fl_poi.build_admin_index(pois, admins.size());
+        },
+        [&]() {
+            fl_admin.clear();
+            for(Admin* admin : admins){
+                std::string key="";
+
+                if (!admin->post_code.empty())
+                {
+                    key = admin->post_code;
+                }
+                fl_admin.add_string(admin->name + " " + key, admin->idx , this->synonym_automaton);
+            }
+            fl_admin.build();
+            fl_admin.build_admin_index(admins, admins.size());
         }
-        fl_admin.add_string(admin->name + " " + key, admin->idx , this->synonyms);
-    }
-    fl_admin.build();
+    });
 }
 
 
@@ -465,7 +479,8 @@ void GeoRef::build_admin_map(){
     * Si le numéro est rensigné, on renvoie les coordonnées les plus proches
     * Sinon le barycentre de la rue
 */
-std::vector<nf::Autocomplete<nt::idx_t>::fl_quality> GeoRef::find_ways(const std::string & str, const int nbmax, const int search_type, std::function<bool(nt::idx_t)> keep_element) const{
+std::vector<nf::Autocomplete<nt::idx_t>::fl_quality> GeoRef::find_ways(const std::string & str, const int nbmax, const int search_type, std::function<bool(nt::idx_t)> keep_element,
+                                                                         const std::vector<nt::idx_t>& admins) const{
     std::vector<nf::Autocomplete<nt::idx_t>::fl_quality> to_return;
     boost::tokenizer<> tokens(str);
 
@@ -485,10 +500,17 @@ std::vector<nf::Autocomplete<nt::idx_t>::fl_quality> GeoRef::find_ways(const std
     }else{
         search_str = str;
     }
+    std::vector<nt::idx_t> admin_ranks;
+    if (! admins.empty()) {
+        admin_ranks = fl_way.ranks_in_admins(admins);
+    }
+    const std::vector<nt::idx_t>* filter = admins.empty() ? nullptr : &admin_ranks;
     if (search_type == 0){
-        to_return = fl_way.find_complete(search_str, this->synonyms, nbmax, keep_element);
+        to_return = fl_way.find_complete(search_str, this->synonym_automaton, nbmax, keep_element, filter);
+    }else if (search_type == 2){
+        to_return = fl_way.find_fuzzy(search_str, this->synonym_automaton, word_weight, nbmax, keep_element, filter);
     }else{
-        to_return = fl_way.find_partial_with_pattern(search_str, this->synonyms, word_weight, nbmax, keep_element);
+        to_return = fl_way.find_partial_with_pattern(search_str, this->synonym_automaton, word_weight, nbmax, keep_element, filter);
     }
 
     /// récupération des coordonnées du numéro recherché pour chaque rue
@@ -570,44 +592,185 @@ void GeoRef::project_stop_points(const std::vector<type::StopPoint*> &stop_point
    }
 }
 
+nt::GeographicalCoord GeoRef::way_centroid(const Way* way) const {
+    if (way->idx < way_centroids.size()) {
+        return way_centroids[way->idx];
+    }
+    return way->projected_centroid(graph);
+}
+
+void GeoRef::build_admin_index() {
+    way_centroids.clear();
+    way_centroids.reserve(ways.size());
+    for (const Way* way: ways) {
+        way_centroids.push_back(way->projected_centroid(graph));
+    }
+    admin_index.build(*this, find_admins_radius);
+}
+
 const std::vector<Admin*> GeoRef::find_admins(const type::GeographicalCoord& coord) const {
+    if (const auto* admins = admin_index.find(coord)) {
+        return *admins;
+    }
+
     // first, we collect each ways with its distance to the coord
-    std::map<const Way*, double> way_dist;
-    for (const auto& pair_coord: pl.find_within(coord)) {
+    std::vector<const Way*> near_ways;
+    for (const auto& pair_coord: pl.find_within(coord, find_admins_radius)) {
         BOOST_FOREACH (edge_t e, boost::out_edges(pair_coord.first, graph)) {
             const Way* w = ways[graph[e].way_idx];
             if (w->admin_list.empty()) { continue; }
-            if (way_dist.count(w) == 0) {
-                way_dist[w] = coord.distance_to(w->projected_centroid(graph));
-            }
+            near_ways.push_back(w);
         }
     }
-    if (way_dist.empty()) {
+    if (near_ways.empty()) {
         static const std::vector<Admin*> empty;
         return empty;
     }
+    boost::sort(near_ways);
+    near_ways.erase(std::unique(near_ways.begin(), near_ways.end()), near_ways.end());
 
     // then, we search in each way the nearest number or way centroid
-    std::vector<Admin*> result = way_dist.begin()->first->admin_list;
-    float min_dist = way_dist.begin()->second;
-    for (const auto& w_d: way_dist) {
+    std::vector<Admin*> result = near_ways.front()->admin_list;
+    double min_dist = std::numeric_limits<double>::max();
+    for (const Way* w: near_ways) {
         // way centroid
-        if (w_d.second < min_dist) {
-            result = w_d.first->admin_list;
-            min_dist = w_d.second;
+        const double centroid_dist = coord.distance_to(way_centroid(w));
+        if (centroid_dist < min_dist) {
+            result = w->admin_list;
+            min_dist = centroid_dist;
         }
 
         // number
-        const auto &nb_dist = w_d.first->nearest_number(coord);
+        const auto &nb_dist = w->nearest_number(coord);
         if (nb_dist.first <= 0) { continue; }
         if (nb_dist.second <= min_dist) {
-            result = w_d.first->admin_list;
+            result = w->admin_list;
             min_dist = nb_dist.second;
         }
     }
     return result;
 }
 
+void AdminIndex::clear() {
+    cells.clear();
+    admin_lists.clear();
+    nb_lon = 0;
+}
+
+int64_t AdminIndex::cell_id(const type::GeographicalCoord& coord) const {
+    if (nb_lon == 0) { return -1; }
+    const double x = (coord.lon() - min_coord.lon()) / cell_lon;
+    const double y = (coord.lat() - min_coord.lat()) / cell_lat;
+    if (x < 0 || y < 0 || x >= nb_lon) { return -1; }
+    return int64_t(y) * nb_lon + int64_t(x);
+}
+
+const std::vector<Admin*>* AdminIndex::find(const type::GeographicalCoord& coord) const {
+    const auto id = cell_id(coord);
+    if (id < 0) { return nullptr; }
+    const auto it = std::lower_bound(cells.begin(), cells.end(), std::make_pair(uint64_t(id), uint32_t(0)));
+    if (it == cells.end() || it->first != uint64_t(id)) { return nullptr; }
+    return &admin_lists[it->second];
+}
+
+void AdminIndex::build(const GeoRef& geo_ref, double radius) {
+    clear();
+    if (geo_ref.nb_vertex_by_mode == 0) { return; }
+    constexpr double deg_to_rad = 0.0174532925199432958;
+    // we take some margin on the distances since the proximity list uses an approximation
+    constexpr double margin = 1.1;
+    constexpr double m_by_deg = 111320;
+
+    // only the walking graph is indexed in the proximity list
+    double min_lon = std::numeric_limits<double>::max(), min_lat = min_lon;
+    double max_lon = std::numeric_limits<double>::lowest(), max_lat = max_lon;
+    double min_abs_lat = 90, max_abs_lat = 0;
+    for (vertex_t v = 0; v < geo_ref.nb_vertex_by_mode; ++v) {
+        const auto& c = geo_ref.graph[v].coord;
+        min_lon = std::min(min_lon, c.lon()); max_lon = std::max(max_lon, c.lon());
+        min_lat = std::min(min_lat, c.lat()); max_lat = std::max(max_lat, c.lat());
+        min_abs_lat = std::min(min_abs_lat, std::abs(c.lat()));
+        max_abs_lat = std::max(max_abs_lat, std::abs(c.lat()));
+    }
+    // the cells are at most cell_size wide (where the meridians are the most spaced)
+    cell_lat = cell_size / m_by_deg;
+    cell_lon = cell_size / (m_by_deg * std::cos(min_abs_lat * deg_to_rad));
+    min_coord = type::GeographicalCoord(min_lon, min_lat);
+    nb_lon = uint64_t((max_lon - min_lon) / cell_lon) + 1;
+
+    // the diagonal of a cell must be covered by the radius for a vertex of the cell
+    // to be found from any point of the cell
+    const double half_diagonal = cell_size * std::sqrt(2.) / 2 * margin;
+    if (2 * half_diagonal >= radius) { return; }
+
+    // number of neighbour cells to look at to cover the radius around any point of a cell
+    const double min_cell_width = cell_lon * m_by_deg * std::cos(max_abs_lat * deg_to_rad) / margin;
+    const double reach = (radius + half_diagonal) * margin;
+    const int64_t nb_neighbours_lat = int64_t(std::ceil(reach / (cell_size / margin)));
+    const int64_t nb_neighbours_lon = int64_t(std::ceil(reach / min_cell_width));
+
+    // all the admin lists reachable from each cell
+    std::map<std::vector<Admin*>, uint32_t> admin_list_ids;
+    std::vector<std::pair<uint64_t, uint32_t>> cell_admins;
+    for (vertex_t v = 0; v < geo_ref.nb_vertex_by_mode; ++v) {
+        const auto id = cell_id(geo_ref.graph[v].coord);
+        BOOST_FOREACH (edge_t e, boost::out_edges(v, geo_ref.graph)) {
+            const Way* w = geo_ref.ways[geo_ref.graph[e].way_idx];
+            if (w->admin_list.empty()) { continue; }
+            const auto list_id = admin_list_ids.insert({w->admin_list, uint32_t(admin_list_ids.size())}).first->second;
+            cell_admins.push_back({uint64_t(id), list_id});
+        }
+    }
+    boost::sort(cell_admins);
+    cell_admins.erase(std::unique(cell_admins.begin(), cell_admins.end()), cell_admins.end());
+
+    // for each cell, its admin list or mixed if there are several
+    const uint32_t mixed = std::numeric_limits<uint32_t>::max();
+    std::unordered_map<uint64_t, uint32_t> cell_content;
+    for (const auto& cell_admin: cell_admins) {
+        auto it = cell_content.insert(cell_admin).first;
+        if (it->second != cell_admin.second) { it->second = mixed; }
+    }
+
+    // a cell is resolved if it contains a vertex with admins (so there is always one in the radius)
+    // and if all the cells in the reach have the same admins
+    std::vector<uint32_t> used_ids;
+    for (const auto& content: cell_content) {
+        if (content.second == mixed) { continue; }
+        const int64_t x = content.first % nb_lon, y = content.first / nb_lon;
+        bool resolved = true;
+        for (int64_t ny = y - nb_neighbours_lat; resolved && ny <= y + nb_neighbours_lat; ++ny) {
+            for (int64_t nx = x - nb_neighbours_lon; resolved && nx <= x + nb_neighbours_lon; ++nx) {
+                if (ny < 0 || nx < 0 || nx >= int64_t(nb_lon)) { continue; }
+                const auto it = cell_content.find(uint64_t(ny) * nb_lon + nx);
+                if (it != cell_content.end() && it->second != content.second) { resolved = false; }
+            }
+        }
+        if (resolved) {
+            cells.push_back(content);
+            used_ids.push_back(content.second);
+        }
+    }
+    boost::sort(cells);
+
+    // we only keep the used admin lists, renumbered
+    boost::sort(used_ids);
+    used_ids.erase(std::unique(used_ids.begin(), used_ids.end()), used_ids.end());
+    std::vector<uint32_t> new_ids(admin_list_ids.size(), mixed);
+    admin_lists.resize(used_ids.size());
+    for (const auto& list_id: admin_list_ids) {
+        const auto it = boost::lower_bound(used_ids, list_id.second);
+        if (it == used_ids.end() || *it != list_id.second) { continue; }
+        new_ids[list_id.second] = it - used_ids.begin();
+        admin_lists[new_ids[list_id.second]] = list_id.first;
+    }
+    for (auto& cell: cells) { cell.second = new_ids[cell.second]; }
+
+    auto log = log4cplus::Logger::getInstance("log");
+    LOG4CPLUS_INFO(log, "admin index: " << cells.size() << " resolved cells on "
+                   << cell_content.size() << " cells with admins");
+}
+
 std::pair<GeoRef::ProjectionByMode, bool> GeoRef::project_stop_point(const type::StopPoint* stop_point) const {
     bool one_proj_found = false;
     ProjectionByMode projections;
@@ -670,7 +833,7 @@ std::pair<int, const Way*> GeoRef::nearest_addr(const type::GeographicalCoord& c
             const Way* w = ways[graph[e].way_idx];
             if (w->name.empty()) { continue; }
             if (way_dist.count(w) == 0) {
-                way_dist[w] = coord.distance_to(w->projected_centroid(graph));
+                way_dist[w] = coord.distance_to(way_centroid(w));
             }
         }
     }
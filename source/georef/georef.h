@@ -189,6 +189,42 @@ struct ProjectionData;
 
 struct POI;
 struct POIType;
+struct GeoRef;
+
+/** Index used to answer quickly GeoRef::find_admins
+ *
+ * The admins of a coordinate are the admins of one of the ways reachable
+ * from the vertices around the coordinate (cf GeoRef::find_admins).
+ * The territory is cut in cells; if all the ways that can be reached from any
+ * point of a cell have the same admins, the cell directly gives the answer.
+ * The other cells (near the admin boundaries, outside of the street network)
+ * are not in the index and the complete computation is needed.
+ *
+ * It is not serialized, it is built at the data loading
+ */
+struct AdminIndex {
+    /// size of a cell in meters, the diagonal of a cell has to be smaller than the search radius
+    static constexpr double cell_size = 200;
+
+    type::GeographicalCoord min_coord;
+    double cell_lon = 0; //< width of a cell in degrees
+    double cell_lat = 0; //< height of a cell in degrees
+    uint64_t nb_lon = 0; //< number of cells by row
+
+    /// resolved cells sorted by cell id, with the index of their admins in admin_lists
+    std::vector<std::pair<uint64_t, uint32_t>> cells;
+    std::vector<std::vector<Admin*>> admin_lists;
+
+    void build(const GeoRef& geo_ref, double radius);
+    void clear();
+
+    /// the admins of the coordinate, nullptr if the cell is not resolved
+    const std::vector<Admin*>* find(const type::GeographicalCoord& coord) const;
+
+private:
+    /// -1 if the coord is outside the grid
+    int64_t cell_id(const type::GeographicalCoord& coord) const;
+};
 
 /** All you need about the street network */
 struct GeoRef {
@@ -220,6 +256,14 @@ struct GeoRef {
     /// Indexe tous les nœuds
     proximitylist::ProximityList<vertex_t> pl;
 
+    /// Radius (in meters) of the search of the ways around a coordinate to find its admins
+    static constexpr double find_admins_radius = 500;
+
+    /// Not serialized: precomputed projected centroid of each way, built with the admin index
+    std::vector<nt::GeographicalCoord> way_centroids;
+    /// Not serialized: direct answer of find_admins for most of the coordinates
+    AdminIndex admin_index;
+
     /// for all stop_point, we store it's projection on each graph
     typedef flat_enum_map<nt::Mode_e, ProjectionData> ProjectionByMode;
     std::vector<ProjectionByMode> projected_stop_points = {};
@@ -240,6 +284,8 @@ struct GeoRef {
     /// number of vertex by transportation mode
     nt::idx_t nb_vertex_by_mode;
     navitia::autocomplete::autocomplete_map synonyms;
+    /// synonymes compilés, pas sérialisés : reconstruits au chargement et à la construction de l'autocomplete
+    navitia::autocomplete::SynonymAutomaton synonym_automaton;
     int word_weight = 5; //Pas serialisé : lu dans le fichier ini
 
     void init();
@@ -257,12 +303,20 @@ struct GeoRef {
         ar & ways & way_map & graph & offsets & fl_admin & fl_way & pl & projected_stop_points
                 & admins & admin_map & pois & fl_poi & poitypes &poitype_map & poi_map & synonyms & poi_proximity_list
                 & nb_vertex_by_mode;
+        build_admin_index();
+        synonym_automaton = navitia::autocomplete::SynonymAutomaton(synonyms);
     }
     BOOST_SERIALIZATION_SPLIT_MEMBER()
 
     /** Construit l'indexe spatial */
     void build_proximity_list();
 
+    /// Build the way centroids and the admin index used by find_admins
+    void build_admin_index();
+
+    /// Projected centroid of the way, from the cache if it has been built
+    nt::GeographicalCoord way_centroid(const Way* way) const;
+
     ///  Construit l'indexe autocomplete à partir des rues
     void build_autocomplete_list();
 
@@ -276,7 +330,9 @@ struct GeoRef {
     void build_pois_map();
 
     /// Recherche d'une adresse avec un numéro en utilisant Autocomplete
-    std::vector<nf::Autocomplete<nt::idx_t>::fl_quality> find_ways(const std::string & str, const int nbmax, const int search_type,std::function<bool(nt::idx_t)> keep_element) const;
+    /// if admins is not empty, only the ways of one of these admins are searched
+    std::vector<nf::Autocomplete<nt::idx_t>::fl_quality> find_ways(const std::string & str, const int nbmax, const int search_type,std::function<bool(nt::idx_t)> keep_element,
+                                                                   const std::vector<nt::idx_t>& admins = {}) const;
 
 
     const std::vector<Admin*> find_admins(const type::GeographicalCoord&) const;
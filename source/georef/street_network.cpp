@@ -30,9 +30,14 @@ www.navitia.io
 
 #include "street_network.h"
 #include "type/data.h"
+#include "type/pt_data.h"
 #include "georef.h"
+#include "utils/parallel.h"
 #include <boost/math/constants/constants.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/range/algorithm/sort.hpp>
 #include <chrono>
+#include <set>
 
 namespace navitia { namespace georef {
 
@@ -46,11 +51,68 @@ navitia::time_duration PathFinder::crow_fly_duration(const double distance) cons
     return navitia::seconds(distance / (default_speed[mode_] * speed_factor));
 }
 
-StreetNetwork::StreetNetwork(const GeoRef &geo_ref) :
+StreetNetwork::StreetNetwork(const GeoRef &geo_ref, FallbackCache* cache) :
     geo_ref(geo_ref),
     departure_path_finder(geo_ref),
     arrival_path_finder(geo_ref)
-{}
+{
+    departure_path_finder.cache = cache;
+    arrival_path_finder.cache = cache;
+}
+
+size_t FallbackCache::KeyHash::operator()(const Key& key) const {
+    size_t seed = 0;
+    boost::hash_combine(seed, key.source);
+    boost::hash_combine(seed, key.target);
+    boost::hash_combine(seed, key.source_duration);
+    boost::hash_combine(seed, key.target_duration);
+    boost::hash_combine(seed, static_cast<int>(key.mode));
+    boost::hash_combine(seed, key.speed_factor);
+    boost::hash_combine(seed, key.radius);
+    return seed;
+}
+
+const FallbackCache::Isochrone* FallbackCache::get(const Key& key) {
+    auto it = index.find(key);
+    if (it == index.end()) {
+        ++nb_misses;
+        return nullptr;
+    }
+    ++nb_hits;
+    entries.splice(entries.begin(), entries, it->second);
+    return &it->second->second;
+}
+
+void FallbackCache::add(const Key& key, Isochrone isochrone) {
+    if (! enabled() || isochrone.size() > max_nb_vertices) { return; }
+    auto it = index.find(key);
+    if (it != index.end()) {
+        total_nb_vertices -= it->second->second.size();
+        entries.erase(it->second);
+        index.erase(it);
+    }
+    total_nb_vertices += isochrone.size();
+    entries.emplace_front(key, std::move(isochrone));
+    index[key] = entries.begin();
+    // the new entry fits alone, so it is never removed
+    while (total_nb_vertices > max_nb_vertices) {
+        total_nb_vertices -= entries.back().second.size();
+        index.erase(entries.back().first);
+        entries.pop_back();
+    }
+}
+
+void FallbackCache::set_data_identifier(size_t new_data_identifier) {
+    if (new_data_identifier == data_identifier) { return; }
+    clear();
+    data_identifier = new_data_identifier;
+}
+
+void FallbackCache::clear() {
+    index.clear();
+    entries.clear();
+    total_nb_vertices = 0;
+}
 
 void StreetNetwork::init(const type::EntryPoint& start, boost::optional<const type::EntryPoint&> end) {
     departure_path_finder.init(start.coordinates, start.streetnetwork_params.mode, start.streetnetwork_params.speed_factor);
@@ -214,6 +276,23 @@ void PathFinder::start_distance_dijkstra(navitia::time_duration radius) {
     if (! starting_edge.found)
         return ;
     computation_launch = true;
+
+    // the state after the dijkstra only depends on the initial state, so it is the key of the cache
+    const bool use_cache = cache && cache->enabled();
+    FallbackCache::Key key;
+    if (use_cache) {
+        key = {starting_edge[source_e], starting_edge[target_e],
+               distances[starting_edge[source_e]].ticks(), distances[starting_edge[target_e]].ticks(),
+               mode, speed_factor, radius.ticks()};
+        if (const auto* isochrone = cache->get(key)) {
+            for (const auto& reached: *isochrone) {
+                distances[reached.vertex] = reached.duration;
+                predecessors[reached.vertex] = reached.predecessor;
+            }
+            return;
+        }
+    }
+
     // We start dijkstra from source and target nodes
     try {
         dijkstra(starting_edge[source_e], distance_visitor(radius, distances));
@@ -223,6 +302,14 @@ void PathFinder::start_distance_dijkstra(navitia::time_duration radius) {
         dijkstra(starting_edge[target_e], distance_visitor(radius, distances));
     } catch(DestinationFound){}
 
+    if (use_cache) {
+        FallbackCache::Isochrone isochrone;
+        for (vertex_t v = 0; v < distances.size(); ++v) {
+            if (distances[v] == bt::pos_infin) { continue; }
+            isochrone.push_back({uint32_t(v), uint32_t(predecessors[v]), distances[v]});
+        }
+        cache->add(key, std::move(isochrone));
+    }
 }
 
 std::vector<std::pair<type::idx_t, navitia::time_duration>>
@@ -273,6 +360,119 @@ navitia::time_duration PathFinder::get_distance(type::idx_t target_idx) {
     return nearest_edge.first;
 }
 
+std::vector<navitia::time_duration>
+PathFinder::get_distances(const std::vector<ProjectionData>& targets, navitia::time_duration max_duration) {
+    constexpr auto max = bt::pos_infin;
+    std::vector<navitia::time_duration> result(targets.size(), max);
+    if (! starting_edge.found)
+        return result;
+    computation_launch = true;
+
+    std::vector<vertex_t> vertices;
+    for (const auto& target: targets) {
+        if (! target.found) { continue; }
+        vertices.push_back(target[source_e]);
+        vertices.push_back(target[target_e]);
+    }
+    if (vertices.empty())
+        return result;
+    std::sort(vertices.begin(), vertices.end());
+    vertices.erase(std::unique(vertices.begin(), vertices.end()), vertices.end());
+
+    // only one search from both ends of the starting edge, with their initial durations,
+    // else the targets settled by a first search would never be finished by the second one
+    // and the second one could not stop before max_duration
+    std::vector<vertex_t> starts = {starting_edge[source_e]};
+    if (starting_edge[target_e] != starting_edge[source_e]) {
+        starts.push_back(starting_edge[target_e]);
+    }
+    try {
+        dijkstra(starts.begin(), starts.end(), distance_targets_visitor(max_duration, distances, vertices));
+    } catch(DestinationFound){}
+
+    for (size_t i = 0; i < targets.size(); ++i) {
+        const auto& target = targets[i];
+        if (! target.found) { continue; }
+        // the search might have been stopped before reaching both ends of the edge
+        navitia::time_duration best = max;
+        for (const auto d: {source_e, target_e}) {
+            if (distances[target[d]] == max) { continue; }
+            best = std::min(best, distances[target[d]] + crow_fly_duration(target.distances[d]));
+        }
+        if (best <= max_duration) {
+            result[i] = best;
+        }
+    }
+    return result;
+}
+
+std::vector<std::vector<navitia::time_duration>>
+compute_durations_matrix(const GeoRef& geo_ref,
+                         const std::vector<type::GeographicalCoord>& origins,
+                         const std::vector<type::GeographicalCoord>& destinations,
+                         nt::Mode_e mode,
+                         float speed_factor,
+                         navitia::time_duration max_duration,
+                         size_t nb_threads) {
+    std::vector<std::vector<navitia::time_duration>> result(origins.size());
+
+    const nt::idx_t offset = geo_ref.offsets[mode];
+    std::vector<ProjectionData> projected_destinations;
+    projected_destinations.reserve(destinations.size());
+    for (const auto& coord: destinations) {
+        projected_destinations.emplace_back(coord, geo_ref, offset, geo_ref.pl);
+    }
+
+    const auto make_path_finder = [&]() { return PathFinder(geo_ref); };
+    for_each_in_threads(origins.size(), nb_threads, make_path_finder, [&](PathFinder& path_finder, size_t i) {
+        path_finder.init(origins[i], mode, speed_factor);
+        result[i] = path_finder.get_distances(projected_destinations, max_duration);
+    });
+    return result;
+}
+
+size_t build_street_network_connections(type::PT_Data& pt_data,
+                                        const GeoRef& geo_ref,
+                                        navitia::time_duration max_duration,
+                                        size_t nb_threads) {
+    const auto& stop_points = pt_data.stop_points;
+    std::vector<std::vector<std::pair<type::idx_t, navitia::time_duration>>> reachable(stop_points.size());
+    const auto make_path_finder = [&]() { return PathFinder(geo_ref); };
+    for_each_in_threads(stop_points.size(), nb_threads, make_path_finder, [&](PathFinder& path_finder, size_t i) {
+        path_finder.init(stop_points[i]->coord, nt::Mode_e::Walking, 1);
+        reachable[i] = path_finder.find_nearest_stop_points(max_duration, pt_data.stop_point_proximity_list);
+    });
+
+    // the connections already given by the data are kept
+    std::set<std::pair<type::idx_t, type::idx_t>> existing_connections;
+    for (const auto* conn: pt_data.stop_point_connections) {
+        existing_connections.insert({conn->departure->idx, conn->destination->idx});
+    }
+
+    size_t nb_created = 0;
+    for (size_t i = 0; i < stop_points.size(); ++i) {
+        boost::sort(reachable[i]);
+        for (const auto& sp_duration: reachable[i]) {
+            if (sp_duration.first == i || existing_connections.count({type::idx_t(i), sp_duration.first})) {
+                continue;
+            }
+            auto* connection = new type::StopPointConnection();
+            connection->idx = pt_data.stop_point_connections.size();
+            connection->departure = stop_points[i];
+            connection->destination = stop_points[sp_duration.first];
+            connection->connection_type = type::ConnectionType::Walking;
+            connection->duration = sp_duration.second.total_seconds();
+            connection->display_duration = connection->duration;
+            connection->max_duration = connection->duration;
+            pt_data.stop_point_connections.push_back(connection);
+            connection->departure->stop_point_connection_list.push_back(connection);
+            connection->destination->stop_point_connection_list.push_back(connection);
+            ++nb_created;
+        }
+    }
+    return nb_created;
+}
+
 std::pair<navitia::time_duration, ProjectionData::Direction> PathFinder::find_nearest_vertex(const ProjectionData& target) const {
     constexpr auto max = bt::pos_infin;
     if (! target.found)
@@ -34,6 +34,8 @@ www.navitia.io
 #include <boost/graph/filtered_graph.hpp>
 #include <boost/graph/two_bit_color_map.hpp>
 #include <boost/graph/dijkstra_shortest_paths.hpp>
+#include <list>
+#include <unordered_map>
 
 namespace bt = boost::posix_time;
 
@@ -94,9 +96,81 @@ struct TransportationModeFilter {
     }
 };
 
+/** LRU cache of the radius limited dijkstras done by the PathFinders
+ *
+ * Most of the requests start from a few popular places, so we keep the state
+ * of the dijkstra (the reached vertices with their duration and predecessor)
+ * for a given projected edge, initial durations, mode, speed factor and radius.
+ * Restoring it gives exactly the distances and predecessors of a new computation.
+ *
+ * A car fallback can reach hundreds of thousands of vertices, so the cache is bounded
+ * by the total number of reached vertices it keeps (sizeof(ReachedVertex) bytes each),
+ * not by its number of entries.
+ *
+ * It is used by only one worker (not thread safe) and cleared when the data change.
+ */
+struct FallbackCache {
+    struct Key {
+        vertex_t source;
+        vertex_t target;
+        //initial durations of the source and the target, in ticks
+        int64_t source_duration;
+        int64_t target_duration;
+        nt::Mode_e mode;
+        float speed_factor;
+        int64_t radius;
+
+        bool operator==(const Key& other) const {
+            return source == other.source && target == other.target
+                    && source_duration == other.source_duration && target_duration == other.target_duration
+                    && mode == other.mode && speed_factor == other.speed_factor && radius == other.radius;
+        }
+    };
+    struct KeyHash {
+        size_t operator()(const Key& key) const;
+    };
+    struct ReachedVertex {
+        uint32_t vertex;
+        uint32_t predecessor;
+        navitia::time_duration duration;
+    };
+    typedef std::vector<ReachedVertex> Isochrone;
+
+    size_t max_nb_vertices; //< 0 means disabled
+    size_t nb_hits = 0;
+    size_t nb_misses = 0;
+
+    FallbackCache(size_t max_nb_vertices = 0): max_nb_vertices(max_nb_vertices) {}
+
+    bool enabled() const { return max_nb_vertices > 0; }
+
+    /// return nullptr if the key is not in the cache
+    const Isochrone* get(const Key& key);
+    /// an isochrone larger than the whole cache is not kept
+    void add(const Key& key, Isochrone isochrone);
+
+    /// the cache is cleared if the data have changed
+    void set_data_identifier(size_t data_identifier);
+    void clear();
+    size_t size() const { return index.size(); }
+    /// total number of reached vertices kept
+    size_t nb_vertices() const { return total_nb_vertices; }
+
+private:
+    size_t data_identifier = std::numeric_limits<size_t>::max();
+    size_t total_nb_vertices = 0;
+    /// the most recently used are in the front
+    typedef std::list<std::pair<Key, Isochrone>> Entries;
+    Entries entries;
+    std::unordered_map<Key, Entries::iterator, KeyHash> index;
+};
+
 struct PathFinder {
     const GeoRef & geo_ref;
 
+    /// optional cache of the radius limited dijkstras
+    FallbackCache* cache = nullptr;
+
     bool computation_launch = false;
 
     /// starting point
@@ -130,6 +204,15 @@ struct PathFinder {
     /// compute the distance from the starting point to the target stop point
     navitia::time_duration get_distance(type::idx_t target_idx);
 
+    /**
+     * compute in one search the distances from the starting point to all the targets
+     * the search starts from both ends of the starting edge at once, and is stopped when all the
+     * targets are reached or when max_duration is exceeded,
+     * the unreached targets have a bt::pos_infin duration
+     */
+    std::vector<navitia::time_duration> get_distances(const std::vector<ProjectionData>& targets,
+                                                      navitia::time_duration max_duration);
+
     /// return the path from the starting point to the target. the target has to have been previously visited.
     Path get_path(type::idx_t idx);
 
@@ -142,13 +225,22 @@ struct PathFinder {
      **/
     template<class Visitor>
     void dijkstra(vertex_t start, Visitor visitor) {
+        dijkstra(&start, &start + 1, visitor);
+    }
+
+    /**
+     * Launch one dijkstra from all the starting vertices at once (with their current distances)
+     * Warning, it modifies the distances and the predecessors
+     **/
+    template<class SourceIt, class Visitor>
+    void dijkstra(SourceIt starts_begin, SourceIt starts_end, Visitor visitor) {
         // Note: the predecessors have been updated in init
         boost::two_bit_color_map<> color(boost::num_vertices(geo_ref.graph));
 
         //we filter the graph to only use certain mean of transport
         using filtered_graph = boost::filtered_graph<georef::Graph, boost::keep_all, TransportationModeFilter>;
         boost::dijkstra_shortest_paths_no_init(filtered_graph(geo_ref.graph, {}, TransportationModeFilter(mode, geo_ref)),
-                                               start, &predecessors[0], &distances[0],
+                                               starts_begin, starts_end, &predecessors[0], &distances[0],
                                                boost::get(&Edge::duration, geo_ref.graph), // weigth map
                                                boost::identity_property_map(),
                                                std::less<navitia::time_duration>(),
@@ -187,7 +279,7 @@ private:
 
 /** Structure managing the computation on the streetnetwork */
 struct StreetNetwork {
-    StreetNetwork(const GeoRef& geo_ref);
+    StreetNetwork(const GeoRef& geo_ref, FallbackCache* cache = nullptr);
 
     void init(const type::EntryPoint& start_coord, boost::optional<const type::EntryPoint&> end_coord = {});
 
@@ -217,6 +309,35 @@ private:
     Path combine_path(const vertex_t best_destination, std::vector<vertex_t> preds, std::vector<vertex_t> successors) const;
 };
 
+/**
+ * Compute the durations matrix between the origins and the destinations
+ * (one row per origin, bt::pos_infin for the destinations not reachable within max_duration)
+ *
+ * The destinations are projected once and there is one multi target search by origin,
+ * the origins are shared between nb_threads threads (each thread has its own PathFinder,
+ * so beware of the memory footprint on large graphs)
+ */
+std::vector<std::vector<navitia::time_duration>>
+compute_durations_matrix(const GeoRef& geo_ref,
+                         const std::vector<type::GeographicalCoord>& origins,
+                         const std::vector<type::GeographicalCoord>& destinations,
+                         nt::Mode_e mode,
+                         float speed_factor,
+                         navitia::time_duration max_duration,
+                         size_t nb_threads = 1);
+
+/**
+ * Add a walking connection between every couple of stop points less than max_duration apart
+ * on the street network (the connections already in the data are kept as they are).
+ * There is one dijkstra by stop point, shared between nb_threads threads.
+ *
+ * return the number of created connections
+ */
+size_t build_street_network_connections(type::PT_Data& pt_data,
+                                        const GeoRef& geo_ref,
+                                        navitia::time_duration max_duration,
+                                        size_t nb_threads = 1);
+
 /// Build a path from a reverse path list
 Path create_path(const GeoRef& georef, std::vector<vertex_t> reverse_path, bool add_one_elt);
 
@@ -272,6 +393,36 @@ struct target_all_visitor : public boost::dijkstra_visitor<> {
     }
 };
 
+// Visitor who stops (throw a DestinationFound exception) when all the targets have been visited
+// or when a certain distance is reached
+struct distance_targets_visitor : public boost::dijkstra_visitor<> {
+    navitia::time_duration max_duration;
+    const std::vector<navitia::time_duration>& durations;
+    const std::vector<vertex_t>& sorted_destinations;
+    size_t nb_found = 0;
+
+    distance_targets_visitor(time_duration max_dur,
+                             const std::vector<time_duration>& dur,
+                             const std::vector<vertex_t>& sorted_dest):
+        max_duration(max_dur), durations(dur), sorted_destinations(sorted_dest) {}
+
+    template<typename G>
+    void examine_vertex(typename boost::graph_traits<G>::vertex_descriptor u, const G&) {
+        if (durations[u] > max_duration)
+            throw DestinationFound();
+    }
+
+    template <typename graph_type>
+    void finish_vertex(vertex_t u, const graph_type&){
+        if (std::binary_search(sorted_destinations.begin(), sorted_destinations.end(), u)) {
+            nb_found++;
+            if (nb_found == sorted_destinations.size()) {
+                throw DestinationFound();
+            }
+        }
+    }
+};
+
 //Visitor who stops (throw a DestinationFound exception) when a target has been visited
 struct target_unique_visitor : public boost::dijkstra_visitor<> {
     const vertex_t & destination;
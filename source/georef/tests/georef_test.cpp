@@ -1002,3 +1002,75 @@ BOOST_AUTO_TEST_CASE(geolocalization) {
     BOOST_CHECK_EQUAL(b.data->geo_ref->nearest_addr(D), std::make_pair(2, const_ab));
     BOOST_CHECK_EQUAL(b.data->geo_ref->nearest_addr(E), std::make_pair(3, const_ac));
 }
+
+BOOST_AUTO_TEST_CASE(find_admins_with_index) {
+    // a 10km long street going from west to east, with one vertex every 100m
+    // the first half is in admin A, the second in admin B
+    //
+    //   A +--+--+-- ... --+--+--+-- ... --+--+ B
+    //     0m              5000m              10000m
+    using nt::GeographicalCoord;
+    using navitia::georef::Edge;
+
+    ed::builder b = {"20140828"};
+    auto& geo_ref = *b.data->geo_ref;
+    for (int i = 0; i <= 100; ++i) {
+        boost::add_vertex(navitia::georef::Vertex(GeographicalCoord(i * 100, 0, false)), geo_ref.graph);
+    }
+    geo_ref.init();
+
+    for (const auto& name: {"A", "B"}) {
+        auto admin = new navitia::georef::Admin(8);
+        admin->uri = std::string("admin:") + name;
+        admin->name = name;
+        admin->idx = geo_ref.admins.size();
+        geo_ref.admins.push_back(admin);
+
+        auto way = new navitia::georef::Way();
+        way->name = std::string("rue ") + name;
+        way->idx = geo_ref.ways.size();
+        way->admin_list.push_back(admin);
+        geo_ref.ways.push_back(way);
+    }
+    for (int i = 0; i < 100; ++i) {
+        const navitia::type::idx_t way_idx = i < 50 ? 0 : 1;
+        add_edge(i, i + 1, Edge(way_idx, 90_s), geo_ref.graph);
+        add_edge(i + 1, i, Edge(way_idx, 90_s), geo_ref.graph);
+        geo_ref.ways[way_idx]->edges.push_back(std::make_pair(i, i + 1));
+        geo_ref.ways[way_idx]->edges.push_back(std::make_pair(i + 1, i));
+    }
+    b.data->build_proximity_list();
+    geo_ref.build_admin_index();
+
+    BOOST_CHECK(! geo_ref.admin_index.cells.empty());
+    BOOST_REQUIRE_EQUAL(geo_ref.way_centroids.size(), 2);
+
+    // far from the boundary, the index gives the answer
+    const auto* admins = geo_ref.admin_index.find(GeographicalCoord(1000, 50, false));
+    BOOST_REQUIRE(admins);
+    BOOST_REQUIRE_EQUAL(admins->size(), 1);
+    BOOST_CHECK_EQUAL(admins->front()->uri, "admin:A");
+    admins = geo_ref.admin_index.find(GeographicalCoord(9000, 50, false));
+    BOOST_REQUIRE(admins);
+    BOOST_REQUIRE_EQUAL(admins->size(), 1);
+    BOOST_CHECK_EQUAL(admins->front()->uri, "admin:B");
+
+    // near the boundary or outside of the street network, it is not resolved
+    BOOST_CHECK(! geo_ref.admin_index.find(GeographicalCoord(5000, 0, false)));
+    BOOST_CHECK(! geo_ref.admin_index.find(GeographicalCoord(1000, 2000, false)));
+
+    // the index must not change the result of find_admins
+    std::vector<GeographicalCoord> coords;
+    for (int x = -600; x <= 10600; x += 37) {
+        for (int y: {-450, -200, 0, 150, 420}) {
+            coords.push_back(GeographicalCoord(x, y, false));
+        }
+    }
+    std::vector<std::vector<Admin*>> with_index;
+    for (const auto& coord: coords) { with_index.push_back(geo_ref.find_admins(coord)); }
+    geo_ref.admin_index.clear();
+    for (size_t i = 0; i < coords.size(); ++i) {
+        const auto without_index = geo_ref.find_admins(coords[i]);
+        BOOST_CHECK_MESSAGE(without_index == with_index[i], "different admins for " << coords[i]);
+    }
+}
@@ -36,6 +36,7 @@ www.navitia.io
 #include "type/pt_data.h"
 
 #include"georef/street_network.h"
+#include <boost/range/algorithm/count_if.hpp>
 #include <boost/test/unit_test.hpp>
 
 using namespace navitia::georef;
@@ -73,34 +74,50 @@ static std::string get_name(int i, int j) {
 }
 
 /**
-  * The aim of the test is to check that the street network answer give the same answer
-  * to multiple get_distance question
+  * a dumb square graph of square_size * square_size vertices, the vertex "i_j" being at (i, j)
   *
+  * With uniform durations, the edges link the neighbours in both ways in 10s.
+  * Else the edges go only to the next vertices, (i, j + 1) in (i + j) * j
+  * and (i + 1, j) in (i + j) * i.
   **/
-BOOST_AUTO_TEST_CASE(idempotence) {
-    //graph creation
+struct square_graph {
     type::Data data;
     GeoRef geo_ref;
-    GraphBuilder b(geo_ref);
-    size_t square_size(10);
-
-    //we build a dumb square graph
-    for (size_t i = 0; i < square_size ; ++i) {
-        for (size_t j = 0; j < square_size ; ++j) {
-            std::string name(get_name(i, j));
-            b(name, i, j);
+    GraphBuilder b;
+    const size_t square_size = 10;
+
+    explicit square_graph(bool uniform_durations = true): b(geo_ref) {
+        for (size_t i = 0; i < square_size ; ++i) {
+            for (size_t j = 0; j < square_size ; ++j) {
+                b(get_name(i, j), i, j);
+            }
         }
-    }
-    for (size_t i = 0; i < square_size - 1; ++i) {
-        for (size_t j = 0; j < square_size - 1; ++j) {
-            std::string name(get_name(i, j));
-
-            //we add edge to the next vertex (the value is not important)
-            b.add_edge(name, get_name(i, j + 1), navitia::seconds((i + j) * j));
-            b.add_edge(name, get_name(i + 1, j), navitia::seconds((i + j) * i));
+        for (size_t i = 0; i < square_size - 1; ++i) {
+            for (size_t j = 0; j < square_size - 1; ++j) {
+                if (! uniform_durations) {
+                    b.add_edge(get_name(i, j), get_name(i, j + 1), navitia::seconds((i + j) * j));
+                    b.add_edge(get_name(i, j), get_name(i + 1, j), navitia::seconds((i + j) * i));
+                    continue;
+                }
+                b.add_edge(get_name(i, j), get_name(i, j + 1), navitia::seconds(10));
+                b.add_edge(get_name(i, j + 1), get_name(i, j), navitia::seconds(10));
+                b.add_edge(get_name(i, j), get_name(i + 1, j), navitia::seconds(10));
+                b.add_edge(get_name(i + 1, j), get_name(i, j), navitia::seconds(10));
+            }
         }
     }
+};
+
+struct weighted_square_graph: public square_graph {
+    weighted_square_graph(): square_graph(false) {}
+};
 
+/**
+  * The aim of the test is to check that the street network answer give the same answer
+  * to multiple get_distance question
+  *
+  **/
+BOOST_FIXTURE_TEST_CASE(idempotence, weighted_square_graph) {
     PathFinder worker(geo_ref);
 
     //we project 2 stations
@@ -172,3 +189,210 @@ BOOST_AUTO_TEST_CASE(idempotence) {
         BOOST_CHECK(first_res == other_res);
     }
 }
+
+/**
+  * The fallback cache must give exactly the same results as a new computation
+  **/
+BOOST_FIXTURE_TEST_CASE(fallback_cache, square_graph) {
+    for (size_t i = 0; i < 3; ++i) {
+        type::StopPoint* sp = new type::StopPoint();
+        sp->coord.set_xy(2. + 2 * i, 3.);
+        sp->idx = i;
+        data.pt_data->stop_points.push_back(sp);
+    }
+    geo_ref.init();
+    geo_ref.project_stop_points(data.pt_data->stop_points);
+    geo_ref.build_proximity_list();
+    data.pt_data->build_proximity_list();
+
+    type::GeographicalCoord start;
+    start.set_xy(2., 2.);
+    const auto radius = navitia::seconds(45);
+
+    PathFinder without_cache(geo_ref);
+    without_cache.init(start, type::Mode_e::Walking, 1);
+    const auto expected = without_cache.find_nearest_stop_points(radius, data.pt_data->stop_point_proximity_list);
+    BOOST_REQUIRE(! expected.empty());
+
+    FallbackCache cache(1000);
+    PathFinder with_cache(geo_ref);
+    with_cache.cache = &cache;
+    for (int i = 0; i < 2; ++i) {
+        with_cache.init(start, type::Mode_e::Walking, 1);
+        const auto res = with_cache.find_nearest_stop_points(radius, data.pt_data->stop_point_proximity_list);
+        BOOST_REQUIRE_EQUAL(res.size(), expected.size());
+        for (size_t j = 0; j < res.size(); ++j) {
+            BOOST_CHECK_EQUAL(res[j].first, expected[j].first);
+            BOOST_CHECK_EQUAL(res[j].second, expected[j].second);
+        }
+        BOOST_CHECK(with_cache.distances == without_cache.distances);
+        for (const auto& sp_dur: res) {
+            BOOST_CHECK_EQUAL(with_cache.get_path(sp_dur.first).duration,
+                              without_cache.get_path(sp_dur.first).duration);
+        }
+    }
+    BOOST_CHECK_EQUAL(cache.nb_misses, 1);
+    BOOST_CHECK_EQUAL(cache.nb_hits, 1);
+    BOOST_CHECK_EQUAL(cache.size(), 1);
+    // the cache is bounded by the reached vertices it keeps
+    const size_t nb_reached = boost::count_if(without_cache.distances,
+                                              [](navitia::time_duration d) { return d != bt::pos_infin; });
+    BOOST_CHECK_EQUAL(cache.nb_vertices(), nb_reached);
+
+    // another mode or speed is another entry
+    with_cache.init(start, type::Mode_e::Walking, 2);
+    with_cache.find_nearest_stop_points(radius, data.pt_data->stop_point_proximity_list);
+    BOOST_CHECK_EQUAL(cache.nb_misses, 2);
+    BOOST_CHECK_EQUAL(cache.size(), 2);
+    const size_t nb_reached_speed_2 = cache.nb_vertices() - nb_reached;
+
+    // the cache is cleared when the data change
+    cache.set_data_identifier(42);
+    BOOST_CHECK_EQUAL(cache.size(), 0);
+    BOOST_CHECK_EQUAL(cache.nb_vertices(), 0);
+
+    // an isochrone larger than the cache is not kept
+    FallbackCache tiny_cache(nb_reached - 1);
+    with_cache.cache = &tiny_cache;
+    with_cache.init(start, type::Mode_e::Walking, 1);
+    with_cache.start_distance_dijkstra(radius);
+    BOOST_CHECK_EQUAL(tiny_cache.size(), 0);
+
+    // the least recently used is removed when both isochrones do not fit
+    FallbackCache small_cache(std::max(nb_reached, nb_reached_speed_2));
+    with_cache.cache = &small_cache;
+    with_cache.init(start, type::Mode_e::Walking, 1);
+    with_cache.start_distance_dijkstra(radius);
+    with_cache.init(start, type::Mode_e::Walking, 2);
+    with_cache.start_distance_dijkstra(radius);
+    BOOST_CHECK_EQUAL(small_cache.size(), 1);
+    BOOST_CHECK(small_cache.nb_vertices() <= small_cache.max_nb_vertices);
+    with_cache.init(start, type::Mode_e::Walking, 1);
+    with_cache.start_distance_dijkstra(radius);
+    BOOST_CHECK_EQUAL(small_cache.nb_hits, 0);
+    BOOST_CHECK_EQUAL(small_cache.nb_misses, 3);
+}
+
+BOOST_FIXTURE_TEST_CASE(durations_matrix, square_graph) {
+    // the destinations are stop points to be able to compare with the one to one computation
+    std::vector<type::GeographicalCoord> destinations;
+    for (size_t i = 0; i < 4; ++i) {
+        type::StopPoint* sp = new type::StopPoint();
+        sp->coord.set_xy(1. + 2 * i, 1.5 + i);
+        sp->idx = i;
+        data.pt_data->stop_points.push_back(sp);
+        destinations.push_back(sp->coord);
+    }
+    geo_ref.init();
+    geo_ref.project_stop_points(data.pt_data->stop_points);
+
+    std::vector<type::GeographicalCoord> origins;
+    for (size_t i = 0; i < 5; ++i) {
+        type::GeographicalCoord origin;
+        origin.set_xy(2. + i, 2.);
+        origins.push_back(origin);
+    }
+
+    const auto matrix = compute_durations_matrix(geo_ref, origins, destinations, type::Mode_e::Walking, 1,
+                                                 bt::pos_infin, 2);
+    BOOST_REQUIRE_EQUAL(matrix.size(), origins.size());
+    PathFinder path_finder(geo_ref);
+    navitia::time_duration max_dur = navitia::seconds(0);
+    for (size_t i = 0; i < origins.size(); ++i) {
+        BOOST_REQUIRE_EQUAL(matrix[i].size(), destinations.size());
+        for (size_t j = 0; j < destinations.size(); ++j) {
+            path_finder.init(origins[i], type::Mode_e::Walking, 1);
+            const auto expected = path_finder.get_distance(j);
+            BOOST_REQUIRE(expected != bt::pos_infin);
+            BOOST_CHECK_EQUAL(matrix[i][j], expected);
+            max_dur = std::max(max_dur, expected);
+        }
+    }
+
+    // with a max duration, the farthest destinations are not reached
+    const auto limit = max_dur - navitia::seconds(1);
+    const auto limited = compute_durations_matrix(geo_ref, origins, destinations, type::Mode_e::Walking, 1,
+                                                  limit, 3);
+    size_t nb_unreached = 0;
+    for (size_t i = 0; i < origins.size(); ++i) {
+        for (size_t j = 0; j < destinations.size(); ++j) {
+            if (matrix[i][j] > limit) {
+                BOOST_CHECK_EQUAL(limited[i][j], bt::pos_infin);
+                ++nb_unreached;
+            } else {
+                BOOST_CHECK_EQUAL(limited[i][j], matrix[i][j]);
+            }
+        }
+    }
+    BOOST_CHECK(nb_unreached > 0);
+}
+
+/*
+ * the multi target search stops as soon as all the targets are settled,
+ * even with a radius covering the whole graph
+ */
+BOOST_FIXTURE_TEST_CASE(durations_early_stop, square_graph) {
+    type::StopPoint* sp = new type::StopPoint();
+    sp->coord.set_xy(3., 3.5);
+    sp->idx = 0;
+    data.pt_data->stop_points.push_back(sp);
+    geo_ref.init();
+    geo_ref.project_stop_points(data.pt_data->stop_points);
+    type::GeographicalCoord start;
+    start.set_xy(2., 2.5);
+
+    PathFinder path_finder(geo_ref);
+    path_finder.init(start, type::Mode_e::Walking, 1);
+    const auto durations = path_finder.get_distances({geo_ref.projected_stop_points[0][type::Mode_e::Walking]},
+                                                     bt::pos_infin);
+    BOOST_REQUIRE_EQUAL(durations.size(), 1);
+    size_t nb_reached = 0;
+    for (const auto& duration: path_finder.distances) {
+        if (duration != bt::pos_infin) { ++nb_reached; }
+    }
+    // the whole graph would be reached by a search bounded only by the radius
+    BOOST_CHECK_LT(nb_reached, square_size * square_size / 2);
+
+    path_finder.init(start, type::Mode_e::Walking, 1);
+    BOOST_CHECK_EQUAL(durations[0], path_finder.get_distance(0));
+}
+
+BOOST_FIXTURE_TEST_CASE(street_network_connections, square_graph) {
+    // sp0 and sp1 are close, sp2 is far away
+    for (const auto x: {1., 2., 8.}) {
+        type::StopPoint* sp = new type::StopPoint();
+        sp->coord.set_xy(x, 1.);
+        sp->idx = data.pt_data->stop_points.size();
+        data.pt_data->stop_points.push_back(sp);
+    }
+    // the connection sp1->sp0 is given by the data
+    auto* given = new type::StopPointConnection();
+    given->idx = 0;
+    given->departure = data.pt_data->stop_points[1];
+    given->destination = data.pt_data->stop_points[0];
+    given->duration = 120;
+    data.pt_data->stop_point_connections.push_back(given);
+
+    geo_ref.init();
+    geo_ref.project_stop_points(data.pt_data->stop_points);
+    data.pt_data->build_proximity_list();
+
+    PathFinder path_finder(geo_ref);
+    path_finder.init(data.pt_data->stop_points[0]->coord, type::Mode_e::Walking, 1);
+    const auto expected = path_finder.get_distance(1);
+    BOOST_REQUIRE(expected < navitia::seconds(30));
+
+    const auto nb = build_street_network_connections(*data.pt_data, geo_ref, navitia::seconds(30), 2);
+    BOOST_REQUIRE_EQUAL(nb, 1);
+    BOOST_REQUIRE_EQUAL(data.pt_data->stop_point_connections.size(), 2);
+    const auto* conn = data.pt_data->stop_point_connections[1];
+    BOOST_CHECK_EQUAL(conn->idx, 1);
+    BOOST_CHECK_EQUAL(conn->departure->idx, 0);
+    BOOST_CHECK_EQUAL(conn->destination->idx, 1);
+    BOOST_CHECK(conn->connection_type == type::ConnectionType::Walking);
+    BOOST_CHECK_EQUAL(conn->duration, expected.total_seconds());
+    BOOST_CHECK_EQUAL(data.pt_data->stop_points[0]->stop_point_connection_list.size(), 1);
+    BOOST_CHECK_EQUAL(data.pt_data->stop_points[2]->stop_point_connection_list.size(), 0);
+    // the given connection is untouched
+    BOOST_CHECK_EQUAL(data.pt_data->stop_point_connections[0]->duration, 120);
+}
@@ -70,7 +70,8 @@ class Ptobjects(ResourceUri):
                                          ptobjects returned")
         self.parsers["get"].add_argument("search_type", type=int, default=0,
                                          description="Type of search:\
-                                         firstletter or type error")
+                                         firstletter (0), type error (1)\
+                                         or typo tolerant (2)")
         self.parsers["get"].add_argument("admin_uri[]", type=str,
                                          action="append",
                                          description="If filled, will\
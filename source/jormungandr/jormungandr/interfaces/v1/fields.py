@@ -652,6 +652,12 @@ class UrisToLinks():
 
 
 instance_status = {
+    "autocomplete_cache_hits": fields.Integer(),
+    "autocomplete_cache_misses": fields.Integer(),
+    "autocomplete_cache_size": fields.Integer(),
+    "departure_board_cache_hits": fields.Integer(),
+    "departure_board_cache_misses": fields.Integer(),
+    "departure_board_cache_size": fields.Integer(),
     "data_version": fields.Integer(),
     "end_production_date": fields.String(),
     "is_connected_to_rabbitmq": fields.Boolean(),
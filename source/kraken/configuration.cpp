@@ -31,6 +31,7 @@ www.navitia.io
 #include "configuration.h"
 #include "utils/exception.h"
 #include <fstream>
+#include <algorithm>
 #include <boost/optional.hpp>
 
 namespace po = boost::program_options;
@@ -51,6 +52,21 @@ po::options_description get_options_description(const boost::optional<std::strin
          "name of the instance")
 
         ("GENERAL.nb_threads", po::value<int>()->default_value(1), "number of workers threads")
+        ("GENERAL.fallback_cache_size", po::value<int>()->default_value(0),
+         "number of street network vertices reached by the fallback computations kept in cache by each worker, "
+         "16 bytes each; a car fallback can reach hundreds of thousands of them (0 to disable it)")
+        ("GENERAL.matrix_nb_threads", po::value<int>()->default_value(1),
+         "number of threads used by a worker to compute a street network matrix, the worker thread being one of them. "
+         "Each of the GENERAL.nb_threads workers can use them at the same time, keep nb_threads * matrix_nb_threads "
+         "below the number of cores")
+        ("GENERAL.route_schedules_nb_threads", po::value<int>()->default_value(1),
+         "number of threads used by a worker to compute the schedules of the routes of a route_schedules, "
+         "the worker thread being one of them. Each of the GENERAL.nb_threads workers can use them at the same time, "
+         "keep nb_threads * route_schedules_nb_threads below the number of cores")
+        ("GENERAL.autocomplete_cache_size", po::value<int>()->default_value(0),
+         "number of places and pt_objects responses kept in cache, shared by the workers (0 to disable it)")
+        ("GENERAL.departure_board_cache_size", po::value<int>()->default_value(0),
+         "number of daily departures of a stop point kept in cache for the stop_schedules, shared by the workers (0 to disable it)")
 
         ("BROKER.host", po::value<std::string>()->default_value("localhost"), "host of rabbitmq")
         ("BROKER.port", po::value<int>()->default_value(5672), "port of rabbitmq")
@@ -107,6 +123,21 @@ boost::optional<std::string> Configuration::chaos_database() const{
 int Configuration::nb_thread() const{
     return this->vm["GENERAL.nb_threads"].as<int>();
 }
+size_t Configuration::fallback_cache_size() const{
+    return std::max(this->vm["GENERAL.fallback_cache_size"].as<int>(), 0);
+}
+size_t Configuration::matrix_nb_threads() const{
+    return std::max(this->vm["GENERAL.matrix_nb_threads"].as<int>(), 1);
+}
+size_t Configuration::route_schedules_nb_threads() const{
+    return std::max(this->vm["GENERAL.route_schedules_nb_threads"].as<int>(), 1);
+}
+size_t Configuration::autocomplete_cache_size() const{
+    return std::max(this->vm["GENERAL.autocomplete_cache_size"].as<int>(), 0);
+}
+size_t Configuration::departure_board_cache_size() const{
+    return std::max(this->vm["GENERAL.departure_board_cache_size"].as<int>(), 0);
+}
 
 std::string Configuration::broker_host() const{
     return this->vm["BROKER.host"].as<std::string>();
@@ -46,6 +46,11 @@ namespace navitia { namespace kraken{
             std::string instance_name() const;
             boost::optional<std::string> chaos_database() const;
             int nb_thread() const;
+            size_t fallback_cache_size() const;
+            size_t matrix_nb_threads() const;
+            size_t route_schedules_nb_threads() const;
+            size_t autocomplete_cache_size() const;
+            size_t departure_board_cache_size() const;
 
             std::string broker_host() const;
             int broker_port() const;
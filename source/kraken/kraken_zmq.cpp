@@ -86,10 +86,15 @@ int main(int argn, char** argv){
 
     threads.create_thread(navitia::MaintenanceWorker(data_manager, conf));
 
+    // the cache of the autocomplete responses is shared by all the workers
+    navitia::ResponseCache response_cache(conf.autocomplete_cache_size());
+    // and the departures of the stop points for the stop_schedules
+    navitia::timetables::DepartureBoardCache departure_board_cache(conf.departure_board_cache_size());
     int nb_threads = conf.nb_thread();
     // Launch pool of worker threads
     for(int thread_nbr = 0; thread_nbr < nb_threads; ++thread_nbr) {
-        threads.create_thread(std::bind(&doWork, std::ref(context), std::ref(data_manager), conf));
+        threads.create_thread(std::bind(&doWork, std::ref(context), std::ref(data_manager), conf, &response_cache,
+                                        &departure_board_cache));
     }
 
     // Connect work threads to client threads via a queue
@@ -48,13 +48,15 @@ pbnavitia::Response make_internal_error(const navitia::recoverable_exception& e)
 }
 
 namespace pt = boost::posix_time;
-void doWork(zmq::context_t & context, DataManager<navitia::type::Data>& data_manager, navitia::kraken::Configuration conf) {
+void doWork(zmq::context_t & context, DataManager<navitia::type::Data>& data_manager, navitia::kraken::Configuration conf,
+            navitia::ResponseCache* response_cache,
+            navitia::timetables::DepartureBoardCache* departure_board_cache) {
     auto logger = log4cplus::Logger::getInstance("worker");
 
     zmq::socket_t socket (context, ZMQ_REP);
     socket.connect ("inproc://workers");
     bool run = true;
-    navitia::Worker w(data_manager, conf);
+    navitia::Worker w(data_manager, conf, response_cache, departure_board_cache);
     while(run) {
         zmq::message_t request;
         try{
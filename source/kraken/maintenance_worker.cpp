@@ -113,7 +113,11 @@ void MaintenanceWorker::handle_rt(AmqpClient::Envelope::ptr_t envelope){
             LOG4CPLUS_WARN(logger, "unsupported gtfs rt feed");
         }
     }
-    if (data) { data->build_raptor(); data_manager.set_data(std::move(data)); }
+    if (data) {
+        data->build_raptor();
+        data->build_jointures();
+        data_manager.set_data(std::move(data));
+    }
     LOG4CPLUS_DEBUG(logger, "data updated");
 }
 
@@ -0,0 +1,107 @@
+/* Copyright © 2001-2014, Canal TP and/or its affiliates. All rights reserved.
+  
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+ 
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+  
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+   
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+   
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+  
+Stay tuned using
+twitter @navitia 
+IRC #navitia on freenode
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#include "response_cache.h"
+#include <functional>
+#include <algorithm>
+
+namespace navitia {
+
+ResponseCache::ResponseCache(size_t max_size, size_t nb_shards):
+        max_size(max_size), hits(0), misses(0) {
+    // no need of more shards than entries
+    nb_shards = std::max(size_t(1), std::min(nb_shards, max_size));
+    max_size_by_shard = (max_size + nb_shards - 1) / nb_shards;
+    for (size_t i = 0; i < nb_shards; ++i) {
+        shards.emplace_back(new Shard());
+    }
+}
+
+ResponseCache::Shard& ResponseCache::get_shard(const std::string& key) {
+    return *shards[std::hash<std::string>()(key) % shards.size()];
+}
+
+void ResponseCache::Shard::set_data_identifier(size_t new_data_identifier) {
+    if (new_data_identifier == data_identifier) { return; }
+    index.clear();
+    entries.clear();
+    data_identifier = new_data_identifier;
+}
+
+bool ResponseCache::get(const std::string& key, size_t data_identifier, pbnavitia::Response& response) {
+    if (! enabled()) { return false; }
+    Shard& shard = get_shard(key);
+    std::string serialized;
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.set_data_identifier(data_identifier);
+        auto it = shard.index.find(key);
+        if (it == shard.index.end()) {
+            ++misses;
+            return false;
+        }
+        shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+        serialized = it->second->second;
+    }
+    ++hits;
+    // the parsing is done without the lock
+    return response.ParsePartialFromString(serialized);
+}
+
+void ResponseCache::add(const std::string& key, size_t data_identifier, const pbnavitia::Response& response) {
+    if (! enabled()) { return; }
+    std::string serialized = response.SerializePartialAsString();
+    Shard& shard = get_shard(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.set_data_identifier(data_identifier);
+    auto it = shard.index.find(key);
+    if (it != shard.index.end()) {
+        it->second->second = std::move(serialized);
+        shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+        return;
+    }
+    shard.entries.emplace_front(key, std::move(serialized));
+    shard.index[key] = shard.entries.begin();
+    if (shard.index.size() > max_size_by_shard) {
+        shard.index.erase(shard.entries.back().first);
+        shard.entries.pop_back();
+    }
+}
+
+size_t ResponseCache::size() const {
+    size_t result = 0;
+    for (const auto& shard: shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        result += shard->index.size();
+    }
+    return result;
+}
+
+}
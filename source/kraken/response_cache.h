@@ -0,0 +1,91 @@
+/* Copyright © 2001-2014, Canal TP and/or its affiliates. All rights reserved.
+  
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+ 
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+  
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+   
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+   
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+  
+Stay tuned using
+twitter @navitia 
+IRC #navitia on freenode
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#pragma once
+#include "type/response.pb.h"
+
+#include <string>
+#include <list>
+#include <unordered_map>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <limits>
+
+namespace navitia {
+
+/** LRU cache of serialized responses, shared by all the workers
+ *
+ * The successive requests of an autocomplete widget ("gar", "gare", "gare d"...)
+ * are very often the same for all the users, so we keep their responses.
+ *
+ * The entries are split in shards by the hash of their key, each shard having its own
+ * lock, so the workers rarely wait for each other.
+ * A shard is cleared when it is used with another data_identifier.
+ */
+class ResponseCache {
+public:
+    /// max_size: total number of responses kept, 0 to disable the cache
+    ResponseCache(size_t max_size = 0, size_t nb_shards = 16);
+
+    bool enabled() const { return max_size > 0; }
+
+    /// return true and fill response if the key is in the cache
+    bool get(const std::string& key, size_t data_identifier, pbnavitia::Response& response);
+    void add(const std::string& key, size_t data_identifier, const pbnavitia::Response& response);
+
+    size_t nb_hits() const { return hits; }
+    size_t nb_misses() const { return misses; }
+    size_t size() const;
+
+private:
+    struct Shard {
+        std::mutex mutex;
+        size_t data_identifier = std::numeric_limits<size_t>::max();
+        /// (key, serialized response), the most recently used are in the front
+        typedef std::list<std::pair<std::string, std::string>> Entries;
+        Entries entries;
+        std::unordered_map<std::string, Entries::iterator> index;
+
+        /// to call with the lock
+        void set_data_identifier(size_t new_data_identifier);
+    };
+
+    size_t max_size;
+    size_t max_size_by_shard;
+    std::vector<std::unique_ptr<Shard>> shards;
+    std::atomic<size_t> hits;
+    std::atomic<size_t> misses;
+
+    Shard& get_shard(const std::string& key);
+};
+
+}
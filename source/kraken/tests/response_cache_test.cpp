@@ -0,0 +1,108 @@
+/* Copyright © 2001-2014, Canal TP and/or its affiliates. All rights reserved.
+  
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+ 
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+  
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+   
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+   
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+  
+Stay tuned using
+twitter @navitia 
+IRC #navitia on freenode
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE response_cache_test
+#include <boost/test/unit_test.hpp>
+
+#include "kraken/response_cache.h"
+#include <thread>
+
+static pbnavitia::Response make_response(const std::string& name) {
+    pbnavitia::Response response;
+    auto* place = response.add_places();
+    place->set_uri(name);
+    place->set_name(name);
+    return response;
+}
+
+BOOST_AUTO_TEST_CASE(response_cache_disabled_test) {
+    navitia::ResponseCache cache;
+    BOOST_CHECK(! cache.enabled());
+    cache.add("gare", 0, make_response("gare de Lyon"));
+    pbnavitia::Response response;
+    BOOST_CHECK(! cache.get("gare", 0, response));
+    BOOST_CHECK_EQUAL(cache.size(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(response_cache_lru_test) {
+    // one shard to know which entry is removed
+    navitia::ResponseCache cache(2, 1);
+    cache.add("gar", 0, make_response("gare de Lyon"));
+    cache.add("gare", 0, make_response("gare de l'Est"));
+
+    pbnavitia::Response response;
+    BOOST_REQUIRE(cache.get("gar", 0, response));
+    BOOST_REQUIRE_EQUAL(response.places_size(), 1);
+    BOOST_CHECK_EQUAL(response.places(0).name(), "gare de Lyon");
+
+    // "gare" is the least recently used
+    cache.add("gare d", 0, make_response("gare du Nord"));
+    BOOST_CHECK_EQUAL(cache.size(), 2);
+    BOOST_CHECK(! cache.get("gare", 0, response));
+    BOOST_CHECK(cache.get("gar", 0, response));
+    BOOST_CHECK(cache.get("gare d", 0, response));
+    BOOST_CHECK_EQUAL(response.places(0).name(), "gare du Nord");
+    BOOST_CHECK_EQUAL(cache.nb_hits(), 3);
+    BOOST_CHECK_EQUAL(cache.nb_misses(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(response_cache_data_change_test) {
+    navitia::ResponseCache cache(100);
+    cache.add("gare", 0, make_response("gare de Lyon"));
+    pbnavitia::Response response;
+    BOOST_CHECK(cache.get("gare", 0, response));
+    // the data have been reloaded, the old responses can not be used
+    BOOST_CHECK(! cache.get("gare", 1, response));
+    cache.add("gare", 1, make_response("gare de l'Est"));
+    BOOST_CHECK(cache.get("gare", 1, response));
+    BOOST_CHECK_EQUAL(response.places(0).name(), "gare de l'Est");
+}
+
+BOOST_AUTO_TEST_CASE(response_cache_threads_test) {
+    navitia::ResponseCache cache(64);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&cache, t]() {
+            pbnavitia::Response response;
+            for (int i = 0; i < 1000; ++i) {
+                const std::string key = std::to_string((i * 7 + t) % 100);
+                if (! cache.get(key, 0, response)) {
+                    cache.add(key, 0, make_response(key));
+                } else {
+                    BOOST_CHECK_EQUAL(response.places(0).name(), key);
+                }
+            }
+        });
+    }
+    for (auto& thread: threads) { thread.join(); }
+    BOOST_CHECK_LE(cache.size(), 64);
+    BOOST_CHECK_EQUAL(cache.nb_hits() + cache.nb_misses(), 4000);
+}
@@ -43,6 +43,10 @@ www.navitia.io
 #include "routing/raptor.h"
 #include "type/meta_data.h"
 
+#include <boost/algorithm/string.hpp>
+#include <algorithm>
+#include <cctype>
+
 namespace nt = navitia::type;
 namespace pt = boost::posix_time;
 namespace bg = boost::gregorian;
@@ -99,9 +103,14 @@ std::vector<std::string> vector_of_admins(const T & admin){
     return result;
 }
 
-Worker::Worker(DataManager<navitia::type::Data>& data_manager, kraken::Configuration conf) :
+Worker::Worker(DataManager<navitia::type::Data>& data_manager, kraken::Configuration conf,
+               ResponseCache* response_cache,
+               timetables::DepartureBoardCache* departure_board_cache) :
     data_manager(data_manager), conf(conf),
-    logger(log4cplus::Logger::getInstance(LOG4CPLUS_TEXT("logger"))){}
+    logger(log4cplus::Logger::getInstance(LOG4CPLUS_TEXT("logger"))),
+    fallback_cache(conf.fallback_cache_size()),
+    response_cache(response_cache),
+    departure_board_cache(departure_board_cache){}
 
 Worker::~Worker(){}
 
@@ -128,6 +137,16 @@ pbnavitia::Response Worker::status() {
     status->set_nb_threads(conf.nb_thread());
     status->set_is_connected_to_rabbitmq(d->is_connected_to_rabbitmq);
     status->set_status(get_string_status(d));
+    if (response_cache) {
+        status->set_autocomplete_cache_size(response_cache->size());
+        status->set_autocomplete_cache_hits(response_cache->nb_hits());
+        status->set_autocomplete_cache_misses(response_cache->nb_misses());
+    }
+    if (departure_board_cache) {
+        status->set_departure_board_cache_size(departure_board_cache->size());
+        status->set_departure_board_cache_hits(departure_board_cache->nb_hits());
+        status->set_departure_board_cache_misses(departure_board_cache->nb_misses());
+    }
     if (d->loaded) {
         status->set_publication_date(pt::to_iso_string(d->meta->publication_date));
         status->set_start_production_date(bg::to_iso_string(d->meta->production_date.begin()));
@@ -167,7 +186,8 @@ void Worker::init_worker_data(const boost::shared_ptr<const navitia::type::Data>
     //@TODO should be done in data_manager
     if(data->data_identifier != this->last_data_identifier || !planner){
         planner = std::unique_ptr<routing::RAPTOR>(new routing::RAPTOR(*data));
-        street_network_worker = std::unique_ptr<georef::StreetNetwork>(new georef::StreetNetwork(*data->geo_ref));
+        fallback_cache.set_data_identifier(data->data_identifier);
+        street_network_worker = std::unique_ptr<georef::StreetNetwork>(new georef::StreetNetwork(*data->geo_ref, &fallback_cache));
         this->last_data_identifier = data->data_identifier;
 
         LOG4CPLUS_INFO(logger, "Instanciate planner");
@@ -175,18 +195,63 @@ void Worker::init_worker_data(const boost::shared_ptr<const navitia::type::Data>
 }
 
 
+/// key of the autocomplete requests in the response cache:
+/// the query in lower case without extra spaces, the types, the admins, the count, the depth and the search type
+template<class T>
+static std::string autocomplete_cache_key(const std::string& api, const T& request) {
+    std::string q = boost::algorithm::to_lower_copy(request.q());
+    boost::algorithm::trim(q);
+    std::string key = api + "|";
+    bool previous_space = false;
+    for (const char c: q) {
+        const bool space = std::isspace(static_cast<unsigned char>(c));
+        if (! (space && previous_space)) { key.push_back(space ? ' ' : c); }
+        previous_space = space;
+    }
+    key += "|";
+    for (int i = 0; i < request.types_size(); ++i) {
+        key += std::to_string(request.types(i)) + ",";
+    }
+    key += "|";
+    // the order of the admins does not change the result
+    auto admins = vector_of_admins(request);
+    std::sort(admins.begin(), admins.end());
+    for (const auto& admin: admins) {
+        key += admin + ",";
+    }
+    key += "|" + std::to_string(request.count()) + "|" + std::to_string(request.depth())
+            + "|" + std::to_string(request.search_type());
+    return key;
+}
+
+template<class T>
+static pbnavitia::Response cached_autocomplete(const std::string& api, const T& request,
+                                               const nt::Data& data, ResponseCache* response_cache) {
+    pbnavitia::Response response;
+    std::string key;
+    if (response_cache && response_cache->enabled()) {
+        key = autocomplete_cache_key(api, request);
+        if (response_cache->get(key, data.data_identifier, response)) {
+            return response;
+        }
+    }
+    response = navitia::autocomplete::autocomplete(request.q(),
+            vector_of_pb_types(request), request.depth(), request.count(),
+            vector_of_admins(request), request.search_type(), data);
+    if (! key.empty() && ! response.has_error()) {
+        response_cache->add(key, data.data_identifier, response);
+    }
+    return response;
+}
+
 pbnavitia::Response Worker::autocomplete(const pbnavitia::PlacesRequest & request) {
     const auto data = data_manager.get_data();
-    return navitia::autocomplete::autocomplete(request.q(),
-            vector_of_pb_types(request), request.depth(), request.count(),
-            vector_of_admins(request), request.search_type(), *data);
+    return cached_autocomplete("places", request, *data, response_cache);
 }
 
 pbnavitia::Response Worker::pt_object(const pbnavitia::PtobjectRequest & request) {
     const auto data = data_manager.get_data();
-    return navitia::autocomplete::autocomplete(request.q(),
-            vector_of_pb_types(request), request.depth(), request.count(),
-            vector_of_admins(request), request.search_type(), *data);
+    return cached_autocomplete("pt_objects", request, *data, response_cache);
 }
 
 pbnavitia::Response Worker::disruptions(const pbnavitia::DisruptionsRequest &request){
@@ -227,6 +292,7 @@ pbnavitia::Response Worker::next_stop_times(const pbnavitia::NextStopTimeRequest
     std::vector<std::string> forbidden_uri;
     for(int i = 0; i < request.forbidden_uri_size(); ++i)
         forbidden_uri.push_back(request.forbidden_uri(i));
+    const std::vector<std::string> filters(request.filters().begin(), request.filters().end());
     this->init_worker_data(data);
 
     bt::ptime from_datetime = bt::from_time_t(request.from_datetime());
@@ -244,6 +310,20 @@ pbnavitia::Response Worker::next_stop_times(const pbnavitia::NextStopTimeRequest
                     request.duration(), request.nb_stoptimes(), request.depth(),
                     type::AccessibiliteParams(),
                     *data, false, request.count(), request.start_page(), request.show_codes());
+        case pbnavitia::NEXT_DEPARTURES_BATCH:
+            return timetables::next_departures_batch(
+                    filters,
+                    forbidden_uri, from_datetime,
+                    request.duration(), request.nb_stoptimes(), request.depth(),
+                    type::AccessibiliteParams(), *data, false, request.count(),
+                    request.start_page(), request.show_codes());
+        case pbnavitia::NEXT_ARRIVALS_BATCH:
+            return timetables::next_arrivals_batch(
+                    filters,
+                    forbidden_uri, from_datetime,
+                    request.duration(), request.nb_stoptimes(), request.depth(),
+                    type::AccessibiliteParams(), *data, false, request.count(),
+                    request.start_page(), request.show_codes());
         case pbnavitia::STOPS_SCHEDULES:
             return timetables::stops_schedule(request.departure_filter(),
                                               request.arrival_filter(),
@@ -257,12 +337,14 @@ pbnavitia::Response Worker::next_stop_times(const pbnavitia::NextStopTimeRequest
                     forbidden_uri, from_datetime,
                     request.duration(),
                     request.depth(), max_date_times, request.interface_version(),
-                    request.count(), request.start_page(), *data, false, request.show_codes());
+                    request.count(), request.start_page(), *data, false, request.show_codes(),
+                    departure_board_cache && departure_board_cache->enabled() ? departure_board_cache : nullptr);
         case pbnavitia::ROUTE_SCHEDULES:
             return timetables::route_schedule(request.departure_filter(),
                     forbidden_uri, from_datetime,
                     request.duration(), request.interface_version(), request.depth(),
-                    request.count(), request.start_page(), *data, false, request.show_codes());
+                    request.count(), request.start_page(), *data, false, request.show_codes(),
+                    conf.route_schedules_nb_threads());
         default:
             LOG4CPLUS_WARN(logger, "Unknown timetable query");
             pbnavitia::Response response;
@@ -570,6 +652,44 @@ pbnavitia::Response Worker::pt_ref(const pbnavitia::PTRefRequest &request){
 }
 
 
+pbnavitia::Response Worker::street_network_matrix(const pbnavitia::StreetNetworkMatrixRequest &request) {
+    const auto data = data_manager.get_data();
+    pbnavitia::Response pb_response;
+
+    const auto& modes = type::static_data::get()->modes_string.right;
+    const auto mode_it = modes.find(request.mode());
+    if (mode_it == modes.end()) {
+        fill_pb_error(pbnavitia::Error::bad_format, "unknown mode " + request.mode(), pb_response.mutable_error());
+        return pb_response;
+    }
+    const auto mode = mode_it->second;
+    const float speed_factor = request.has_speed() ? request.speed() / georef::default_speed[mode] : 1.;
+
+    auto get_coords = [&](const google::protobuf::RepeatedPtrField<pbnavitia::LocationContext>& places) {
+        std::vector<type::GeographicalCoord> coords;
+        for (const auto& place: places) {
+            type::EntryPoint ep(data->get_type_of_id(place.place()), place.place());
+            coords.push_back(this->coord_of_entry_point(ep, data));
+        }
+        return coords;
+    };
+    const auto origins = get_coords(request.origins());
+    const auto destinations = get_coords(request.destinations());
+
+    const auto matrix = georef::compute_durations_matrix(*data->geo_ref, origins, destinations, mode, speed_factor,
+                                                         navitia::seconds(request.max_duration()),
+                                                         conf.matrix_nb_threads());
+    auto* pb_matrix = pb_response.mutable_sn_matrix();
+    for (const auto& line: matrix) {
+        auto* row = pb_matrix->add_rows();
+        for (const auto& duration: line) {
+            row->add_durations(duration == bt::pos_infin ? -1 : duration.total_seconds());
+        }
+    }
+    return pb_response;
+}
+
+
 pbnavitia::Response Worker::dispatch(const pbnavitia::Request& request) {
     pbnavitia::Response response ;
     // These api can respond even if the data isn't loaded
@@ -591,6 +711,8 @@ pbnavitia::Response Worker::dispatch(const pbnavitia::Request& request) {
         case pbnavitia::ROUTE_SCHEDULES:
         case pbnavitia::NEXT_DEPARTURES:
         case pbnavitia::NEXT_ARRIVALS:
+        case pbnavitia::NEXT_DEPARTURES_BATCH:
+        case pbnavitia::NEXT_ARRIVALS_BATCH:
         case pbnavitia::STOPS_SCHEDULES:
         case pbnavitia::DEPARTURE_BOARDS:
             response = next_stop_times(request.next_stop_times(), request.requested_api()); break;
@@ -602,6 +724,7 @@ pbnavitia::Response Worker::dispatch(const pbnavitia::Request& request) {
         case pbnavitia::disruptions : response = disruptions(request.disruptions()); break;
         case pbnavitia::calendars : response = calendars(request.calendars()); break;
         case pbnavitia::place_code : response = place_code(request.place_code()); break;
+        case pbnavitia::street_network_matrix : response = street_network_matrix(request.sn_matrix()); break;
         default:
             LOG4CPLUS_WARN(logger, "Unknown API : " + API_Name(request.requested_api()));
             fill_pb_error(pbnavitia::Error::unknown_api, "Unknown API", response.mutable_error());
@@ -44,6 +44,8 @@ namespace routing{
 #include "kraken/data_manager.h"
 #include "utils/logger.h"
 #include "kraken/configuration.h"
+#include "kraken/response_cache.h"
+#include "time_tables/departure_board_cache.h"
 
 #include <memory>
 #include <limits>
@@ -59,11 +61,19 @@ class Worker {
         DataManager<navitia::type::Data>& data_manager;
         const kraken::Configuration conf;
         log4cplus::Logger logger;
+        // cache of the street network fallbacks, cleared when the data change
+        navitia::georef::FallbackCache fallback_cache;
         size_t last_data_identifier = std::numeric_limits<size_t>::max();// to check that data did not change, do not use directly
         boost::posix_time::ptime last_load_at;
+        // cache of the places and pt_objects responses, shared by all the workers (can be null)
+        ResponseCache* response_cache;
+        // cache of the departures of the stop points by day, shared by all the workers (can be null)
+        timetables::DepartureBoardCache* departure_board_cache;
 
     public:
-        Worker(DataManager<navitia::type::Data>& data_manager, kraken::Configuration conf);
+        Worker(DataManager<navitia::type::Data>& data_manager, kraken::Configuration conf,
+               ResponseCache* response_cache = nullptr,
+               timetables::DepartureBoardCache* departure_board_cache = nullptr);
         //we override de destructor this way we can forward declare Raptor
         //see: https://stackoverflow.com/questions/6012157/is-stdunique-ptrt-required-to-know-the-full-definition-of-t
         ~Worker();
@@ -88,6 +98,7 @@ class Worker {
         pbnavitia::Response calendars(const pbnavitia::CalendarsRequest &request);
         pbnavitia::Response pt_object(const pbnavitia::PtobjectRequest &request);
         pbnavitia::Response place_code(const pbnavitia::PlaceCodeRequest &request);
+        pbnavitia::Response street_network_matrix(const pbnavitia::StreetNetworkMatrixRequest &request);
 };
 
 }
@@ -0,0 +1,185 @@
+/* Copyright © 2001-2014, Canal TP and/or its affiliates. All rights reserved.
+  
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+ 
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+  
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+   
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+   
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+  
+Stay tuned using
+twitter @navitia 
+IRC #navitia on freenode
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#include "proximity_list.h"
+#include "type/data.h"
+#include "georef/georef.h"
+#include "utils/timer.h"
+#include "utils/init.h"
+#include <boost/program_options.hpp>
+#include <random>
+
+using namespace navitia;
+using navitia::type::GeographicalCoord;
+namespace po = boost::program_options;
+
+/** Former implementation of the ProximityList, used as a reference
+ *
+ * It is a vector sorted by longitude, we look for the longitude band and
+ * filter the items in it by distance.
+ */
+struct LonSortedList {
+    std::vector<std::pair<GeographicalCoord, type::idx_t>> items;
+
+    void build() {
+        std::sort(items.begin(), items.end(), [](const std::pair<GeographicalCoord, type::idx_t>& a,
+                                                 const std::pair<GeographicalCoord, type::idx_t>& b) {
+            return a.first < b.first;
+        });
+    }
+
+    std::vector<std::pair<type::idx_t, GeographicalCoord>> find_within(GeographicalCoord coord, double distance) const {
+        double distance_degree = distance / 111320;
+        double coslat = ::cos(coord.lat() * 0.0174532925199432958);
+        auto begin = std::lower_bound(items.begin(), items.end(), coord.lon() - distance_degree / coslat,
+                                      [](const std::pair<GeographicalCoord, type::idx_t>& i, double min) {
+            return i.first.lon() < min;
+        });
+        auto end = std::upper_bound(begin, items.end(), coord.lon() + distance_degree / coslat,
+                                    [](double max, const std::pair<GeographicalCoord, type::idx_t>& i) {
+            return max < i.first.lon();
+        });
+        std::vector<std::pair<type::idx_t, GeographicalCoord>> result;
+        double max_dist = distance * distance;
+        for(; begin != end; ++begin) {
+            if(begin->first.approx_sqr_distance(coord, coslat) <= max_dist)
+                result.push_back(std::make_pair(begin->second, begin->first));
+        }
+        std::sort(result.begin(), result.end(), [&](const std::pair<type::idx_t, GeographicalCoord>& a,
+                                                    const std::pair<type::idx_t, GeographicalCoord>& b) {
+            return a.second.approx_sqr_distance(coord, coslat) < b.second.approx_sqr_distance(coord, coslat);
+        });
+        return result;
+    }
+};
+
+int main(int argc, char** argv){
+    navitia::init_app();
+    po::options_description desc("Options of the proximity list benchmark");
+    std::string file;
+    int iterations, nb_points;
+    double distance;
+
+    desc.add_options()
+            ("help", "Show this message")
+            ("iterations,i", po::value<int>(&iterations)->default_value(100000),
+                     "Number of requests")
+            ("file,f", po::value<std::string>(&file),
+                     "Path to data.nav.lz4, the street network vertices are indexed. "
+                     "Without it, random points along a north-south corridor are generated")
+            ("nb_points,n", po::value<int>(&nb_points)->default_value(1000000),
+                     "Number of generated points (without data file)")
+            ("distance,d", po::value<double>(&distance)->default_value(500),
+                     "Radius of the requests (in meters)");
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+
+    if (vm.count("help")) {
+        std::cout << "This is used to benchmark the proximity list" << std::endl;
+        std::cout << desc << std::endl;
+        return 1;
+    }
+
+    std::mt19937 rng(31442);
+    std::vector<GeographicalCoord> coords;
+    if (! file.empty()) {
+        type::Data data;
+        {
+            Timer t("Loading data : " + file);
+            data.load(file);
+        }
+        for (georef::vertex_t v = 0; v < data.geo_ref->nb_vertex_by_mode; ++v) {
+            coords.push_back(data.geo_ref->graph[v].coord);
+        }
+    } else {
+        // a dense corridor (like a river or a valley) in a sparse region
+        std::normal_distribution<> corridor_lon(2.35, 0.01);
+        std::uniform_real_distribution<> lon(1.5, 3.2), lat(47.5, 49.5);
+        for (int i = 0; i < nb_points; ++i) {
+            coords.push_back(GeographicalCoord(i % 10 ? corridor_lon(rng) : lon(rng), lat(rng)));
+        }
+    }
+    if (coords.empty()) {
+        std::cout << "nothing to index" << std::endl;
+        return 1;
+    }
+
+    LonSortedList reference;
+    proximitylist::ProximityList<type::idx_t> pl;
+    for (type::idx_t idx = 0; idx < coords.size(); ++idx) {
+        reference.items.push_back({coords[idx], idx});
+        pl.add(coords[idx], idx);
+    }
+    {
+        Timer t("Building the longitude sorted list");
+        reference.build();
+    }
+    {
+        Timer t("Building the kd-tree");
+        pl.build();
+    }
+
+    // the requests are made around indexed points, where the requests usually are
+    std::uniform_int_distribution<size_t> gen(0, coords.size() - 1);
+    std::vector<GeographicalCoord> requests;
+    for (int i = 0; i < iterations; ++i) {
+        const auto& c = coords[gen(rng)];
+        requests.push_back(GeographicalCoord(c.lon() + 0.0001, c.lat() - 0.0001));
+    }
+
+    size_t nb_found_ref = 0, nb_found = 0, nb_nearest_ref = 0, nb_nearest = 0;
+    {
+        Timer t("find_within with the longitude sorted list");
+        for (const auto& c: requests) { nb_found_ref += reference.find_within(c, distance).size(); }
+    }
+    {
+        Timer t("find_within with the kd-tree");
+        for (const auto& c: requests) { nb_found += pl.find_within(c, distance).size(); }
+    }
+    {
+        Timer t("nearest with the longitude sorted list");
+        for (const auto& c: requests) { nb_nearest_ref += reference.find_within(c, distance).empty() ? 0 : 1; }
+    }
+    {
+        Timer t("nearest with the kd-tree");
+        for (const auto& c: requests) { nb_nearest += pl.find_k_nearest(c, 1, distance).size(); }
+    }
+
+    std::cout << "Number of indexed points: " << coords.size() << std::endl;
+    std::cout << "Number of requests: " << requests.size() << std::endl;
+    // the longitude band of the reference is a bit too narrow (111320m by degree), so it can miss
+    // some elements at the edge of the radius
+    std::cout << "Number of found elements: " << nb_found_ref << " (reference), "
+              << nb_found << " (kd-tree)" << std::endl;
+    std::cout << "Number of nearest found: " << nb_nearest_ref << " (reference), "
+              << nb_nearest << " (kd-tree)" << std::endl;
+    return 0;
+}
@@ -33,6 +33,7 @@ www.navitia.io
 #include "type/type.h"
 #include <vector>
 #include <cmath>
+#include <algorithm>
 
 namespace navitia { namespace proximitylist {
 
@@ -48,8 +49,15 @@ struct NotFound : public std::exception{
  *
  * Le template T est le type que l'on souhaite indexer (typiquement un Idx). L'élément sera copié.
  * On rajoute des élements itérativements et on appelle build pour construire l'indexe.
- * L'implémentation est un bête tableau trié par X.
- * On cherche les bornes inf/sup selon X, puis on itère sur les données et on garde les bonnes
+ *
+ * L'implémentation est un kd-tree implicite : le tableau est organisé récursivement
+ * de manière à ce que l'élément médian de chaque intervalle [begin, end) sépare
+ * les éléments selon la longitude (profondeur paire) ou la latitude (profondeur impaire).
+ * Aucune structure supplémentaire n'est nécessaire et la répartition reste équilibrée
+ * même avec des données très hétérogènes (zones denses, points isolés en (0, 0), ...).
+ *
+ * Les distances utilisées sont celles de GeographicalCoord::approx_sqr_distance,
+ * la coupure selon un axe en donne un minorant ce qui permet d'élaguer les sous-arbres.
  */
 
 template<class T>
@@ -66,7 +74,7 @@ struct ProximityList
         }
     };
 
-    /// Contient toutes les coordonnées de manière à trouver rapidement
+    /// Contient toutes les coordonnées, organisées en kd-tree par build
     std::vector<Item> items;
 
     /// Rajoute un nouvel élément. Attention, il faut appeler build avant de pouvoir utiliser la structure
@@ -79,28 +87,31 @@ struct ProximityList
 
     /// Construit l'indexe
     void build(){
-        std::sort(items.begin(), items.end(), [](const Item & a, const Item & b){return a.coord < b.coord;});
+        build_rec(0, items.size(), 0);
     }
 
-    /// Retourne tous les éléments dans un rayon de x mètres
+    /// Retourne tous les éléments dans un rayon de x mètres, triés par distance croissante
     std::vector< std::pair<T, GeographicalCoord> > find_within(GeographicalCoord coord, double distance = 500) const {
-        double distance_degree = distance / 111320;
-
-        double DEG_TO_RAD = 0.0174532925199432958;
-        double coslat = ::cos(coord.lat() * DEG_TO_RAD);
-
-        auto begin = std::lower_bound(items.begin(), items.end(), coord.lon() - distance_degree / coslat, [](const Item & i, double min){return i.coord.lon() < min;});
-        auto end = std::upper_bound(begin, items.end(), coord.lon() + distance_degree / coslat, [](double max, const Item & i){return max < i.coord.lon();});
-        std::vector< std::pair<T, GeographicalCoord> > result;
-        double max_dist = distance * distance;
-        for(; begin != end; ++begin){
-            if(begin->coord.approx_sqr_distance(coord, coslat) <= max_dist)
-                result.push_back(std::make_pair(begin->element, begin->coord));
-        }
-        std::sort(result.begin(), result.end(), [&coord, &coslat](const std::pair<T, GeographicalCoord> & a, const std::pair<T, GeographicalCoord> & b){return a.second.approx_sqr_distance(coord, coslat) < b.second.approx_sqr_distance(coord, coslat);});
-        return result;
+        const double coslat = ::cos(coord.lat() * DEG_TO_RAD);
+        std::vector<std::pair<double, size_t>> found;
+        collect_within(0, items.size(), 0, coord, coslat, distance * distance, found);
+        std::sort(found.begin(), found.end());
+        return make_result(found);
     }
 
+    /** Retourne les k éléments les plus proches dans un rayon de x mètres, triés par distance croissante
+     *
+     * Contrairement à find_within, le travail ne dépend pas du nombre d'éléments dans le rayon
+     */
+    std::vector< std::pair<T, GeographicalCoord> > find_k_nearest(GeographicalCoord coord, size_t k, double distance = 500) const {
+        std::vector<std::pair<double, size_t>> heap;
+        if (k == 0) { return {}; }
+        const double coslat = ::cos(coord.lat() * DEG_TO_RAD);
+        heap.reserve(k);
+        collect_k_nearest(0, items.size(), 0, coord, coslat, k, distance * distance, heap);
+        std::sort_heap(heap.begin(), heap.end());
+        return make_result(heap);
+    }
 
     /// Fonction de confort pour retrouver l'élément le plus proche dans l'indexe
     T find_nearest(double lon, double lat) const {
@@ -109,7 +120,7 @@ struct ProximityList
 
     /// Retourne l'élément le plus proche dans tout l'indexe
     T find_nearest(GeographicalCoord coord, double max_dist = 500) const {
-        auto temp = find_within(coord, max_dist);
+        auto temp = find_k_nearest(coord, 1, max_dist);
         if(temp.empty())
             throw NotFound();
         else
@@ -125,6 +136,97 @@ struct ProximityList
         ar & items;
     }
 
+private:
+    static constexpr double DEG_TO_RAD = 0.0174532925199432958;
+
+    static bool split_on_lon(size_t depth) { return depth % 2 == 0; }
+
+    /// Minorant (au carré) de la distance entre coord et tout point de l'autre côté du plan de coupe
+    static double sqr_distance_to_split(const GeographicalCoord& coord, double coslat,
+                                        const GeographicalCoord& split, size_t depth) {
+        if (split_on_lon(depth)) {
+            return coord.approx_sqr_distance(GeographicalCoord(split.lon(), coord.lat()), coslat);
+        }
+        return coord.approx_sqr_distance(GeographicalCoord(coord.lon(), split.lat()), coslat);
+    }
+
+    static bool is_before_split(const GeographicalCoord& coord, const GeographicalCoord& split, size_t depth) {
+        return split_on_lon(depth) ? coord.lon() < split.lon() : coord.lat() < split.lat();
+    }
+
+    void build_rec(size_t begin, size_t end, size_t depth) {
+        if (end - begin <= 1) { return; }
+        const size_t median = begin + (end - begin) / 2;
+        const bool on_lon = split_on_lon(depth);
+        std::nth_element(items.begin() + begin, items.begin() + median, items.begin() + end,
+                         [on_lon](const Item& a, const Item& b) {
+            return on_lon ? a.coord.lon() < b.coord.lon() : a.coord.lat() < b.coord.lat();
+        });
+        build_rec(begin, median, depth + 1);
+        build_rec(median + 1, end, depth + 1);
+    }
+
+    void collect_within(size_t begin, size_t end, size_t depth, const GeographicalCoord& coord,
+                        double coslat, double max_sqr_dist,
+                        std::vector<std::pair<double, size_t>>& found) const {
+        if (begin >= end) { return; }
+        const size_t median = begin + (end - begin) / 2;
+        const Item& split = items[median];
+        const double sqr_dist = split.coord.approx_sqr_distance(coord, coslat);
+        if (sqr_dist <= max_sqr_dist) {
+            found.push_back({sqr_dist, median});
+        }
+        const bool before = is_before_split(coord, split.coord, depth);
+        const bool cross = sqr_distance_to_split(coord, coslat, split.coord, depth) <= max_sqr_dist;
+        if (before || cross) {
+            collect_within(begin, median, depth + 1, coord, coslat, max_sqr_dist, found);
+        }
+        if (! before || cross) {
+            collect_within(median + 1, end, depth + 1, coord, coslat, max_sqr_dist, found);
+        }
+    }
+
+    /// heap est un tas-max sur la distance contenant au plus k éléments
+    void collect_k_nearest(size_t begin, size_t end, size_t depth, const GeographicalCoord& coord,
+                           double coslat, size_t k, double max_sqr_dist,
+                           std::vector<std::pair<double, size_t>>& heap) const {
+        if (begin >= end) { return; }
+        const size_t median = begin + (end - begin) / 2;
+        const Item& split = items[median];
+        const double sqr_dist = split.coord.approx_sqr_distance(coord, coslat);
+        auto current_bound = [&]() {
+            return heap.size() < k ? max_sqr_dist : std::min(max_sqr_dist, heap.front().first);
+        };
+        if (sqr_dist <= current_bound()) {
+            if (heap.size() == k) {
+                std::pop_heap(heap.begin(), heap.end());
+                heap.pop_back();
+            }
+            heap.push_back({sqr_dist, median});
+            std::push_heap(heap.begin(), heap.end());
+        }
+        // on commence par le côté de la coupe où se trouve coord pour resserrer la borne au plus vite
+        const bool before = is_before_split(coord, split.coord, depth);
+        const size_t near_begin = before ? begin : median + 1;
+        const size_t near_end = before ? median : end;
+        const size_t far_begin = before ? median + 1 : begin;
+        const size_t far_end = before ? end : median;
+        collect_k_nearest(near_begin, near_end, depth + 1, coord, coslat, k, max_sqr_dist, heap);
+        if (sqr_distance_to_split(coord, coslat, split.coord, depth) <= current_bound()) {
+            collect_k_nearest(far_begin, far_end, depth + 1, coord, coslat, k, max_sqr_dist, heap);
+        }
+    }
+
+    std::vector< std::pair<T, GeographicalCoord> >
+    make_result(const std::vector<std::pair<double, size_t>>& sorted_found) const {
+        std::vector< std::pair<T, GeographicalCoord> > result;
+        result.reserve(sorted_found.size());
+        for (const auto& dist_idx: sorted_found) {
+            const Item& item = items[dist_idx.second];
+            result.push_back(std::make_pair(item.element, item.coord));
+        }
+        return result;
+    }
 };
 
 }} // namespace navitia::proximitylist
@@ -114,9 +114,15 @@ BOOST_AUTO_TEST_CASE(find_nearest){
 
     pl.build();
 
-    std::vector<unsigned int> expected {1,4,2,6,5,3};
-    for(size_t i=0; i < expected.size(); ++i)
-        BOOST_CHECK_EQUAL(pl.items[i].element, expected[i]);
+    // the root of the kd-tree splits the elements on the longitude
+    std::vector<unsigned int> expected {1,2,3,4,5,6};
+    std::vector<unsigned int> tmp;
+    for(const auto& item : pl.items) tmp.push_back(item.element);
+    std::sort(tmp.begin(), tmp.end());
+    BOOST_CHECK_EQUAL_COLLECTIONS(tmp.begin(), tmp.end(), expected.begin(), expected.end());
+    BOOST_CHECK_EQUAL(pl.items[pl.items.size() / 2].element, 6);
+    for(size_t i=0; i < pl.items.size() / 2; ++i)
+        BOOST_CHECK_LE(pl.items[i].coord.lon(), pl.items[pl.items.size() / 2].coord.lon());
 
 
     c.set_lon(M_TO_DEG *2); c.set_lat(M_TO_DEG *3);
@@ -132,7 +138,7 @@ BOOST_AUTO_TEST_CASE(find_nearest){
 
     expected = {1};
     auto tmp1 = pl.find_within(c, 1.1);
-    std::vector<unsigned int> tmp;
+    tmp.clear();
     for(auto p : tmp1) tmp.push_back(p.first);
     BOOST_CHECK_EQUAL(tmp1[0].second, coords[0]);
     BOOST_CHECK_EQUAL_COLLECTIONS(tmp.begin(), tmp.end(), expected.begin(), expected.end());
@@ -171,6 +177,46 @@ BOOST_AUTO_TEST_CASE(find_nearest){
     for(auto p : tmp1) tmp.push_back(p.first);
     std::sort(tmp.begin(), tmp.end());
     BOOST_CHECK_EQUAL_COLLECTIONS(tmp.begin(), tmp.end(), expected.begin(), expected.end());
+
+    // find_within must give the elements sorted by distance
+    expected={1,2,4,6,5,3};
+    tmp.clear();
+    tmp1 = pl.find_within(c, 7.3);
+    for(auto p : tmp1) tmp.push_back(p.first);
+    BOOST_CHECK_EQUAL_COLLECTIONS(tmp.begin(), tmp.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(find_k_nearest){
+    constexpr double M_TO_DEG = 1.0/111320.0;
+    ProximityList<unsigned int> pl;
+    // a north-south corridor of 100 elements, one every 10m
+    for(unsigned int i = 0; i < 100; ++i) {
+        pl.add(GeographicalCoord(0, M_TO_DEG * 10 * i), i);
+    }
+    // and an element far away
+    pl.add(GeographicalCoord(M_TO_DEG * 2000, 0), 100);
+    pl.build();
+
+    GeographicalCoord c(M_TO_DEG * 1, M_TO_DEG * 501);
+    auto res = pl.find_k_nearest(c, 3);
+    std::vector<unsigned int> tmp;
+    for(auto p : res) tmp.push_back(p.first);
+    std::vector<unsigned int> expected = {50, 51, 49};
+    BOOST_CHECK_EQUAL_COLLECTIONS(tmp.begin(), tmp.end(), expected.begin(), expected.end());
+
+    // the limit of the distance is respected
+    res = pl.find_k_nearest(c, 3, 5);
+    BOOST_REQUIRE_EQUAL(res.size(), 1);
+    BOOST_CHECK_EQUAL(res[0].first, 50);
+
+    // we cannot get more than what is in the radius
+    res = pl.find_k_nearest(GeographicalCoord(M_TO_DEG * 2000, 0), 10);
+    BOOST_REQUIRE_EQUAL(res.size(), 1);
+    BOOST_CHECK_EQUAL(res[0].first, 100);
+
+    BOOST_CHECK(pl.find_k_nearest(c, 0).empty());
+    BOOST_CHECK_EQUAL(pl.find_nearest(GeographicalCoord(M_TO_DEG * 1990, 0)), 100);
+    BOOST_CHECK_THROW(pl.find_nearest(GeographicalCoord(M_TO_DEG * 1000, 0)), NotFound);
 }
 
 BOOST_AUTO_TEST_CASE(test_api) {
@@ -30,8 +30,11 @@ www.navitia.io
 
 #include "ptref_graph.h"
 #include "ptreferential.h"
+#include "type/data.h"
+#include <boost/range/iterator_range.hpp>
 
 namespace navitia { namespace ptref {
+using type::idx_t;
 
 
 /** Contient le graph des transitions
@@ -109,16 +112,86 @@ Jointures::Jointures() {
     boost::add_edge(vertex_map[Type_e::Line], vertex_map[Type_e::Calendar], g);
 }
 
+Jointures::Jointures(const type::Data& data) : Jointures() {
+    // un arc (u,v) permet d'obtenir u à partir de v : les relations vont de v vers u
+    for (const auto e: boost::make_iterator_range(boost::edges(g))) {
+        const Type_e obtained = g[boost::source(e, g)];
+        const Type_e from = g[boost::target(e, g)];
+        adjacencies[{from, obtained}] = Adjacency(from, obtained, data);
+    }
+}
+
+Adjacency::Adjacency(Type_e source, Type_e target, const type::Data& data) :
+    nb_sources(data.get_nb_obj(source)), nb_targets(data.get_nb_obj(target)) {
+    offsets.reserve(nb_sources + 1);
+    offsets.push_back(0);
+    for (idx_t idx = 0; idx < nb_sources; ++idx) {
+        auto tmp = data.get_target_by_one_source(source, target, idx);
+        std::sort(tmp.begin(), tmp.end());
+        targets.insert(targets.end(), tmp.begin(), std::unique(tmp.begin(), tmp.end()));
+        offsets.push_back(targets.size());
+    }
+    targets.shrink_to_fit();
+}
+
+boost::dynamic_bitset<> Adjacency::propagate(const boost::dynamic_bitset<>& sources) const {
+    boost::dynamic_bitset<> result(nb_targets);
+    for (auto idx = sources.find_first(); idx != sources.npos; idx = sources.find_next(idx)) {
+        for (auto i = offsets[idx]; i < offsets[idx + 1]; ++i) {
+            result.set(targets[i]);
+        }
+    }
+    return result;
+}
+
+boost::dynamic_bitset<> Jointures::propagate(Type_e source, Type_e target,
+                                             const boost::dynamic_bitset<>& sources,
+                                             const type::Data& data) const {
+    const auto it = adjacencies.find({source, target});
+    if (it == adjacencies.end()) {
+        // built without data: the relations are followed object by object
+        const auto indexes = data.get_target_by_source(source, target, make_indexes(sources));
+        return make_bitset(target, indexes, data);
+    }
+    if (it->second.nb_sources != sources.size() || it->second.nb_targets != data.get_nb_obj(target)) {
+        throw navitia::exception("the ptref relations are out of date, "
+                                 "Data::build_jointures must be called after modifying the data");
+    }
+    return it->second.propagate(sources);
+}
+
+boost::dynamic_bitset<> make_bitset(Type_e type, const std::vector<idx_t>& indexes,
+                                    const type::Data& data) {
+    boost::dynamic_bitset<> result(data.get_nb_obj(type));
+    for (const idx_t idx: indexes) {
+        if (idx < result.size()) { result.set(idx); }
+    }
+    return result;
+}
+
+std::vector<idx_t> make_indexes(const boost::dynamic_bitset<>& bitset) {
+    std::vector<idx_t> result;
+    result.reserve(bitset.count());
+    for (auto idx = bitset.find_first(); idx != bitset.npos; idx = bitset.find_next(idx)) {
+        result.push_back(idx);
+    }
+    return result;
+}
+
 // Retourne un map qui indique pour chaque type par quel type on peut l'atteindre
 // Si le prédécesseur est égal au type, c'est qu'il n'y a pas de chemin
 std::map<Type_e,Type_e> find_path(Type_e source) {
-    Jointures j;
-    if(j.vertex_map.find(source) == j.vertex_map.end()){
+    return find_path(source, Jointures());
+}
+
+std::map<Type_e,Type_e> find_path(Type_e source, const Jointures& j) {
+    const auto vertex = j.vertex_map.find(source);
+    if(vertex == j.vertex_map.end()){
         throw ptref_error("Type doesnot exist as a vertex");
     }
 
     std::vector<vertex_t> predecessors(boost::num_vertices(j.g));
-    boost::dijkstra_shortest_paths(j.g, j.vertex_map[source],
+    boost::dijkstra_shortest_paths(j.g, vertex->second,
                                    boost::predecessor_map(&predecessors[0]).
                                    weight_map(boost::get(&Edge::weight, j.g)));
 
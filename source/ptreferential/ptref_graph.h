@@ -33,6 +33,11 @@ www.navitia.io
 #include "type/type.h"
 #include <boost/graph/adjacency_list.hpp>
 #include <boost/graph/dijkstra_shortest_paths.hpp>
+#include <boost/dynamic_bitset.hpp>
+
+namespace navitia { namespace type {
+class Data;
+}}
 
 namespace navitia { namespace ptref {
 
@@ -46,10 +51,54 @@ typedef boost::adjacency_list<boost::listS, boost::vecS, boost::directedS, type:
 typedef boost::graph_traits<Graph>::vertex_descriptor vertex_t;
 typedef boost::graph_traits<Graph>::edge_descriptor edge_t;
 
+/** Les relations précalculées d'un type source vers un type cible voisin dans le graphe
+  *
+  * The targets of each source are stored contiguously (compressed sparse rows),
+  * the targets of source i are targets[offsets[i]] .. targets[offsets[i+1]]
+  */
+struct Adjacency {
+    size_t nb_sources = 0;
+    size_t nb_targets = 0;
+    std::vector<uint32_t> offsets;
+    std::vector<type::idx_t> targets;
+
+    Adjacency() {}
+    Adjacency(type::Type_e source, type::Type_e target, const type::Data& data);
+
+    /// Union of the targets of all the sources in the bitset
+    boost::dynamic_bitset<> propagate(const boost::dynamic_bitset<>& sources) const;
+};
+
 struct Jointures {
     std::map<type::Type_e, vertex_t> vertex_map;
     Graph g;
+
+    /// The relations of each edge of the graph, by (source, target). Empty when built without data
+    std::map<std::pair<type::Type_e, type::Type_e>, Adjacency> adjacencies;
+
     Jointures();
+    /// Builds the graph and the relations of the data for each of its edges
+    explicit Jointures(const type::Data& data);
+
+    /** The objects of target reached from the sources, as a bitset over the target collection
+      *
+      * Uses the precomputed relations, or Data::get_target_by_source when built without data.
+      * The relations must have been built after the last modification of the data: a size that
+      * does not match anymore throws.
+      */
+    boost::dynamic_bitset<> propagate(type::Type_e source, type::Type_e target,
+                                      const boost::dynamic_bitset<>& sources,
+                                      const type::Data& data) const;
 };
 
+/// Comme find_path(source), avec le graphe déjà construit
+std::map<type::Type_e, type::Type_e> find_path(type::Type_e source, const Jointures& jointures);
+
+/// Un bitset sur tous les objets d'un type, avec les indexes donnés
+boost::dynamic_bitset<> make_bitset(type::Type_e type, const std::vector<type::idx_t>& indexes,
+                                    const type::Data& data);
+
+/// Les indexes des bits positionnés, triés
+std::vector<type::idx_t> make_indexes(const boost::dynamic_bitset<>& bitset);
+
 }}
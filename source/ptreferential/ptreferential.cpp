@@ -31,6 +31,7 @@ www.navitia.io
 #include "ptreferential.h"
 #include "reflexion.h"
 #include "where.h"
+#include "ptref_graph.h"
 #include "proximity_list/proximity_list.h"
 #include "type/data.h"
 
@@ -123,9 +124,130 @@ std::vector<idx_t> filtered_indexes(const std::vector<T> & data, const C & claus
     return result;
 }
 
+/// Les objets d'uri donnée, par la map des uris. Returns false when there is no complete map for this type
 template<typename T>
-std::vector<idx_t> get_indexes(Filter filter,  Type_e requested_type, const Data & d) {
-    auto data = d.get_data<T>();
+static bool find_by_uri(const Data&, const std::string&, std::vector<idx_t>&) {
+    return false;
+}
+
+#define FIND_BY_URI(type_name, collection_name)\
+template<>\
+bool find_by_uri<type_name>(const Data& d, const std::string& uri, std::vector<idx_t>& indexes) {\
+    const auto& map = d.pt_data->collection_name##_map;\
+    /* the map is not always built, in the tests */\
+    if (map.size() != d.pt_data->collection_name.size()) { return false; }\
+    const auto it = map.find(uri);\
+    if (it != map.end()) { indexes.push_back(it->second->idx); }\
+    return true;\
+}
+ITERATE_NAVITIA_PT_TYPES(FIND_BY_URI)
+
+template<>
+bool find_by_uri<georef::POI>(const Data& d, const std::string& uri, std::vector<idx_t>& indexes) {
+    const auto& map = d.geo_ref->poi_map;
+    if (map.size() != d.geo_ref->pois.size()) { return false; }
+    const auto it = map.find(uri);
+    if (it != map.end()) { indexes.push_back(it->second); }
+    return true;
+}
+
+template<>
+bool find_by_uri<georef::POIType>(const Data& d, const std::string& uri, std::vector<idx_t>& indexes) {
+    const auto& map = d.geo_ref->poitype_map;
+    if (map.size() != d.geo_ref->poitypes.size()) { return false; }
+    const auto it = map.find(uri);
+    if (it != map.end()) { indexes.push_back(it->second); }
+    return true;
+}
+
+/// Les objets de nom donné, par l'index trié par nom. Returns false when the type is not indexed
+template<typename T>
+static bool find_by_name(const Data&, const std::string&, std::vector<idx_t>&) {
+    return false;
+}
+
+template<typename T>
+struct NameCompare {
+    const std::vector<T*>& objects;
+    bool operator()(idx_t idx, const std::string& name) const { return objects[idx]->name < name; }
+    bool operator()(const std::string& name, idx_t idx) const { return name < objects[idx]->name; }
+};
+
+#define FIND_BY_NAME(type_name, collection_name)\
+template<>\
+bool find_by_name<type_name>(const Data& d, const std::string& name, std::vector<idx_t>& indexes) {\
+    const auto& objects = d.pt_data->collection_name;\
+    const auto& by_name = d.pt_data->collection_name##_by_name;\
+    if (by_name.size() != objects.size()) { return false; }\
+    const auto range = std::equal_range(by_name.begin(), by_name.end(), name, NameCompare<type_name>{objects});\
+    indexes.insert(indexes.end(), range.first, range.second);\
+    return true;\
+}
+
+ITERATE_NAVITIA_PT_NAMED_TYPES(FIND_BY_NAME)
+
+/// Le type des codes externes de T dans ext_codes_map, false if the codes of T are not indexed
+template<typename T>
+static bool ext_code_type(pbnavitia::PlaceCodeRequest::Type&) {
+    return false;
+}
+
+#define EXT_CODE_TYPE(type_name)\
+template<>\
+bool ext_code_type<type_name>(pbnavitia::PlaceCodeRequest::Type& type) {\
+    type = pbnavitia::PlaceCodeRequest::type_name;\
+    return true;\
+}
+EXT_CODE_TYPE(StopArea)
+EXT_CODE_TYPE(Network)
+EXT_CODE_TYPE(Company)
+EXT_CODE_TYPE(Line)
+EXT_CODE_TYPE(Route)
+EXT_CODE_TYPE(VehicleJourney)
+EXT_CODE_TYPE(StopPoint)
+EXT_CODE_TYPE(Calendar)
+
+/** Répond au filtre avec les indexes des données, sans parcourir toute la collection
+  *
+  * - uri = value: the maps of the uris
+  * - name = value: the indexes sorted by name
+  * - type_code = value: ext_codes_map, for the types of code of the object (like external_code)
+  *
+  * Returns false when the filter can not be answered by an index
+  */
+template<typename T>
+bool indexed_filter(const Filter& filter, const Data& d, std::vector<idx_t>& indexes) {
+    if (filter.op != EQ) { return false; }
+    if (filter.attribute == "uri") {
+        return find_by_uri<T>(d, filter.value, indexes);
+    }
+    if (filter.attribute == "name") {
+        return find_by_name<T>(d, filter.value, indexes);
+    }
+    pbnavitia::PlaceCodeRequest::Type code_type;
+    if (! ext_code_type<T>(code_type)) { return false; }
+    const auto& codes_by_type = d.pt_data->ext_codes_map[code_type];
+    const auto codes = codes_by_type.find(filter.attribute);
+    if (codes == codes_by_type.end()) { return false; }
+    const auto uri = codes->second.find(filter.value);
+    if (uri != codes->second.end()) {
+        if (! find_by_uri<T>(d, uri->second, indexes)) {
+            // no map: the code gives the uri, the object is looked for by a scan on the uri
+            indexes = filtered_indexes(d.get_data<T>(), WHERE(ptr_uri<T>(), EQ, uri->second));
+        }
+    }
+    return true;
+}
+
+/// Le graphe des relations de la donnée, ou le graphe seul quand les relations n'ont pas été construites
+static const Jointures& get_jointures(const Data& d) {
+    static const Jointures graph_only;
+    return d.jointures ? *d.jointures : graph_only;
+}
+
+/// Les objets du type demandé qui satisfont le filtre, en bitset sur tous les objets du type demandé
+template<typename T>
+boost::dynamic_bitset<> get_bitset(Filter filter,  Type_e requested_type, const Data & d) {
     std::vector<idx_t> indexes;
     if(filter.op == DWITHIN) {
         std::vector<std::string> splited;
@@ -171,18 +293,32 @@ std::vector<idx_t> get_indexes(Filter filter,  Type_e requested_type, const Data
             }
         }
     }
-    else {
-        indexes = filtered_indexes(data, build_clause<T>({filter}));
+    else if (! indexed_filter<T>(filter, d, indexes)) {
+        indexes = filtered_indexes(d.get_data<T>(), build_clause<T>({filter}));
     }
     Type_e current = filter.navitia_type;
-    std::map<Type_e, Type_e> path = find_path(requested_type);
+    const Jointures& jointures = get_jointures(d);
+    std::map<Type_e, Type_e> path = find_path(requested_type, jointures);
+    // the relations are followed as unions of bitsets, without duplicates to remove
+    boost::dynamic_bitset<> bitset = make_bitset(current, indexes, d);
     while(path[current] != current){
-        indexes = d.get_target_by_source(current, path[current], indexes);
+        bitset = jointures.propagate(current, path[current], bitset, d);
         current = path[current];
     }
+    if (current != requested_type) {
+        // no relation leads to the requested objects
+        return boost::dynamic_bitset<>(d.get_nb_obj(requested_type));
+    }
+    return bitset;
+}
 
-    return indexes;
+template<typename T>
+std::vector<idx_t> get_indexes(Filter filter,  Type_e requested_type, const Data & d) {
+    return make_indexes(get_bitset<T>(filter, requested_type, d));
 }
+#define INSTANCIATE_GET_INDEXES(type_name, collection_name)\
+template std::vector<idx_t> get_indexes<type_name>(Filter, Type_e, const Data&);
+ITERATE_NAVITIA_PT_TYPES(INSTANCIATE_GET_INDEXES)
 
 std::vector<Filter> parse(std::string request){
     std::string::iterator begin = request.begin();
@@ -282,26 +418,26 @@ std::vector<idx_t> make_query(Type_e requested_type, std::string request,
                     "Filter Unknown object type: " + filter.object);
         }
     }
-    std::vector<idx_t> final_indexes = data.get_all_index(requested_type);
+    // the filters are combined as bitsets over the requested objects: AND, then AND NOT for the forbidden ones
+    boost::dynamic_bitset<> final_bitset(data.get_nb_obj(requested_type));
     // When we have no objets asked(like for example companies)
-    if(final_indexes.empty()){
+    if(final_bitset.empty()){
         throw ptref_error("Filters: No requested object in the database");
     }
+    final_bitset.set();
 
-    std::vector<idx_t> indexes;
     for(const Filter & filter : filters){
         switch(filter.navitia_type){
-#define GET_INDEXES(type_name, collection_name) case Type_e::type_name: indexes = get_indexes<type_name>(filter, requested_type, data); break;
+#define GET_INDEXES(type_name, collection_name) case Type_e::type_name: final_bitset &= get_bitset<type_name>(filter, requested_type, data); break;
         ITERATE_NAVITIA_PT_TYPES(GET_INDEXES)
-            case Type_e::POI: indexes = get_indexes<georef::POI>(filter, requested_type, data); break;
-            case Type_e::POIType: indexes = get_indexes<georef::POIType>(filter, requested_type, data); break;
-            case Type_e::Connection: indexes = get_indexes<type::StopPointConnection>(filter, requested_type, data); break;
+            case Type_e::POI: final_bitset &= get_bitset<georef::POI>(filter, requested_type, data); break;
+            case Type_e::POIType: final_bitset &= get_bitset<georef::POIType>(filter, requested_type, data); break;
+            case Type_e::Connection: final_bitset &= get_bitset<type::StopPointConnection>(filter, requested_type, data); break;
         default:
             throw parsing_error(parsing_error::partial_error,
                     "Filter: Unable to find the requested type. Not parsed: >>"
                     + nt::static_data::get()->captionByType(filter.navitia_type) + "<<");
         }
-        final_indexes = get_intersection(final_indexes, indexes);
     }
     //We now filter with forbidden uris
     for(const auto forbidden_uri : forbidden_uris) {
@@ -319,24 +455,23 @@ std::vector<idx_t> make_query(Type_e requested_type, std::string request,
 
         Filter filter_forbidden(caption_type, "uri", Operator_e::EQ, forbidden_uri);
         filter_forbidden.navitia_type = type_;
-        std::vector<idx_t> forbidden_idx;
         switch(type_){
-#define GET_INDEXES_FORBID(type_name, collection_name) case Type_e::type_name: forbidden_idx = get_indexes<type_name>(filter_forbidden, requested_type, data); break;
+#define GET_INDEXES_FORBID(type_name, collection_name) case Type_e::type_name: final_bitset -= get_bitset<type_name>(filter_forbidden, requested_type, data); break;
         ITERATE_NAVITIA_PT_TYPES(GET_INDEXES_FORBID)
             case Type_e::POI:
-                forbidden_idx = get_indexes<georef::POI>(filter_forbidden, requested_type, data);
+                final_bitset -= get_bitset<georef::POI>(filter_forbidden, requested_type, data);
                 break;
             case Type_e::POIType:
-                forbidden_idx = get_indexes<georef::POIType>(filter_forbidden, requested_type, data);
+                final_bitset -= get_bitset<georef::POIType>(filter_forbidden, requested_type, data);
                 break;
             case Type_e::Connection:
-                forbidden_idx = get_indexes<type::StopPointConnection>(filter_forbidden, requested_type, data);
+                final_bitset -= get_bitset<type::StopPointConnection>(filter_forbidden, requested_type, data);
                 break;
         default:
             throw parsing_error(parsing_error::partial_error,"Filter: Unable to find the requested type. Not parsed: >>" + nt::static_data::get()->captionByType(filter_forbidden.navitia_type) + "<<");
         }
-        final_indexes = get_difference(final_indexes, forbidden_idx);
     }
+    std::vector<idx_t> final_indexes = make_indexes(final_bitset);
        // Manage OdtLevel
     final_indexes = manage_odt_level(final_indexes, requested_type, odt_level, data);
     // When the filters have emptied the results
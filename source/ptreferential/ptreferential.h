@@ -37,14 +37,17 @@ www.navitia.io
   * On peut faire poser des filtres sur n'importe quel objet
   *
   * ptref_graph.cpp contient toutes les relations entre entités : par quelles relations on obtient
-  * les stoppoints d'une commune
+  * les stoppoints d'une commune. The relations of the data along each edge are precomputed
+  * (Data::build_jointures) and followed as unions of bitsets
   *
   * ptreferential.h permet d'analyser les filtres saisis par l'utilisateur. Le parsage se fait avec
   * boost::spirit. Ce n'est pas la lib la plus simple à apprendre, mais elle est performante et puissante
   *
   * Le fonctionnement global est :
-  * 1) Pour chaque filtre on trouve les indexes qui correspondent
-  * 2) On fait l'intersection des indexes obtenus par chaque filtre
+  * 1) Pour chaque filtre on trouve les indexes qui correspondent : by the uri maps, the name indexes or
+  *    the external codes when the filter is an equality, by a scan of the collection otherwise
+  * 2) On fait l'intersection des indexes obtenus par chaque filtre (AND of the bitsets, AND NOT for
+  *    the forbidden uris)
   * 3) On remplit le protobuf
   */
 
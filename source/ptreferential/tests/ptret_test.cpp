@@ -38,6 +38,7 @@ www.navitia.io
 
 #include <boost/graph/strong_components.hpp>
 #include <boost/graph/connected_components.hpp>
+#include <algorithm>
 #include "type/pt_data.h"
 
 namespace navitia{namespace ptref {
@@ -276,6 +277,128 @@ BOOST_AUTO_TEST_CASE(forbidden_uri) {
 
     BOOST_CHECK_THROW(make_query(navitia::type::Type_e::Line, "stop_point.uri=stop1", {"A"}, *(b.data)), ptref_error);
 }
+BOOST_AUTO_TEST_CASE(make_query_indexed_filters) {
+    ed::builder b("201303011T1739");
+    b.generate_dummy_basis();
+    b.vj("A")("stop1", 8000,8050)("stop2", 8200,8250);
+    b.vj("B")("stop3", 9000,9050)("stop4", 9200,9250);
+    b.finish();
+    for (auto* sa: b.data->pt_data->stop_areas) {
+        sa->name = "gare " + sa->uri;
+        if (sa->uri == "stop3") { sa->codes["external_code"] = "ext3"; }
+    }
+    b.data->pt_data->build_uri();
+    const auto& stop_areas = b.data->pt_data->stop_areas;
+
+    // the uri by the map
+    auto indexes = make_query(navitia::type::Type_e::StopArea, "stop_area.uri=stop2", *(b.data));
+    BOOST_REQUIRE_EQUAL(indexes.size(), 1);
+    BOOST_CHECK_EQUAL(stop_areas[indexes[0]]->uri, "stop2");
+    BOOST_CHECK_THROW(make_query(navitia::type::Type_e::StopArea, "stop_area.uri=stop42", *(b.data)), ptref_error);
+
+    // the name by the sorted index
+    indexes = make_query(navitia::type::Type_e::StopArea, "stop_area.name=\"gare stop4\"", *(b.data));
+    BOOST_REQUIRE_EQUAL(indexes.size(), 1);
+    BOOST_CHECK_EQUAL(stop_areas[indexes[0]]->uri, "stop4");
+
+    // the external codes
+    indexes = make_query(navitia::type::Type_e::StopArea, "stop_area.external_code=ext3", *(b.data));
+    BOOST_REQUIRE_EQUAL(indexes.size(), 1);
+    BOOST_CHECK_EQUAL(stop_areas[indexes[0]]->uri, "stop3");
+
+    // not indexed, the stop areas are scanned
+    indexes = make_query(navitia::type::Type_e::StopArea, "stop_area.uri<>stop2", *(b.data));
+    BOOST_CHECK_EQUAL(indexes.size(), stop_areas.size() - 1);
+
+    // the relations are followed from the indexed objects
+    indexes = make_query(navitia::type::Type_e::StopArea, "line.uri=A and stop_area.name=\"gare stop1\"", *(b.data));
+    BOOST_REQUIRE_EQUAL(indexes.size(), 1);
+    BOOST_CHECK_EQUAL(stop_areas[indexes[0]]->uri, "stop1");
+}
+
+BOOST_AUTO_TEST_CASE(make_query_jointures) {
+    ed::builder b("201303011T1739");
+    b.generate_dummy_basis();
+    b.vj("A")("stop1", 8000,8050)("stop2", 8200,8250);
+    b.vj("A")("stop1", 9000,9050)("stop2", 9200,9250);
+    b.vj("B")("stop3", 9000,9050)("stop4", 9200,9250)("stop2", 9400,9450);
+    b.connection("stop2", "stop3", 10*60);
+    b.finish();
+    b.data->pt_data->index();
+    b.data->pt_data->build_uri();
+
+    const std::vector<std::pair<navitia::type::Type_e, std::string>> queries = {
+        {navitia::type::Type_e::StopArea, "line.uri=A"},
+        {navitia::type::Type_e::Line, "stop_area.uri=stop2"},
+        {navitia::type::Type_e::VehicleJourney, "network.uri=base_network"},
+        {navitia::type::Type_e::VehicleJourney, "stop_point.uri=stop1 and line.uri=A"},
+        {navitia::type::Type_e::StopPoint, "vehicle_journey.uri<>vj:A:1"},
+        {navitia::type::Type_e::Connection, "line.uri=B"},
+        {navitia::type::Type_e::Network, "stop_area.uri=stop4"},
+    };
+    // the result of each query, following the relations object by object
+    std::vector<std::vector<navitia::type::idx_t>> expected;
+    for (const auto& query: queries) {
+        expected.push_back(make_query(query.first, query.second, *(b.data)));
+    }
+    const auto expected_forbidden = make_query(navitia::type::Type_e::StopArea, "", {"B"}, *(b.data));
+
+    // the same results with the precomputed relations
+    b.data->build_jointures();
+    BOOST_REQUIRE(b.data->jointures);
+    for (size_t i = 0; i < queries.size(); ++i) {
+        const auto indexes = make_query(queries[i].first, queries[i].second, *(b.data));
+        BOOST_CHECK_EQUAL_COLLECTIONS(expected[i].begin(), expected[i].end(), indexes.begin(), indexes.end());
+    }
+    const auto forbidden = make_query(navitia::type::Type_e::StopArea, "", {"B"}, *(b.data));
+    BOOST_CHECK_EQUAL_COLLECTIONS(expected_forbidden.begin(), expected_forbidden.end(),
+                                  forbidden.begin(), forbidden.end());
+    // B passes by stop2, stop3 and stop4
+    BOOST_CHECK_EQUAL(forbidden.size(), 1);
+    BOOST_CHECK_EQUAL(make_query(navitia::type::Type_e::StopArea, "line.uri=A", *(b.data)).size(), 2);
+    BOOST_CHECK_EQUAL(make_query(navitia::type::Type_e::Line, "stop_area.uri=stop2", *(b.data)).size(), 2);
+    BOOST_CHECK_EQUAL(make_query(navitia::type::Type_e::VehicleJourney, "network.uri=base_network", *(b.data)).size(), 3);
+
+    // the relations must be built again after a modification of the data
+    auto* sa = new navitia::type::StopArea();
+    sa->uri = "stop5";
+    sa->idx = b.data->pt_data->stop_areas.size();
+    b.data->pt_data->stop_areas.push_back(sa);
+    BOOST_CHECK_THROW(make_query(navitia::type::Type_e::StopArea, "line.uri=A", *(b.data)), navitia::exception);
+    b.data->build_jointures();
+    BOOST_CHECK_EQUAL(make_query(navitia::type::Type_e::StopArea, "line.uri=A", *(b.data)).size(), 2);
+}
+
+/*
+ * the name indexes must follow the idx given by a new sort of the data (like in nav2rt)
+ */
+BOOST_AUTO_TEST_CASE(make_query_by_name_after_sort) {
+    ed::builder b("201303011T1739");
+    b.generate_dummy_basis();
+    b.vj("A")("stop1", 8000,8050)("stop2", 8200,8250);
+    b.vj("B")("stop3", 9000,9050)("stop4", 9200,9250);
+    b.finish();
+    auto& stop_areas = b.data->pt_data->stop_areas;
+    for (auto* sa: stop_areas) {
+        sa->name = "gare " + sa->uri;
+    }
+    // the stop areas are indexed in the reverse order of the sort
+    b.data->pt_data->sort();
+    std::reverse(stop_areas.begin(), stop_areas.end());
+    b.data->pt_data->reindex_stop_areas();
+    b.data->build_uri();
+    const std::string first_uri = stop_areas.front()->uri;
+
+    b.data->pt_data->sort();
+    BOOST_REQUIRE_NE(stop_areas.front()->uri, first_uri);
+    for (const auto* sa: stop_areas) {
+        const auto indexes = make_query(navitia::type::Type_e::StopArea,
+                                        "stop_area.name=\"" + sa->name + "\"", *(b.data));
+        BOOST_REQUIRE_EQUAL(indexes.size(), 1);
+        BOOST_CHECK_EQUAL(stop_areas[indexes[0]]->uri, sa->uri);
+    }
+}
+
 BOOST_AUTO_TEST_CASE(after_filter) {
     ed::builder b("201303011T1739");
     b.generate_dummy_basis();
@@ -82,6 +82,10 @@ int main(int argc, char** argv){
             ("hour,h", po::value<int>(&hour)->default_value(-1),
                     "Begginning hour of a particular journey")
             ("verbose,v", "Verbose debugging output")
+            ("disruption_active", "Compute the journeys on the adapted data")
+            ("without_odt", "Compute the journeys without the zonal odt")
+            ("compare_runtime_flags", "Compute each journey also with the flags of the raptor loop tested at runtime, "
+                                      "and compare the mean computation times")
             ("stop_files", po::value<std::string>(&stop_input_file), "File with list of start and target")
             ("output,o", po::value<std::string>(&output)->default_value("benchmark.csv"),
                      "Output file");
@@ -89,6 +93,10 @@ int main(int argc, char** argv){
     po::store(po::parse_command_line(argc, argv, desc), vm);
     po::notify(vm);
     bool verbose = vm.count("verbose");
+    // each combination of these flags runs its own instance of the raptor loop
+    const bool disruption_active = vm.count("disruption_active");
+    const bool allow_odt = ! vm.count("without_odt");
+    const bool compare_runtime_flags = vm.count("compare_runtime_flags");
 
     if (vm.count("help")) {
         std::cout << "This is used to benchmark journey computation" << std::endl;
@@ -181,8 +189,26 @@ int main(int argc, char** argv){
     Timer t("Calcul avec l'algorithme ");
     //ProfilerStart("bench.prof");
     int nb_reponses = 0;
-    for(auto demand : demands){
+    // the baseline: the same journeys computed with the runtime flags
+    double total_runtime_flags_time = 0;
+    size_t nb_different_results = 0;
+    for(size_t i = 0; i < demands.size(); ++i){
+        const auto& demand = demands[i];
         ++show_progress;
+        auto compute = [&](bool use_static_flags) {
+            router.use_static_flags = use_static_flags;
+            return router.compute(data.pt_data->stop_areas[demand.start], data.pt_data->stop_areas[demand.target],
+                                  demand.hour, demand.date, DateTimeUtils::set(demand.date + 1, demand.hour),
+                                  disruption_active, allow_odt);
+        };
+        // the runtime flags are computed first for half of the journeys, so that the caches favor no one
+        std::vector<Path> runtime_flags_res;
+        auto compute_runtime_flags = [&]() {
+            Timer t_runtime;
+            runtime_flags_res = compute(false);
+            total_runtime_flags_time += t_runtime.ms();
+        };
+        if (compare_runtime_flags && i % 2 == 0) { compute_runtime_flags(); }
         Timer t2;
         if (verbose){
             std::cout << data.pt_data->stop_areas[demand.start]->uri
@@ -193,7 +219,15 @@ int main(int argc, char** argv){
                       << ", " << demand.hour
                       << "\n";
         }
-        auto res = router.compute(data.pt_data->stop_areas[demand.start], data.pt_data->stop_areas[demand.target], demand.hour, demand.date, DateTimeUtils::set(demand.date + 1, demand.hour),false, true);
+        auto res = compute(true);
+        const int computation_time = t2.ms();
+        if (compare_runtime_flags) {
+            if (i % 2 == 1) { compute_runtime_flags(); }
+            if (runtime_flags_res.size() != res.size() || (! res.empty() &&
+                    Result(runtime_flags_res[0]).arrival != Result(res[0]).arrival)) {
+                ++nb_different_results;
+            }
+        }
 
         Path path;
         if(res.size() > 0) {
@@ -202,7 +236,7 @@ int main(int argc, char** argv){
         }
 
         Result result(path);
-        result.time = t2.ms();
+        result.time = computation_time;
         results.push_back(result);
     }
     //ProfilerStop();
@@ -240,4 +274,18 @@ int main(int argc, char** argv){
 
     std::cout << "Number of requests :" << demands.size() << std::endl;
     std::cout << "Number of results with solution" << nb_reponses << std::endl;
+    if (! results.empty()) {
+        double total_time = 0;
+        for (const auto& result: results) { total_time += result.time; }
+        std::cout << "Mean computation time (ms): " << total_time / results.size() << std::endl;
+        if (compare_runtime_flags) {
+            std::cout << "Mean computation time with the runtime flags (ms): "
+                      << total_runtime_flags_time / results.size() << std::endl;
+            if (total_runtime_flags_time > 0) {
+                std::cout << "Gain of the static flags: "
+                          << 100. * (total_runtime_flags_time - total_time) / total_runtime_flags_time << "%" << std::endl;
+            }
+            std::cout << "Number of different results: " << nb_different_results << std::endl;
+        }
+    }
 }
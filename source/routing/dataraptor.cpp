@@ -33,6 +33,9 @@ www.navitia.io
 #include "routing/raptor_utils.h"
 
 #include <boost/range/algorithm_ext.hpp>
+#include <algorithm>
+#include <map>
+#include <set>
 
 namespace navitia { namespace routing {
 
@@ -80,6 +83,87 @@ void dataRAPTOR::JppsFromJp::load(const type::PT_Data &data) {
 }
 
 
+void add_calendar_times(std::vector<dataRAPTOR::CalendarStopTimes::TimeStopTime>& res,
+                        const type::StopTime& st) {
+    const auto* vj = st.vehicle_journey;
+    if (st.is_frequency()) {
+        //if it is a frequency, we got to expand the timetable
+
+        //Note: end can be lower than start, so we have to cycle through the day
+        const auto freq_vj = static_cast<const type::FrequencyVehicleJourney*>(vj);
+        bool is_looping = (freq_vj->start_time > freq_vj->end_time);
+        auto stop_loop = [freq_vj, is_looping](u_int32_t t) {
+            if (! is_looping)
+                return t <= freq_vj->end_time;
+            return t > freq_vj->end_time;
+        };
+        for (auto time = freq_vj->start_time; stop_loop(time); time += freq_vj->headway_secs) {
+            if (is_looping && time > DateTimeUtils::SECONDS_PER_DAY) {
+                time -= DateTimeUtils::SECONDS_PER_DAY;
+            }
+
+            //we need to convert this to local there since we do not have a precise date (just a period)
+            res.push_back({time + freq_vj->utc_to_local_offset, &st});
+        }
+    } else {
+        //same utc tranformation
+        res.push_back({st.departure_time + vj->utc_to_local_offset, &st});
+    }
+}
+
+const std::vector<dataRAPTOR::CalendarStopTimes::TimeStopTime>&
+dataRAPTOR::CalendarStopTimes::get(const std::string& calendar_id, const JppIdx& jpp) const {
+    static const std::vector<TimeStopTime> empty;
+    const auto it_cal = calendar_idx.find(calendar_id);
+    if (it_cal == calendar_idx.end()) {
+        return empty;
+    }
+    const auto& times = times_by_jpp[jpp];
+    const auto it = std::lower_bound(times.begin(), times.end(), it_cal->second,
+                                     [](const Times& t, uint32_t cal) { return t.calendar_idx < cal; });
+    if (it == times.end() || it->calendar_idx != it_cal->second) {
+        return empty;
+    }
+    return it->stop_times;
+}
+
+void dataRAPTOR::CalendarStopTimes::load(const type::PT_Data &data) {
+    calendar_idx.clear();
+    times_by_jpp.assign(data.journey_pattern_points.size());
+    for (const auto* jp: data.journey_patterns) {
+        // for each calendar, the first theoric vj of the meta vjs of the jp associated to it.
+        // We can get only the first theoric one, because BY CONSTRUCTION all theoric vj have the same local times
+        std::set<const type::MetaVehicleJourney*> meta_vjs;
+        jp->for_each_vehicle_journey([&](const type::VehicleJourney& vj) {
+            if (vj.meta_vj) { meta_vjs.insert(vj.meta_vj); }
+            return true;
+        });
+        std::map<uint32_t, std::vector<const type::VehicleJourney*>> vjs_by_calendar;
+        for (const auto* meta_vj: meta_vjs) {
+            if (meta_vj->theoric_vj.empty()) { continue; }
+            for (const auto& cal: meta_vj->associated_calendars) {
+                const auto cal_idx = calendar_idx.insert({cal.first, uint32_t(calendar_idx.size())}).first->second;
+                vjs_by_calendar[cal_idx].push_back(meta_vj->theoric_vj.front());
+            }
+        }
+        if (vjs_by_calendar.empty()) { continue; }
+
+        for (const auto* jpp: jp->journey_pattern_point_list) {
+            auto& times = times_by_jpp[JppIdx(*jpp)];
+            for (const auto& cal_vjs: vjs_by_calendar) {
+                std::vector<TimeStopTime> stop_times;
+                for (const auto* vj: cal_vjs.second) {
+                    add_calendar_times(stop_times, *(vj->stop_time_list.begin() + jpp->order));
+                }
+                std::stable_sort(stop_times.begin(), stop_times.end(),
+                                 [](const TimeStopTime& a, const TimeStopTime& b) { return a.first < b.first; });
+                times.push_back({cal_vjs.first, std::move(stop_times)});
+            }
+            times.shrink_to_fit();
+        }
+    }
+}
+
 void dataRAPTOR::load(const type::PT_Data &data)
 {
     labels_const.init_inf(data.journey_pattern_points.size());
@@ -89,6 +173,7 @@ void dataRAPTOR::load(const type::PT_Data &data)
     jpps_from_sp.load(data);
     jpps_from_jp.load(data);
     next_stop_time_data.load(data);
+    calendar_stop_times.load(data);
 
     jp_validity_patterns.assign(366, boost::dynamic_bitset<>(data.journey_patterns.size()));
     jp_adapted_validity_pattern.assign(366, boost::dynamic_bitset<>(data.journey_patterns.size()));
@@ -37,6 +37,7 @@ www.navitia.io
 
 #include <boost/foreach.hpp>
 #include <boost/dynamic_bitset.hpp>
+#include <unordered_map>
 namespace navitia { namespace routing {
 
 /** Données statiques qui ne sont pas modifiées pendant le calcul */
@@ -102,6 +103,28 @@ struct dataRAPTOR {
 
     NextStopTimeData next_stop_time_data;
 
+    // stop times of the calendars (stop_schedules on a calendar): for a calendar and a jpp,
+    // the {local time in the day, stop time} of the first theoric vj of each meta vj
+    // associated to the calendar, sorted by time
+    struct CalendarStopTimes {
+        typedef std::pair<uint32_t, const type::StopTime*> TimeStopTime;
+
+        // empty if no meta vj of the jpp is associated to the calendar
+        const std::vector<TimeStopTime>& get(const std::string& calendar_id, const JppIdx& jpp) const;
+        void load(const navitia::type::PT_Data &data);
+
+    private:
+        struct Times {
+            uint32_t calendar_idx;
+            std::vector<TimeStopTime> stop_times;
+        };
+        // the calendars are identified by the key of the associated_calendars of the meta vj
+        std::unordered_map<std::string, uint32_t> calendar_idx;
+        // for each jpp, sorted by calendar_idx
+        IdxMap<type::JourneyPatternPoint, std::vector<Times>> times_by_jpp;
+    };
+    CalendarStopTimes calendar_stop_times;
+
     // blank labels, to fast init labels with a memcpy
     Labels labels_const;
     Labels labels_const_reverse;
@@ -117,5 +140,10 @@ struct dataRAPTOR {
     void load(const navitia::type::PT_Data &data);
 };
 
+/// add the {local time in the day, st} of a stop time of a theoric vj, a frequency vj being
+/// expanded on its period
+void add_calendar_times(std::vector<dataRAPTOR::CalendarStopTimes::TimeStopTime>& res,
+                        const type::StopTime& st);
+
 }}
 
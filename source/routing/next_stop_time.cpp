@@ -85,6 +85,29 @@ void NextStopTimeData::TimesStopTimes<Cmp>::init(const type::JourneyPattern* jp,
     }
 }
 
+template<typename Cmp>
+void NextStopTimeData::FrequencyTimes::load(const type::PT_Data &data, const Cmp& cmp) {
+    begins.clear();
+    ends.clear();
+    headways.clear();
+    stop_times.clear();
+    ranges.assign(data.journey_pattern_points.size());
+    for (const auto* jp: data.journey_patterns) {
+        for (const auto* jpp: jp->journey_pattern_point_list) {
+            const uint32_t first = stop_times.size();
+            for (const auto* freq_vj: jp->frequency_vehicle_journey_list) {
+                const auto& st = freq_vj->stop_time_list[jpp->order];
+                if (! cmp.is_valid(st)) { continue; }
+                begins.push_back(DateTimeUtils::hour(freq_vj->start_time + cmp.get_time(st)));
+                ends.push_back(DateTimeUtils::hour(freq_vj->end_time + cmp.get_time(st)));
+                headways.push_back(std::max(freq_vj->headway_secs, uint32_t(1)));
+                stop_times.push_back(&st);
+            }
+            ranges[JppIdx(*jpp)] = {first, uint32_t(stop_times.size())};
+        }
+    }
+}
+
 void NextStopTimeData::load(const type::PT_Data &data) {
     forward.assign(data.journey_pattern_points.size());
     backward.assign(data.journey_pattern_points.size());
@@ -96,6 +119,8 @@ void NextStopTimeData::load(const type::PT_Data &data) {
             backward[jpp_idx].init(jp, jpp);
         }
     }
+    forward_frequency.load(data, Forward());
+    backward_frequency.load(data, Backward());
 }
 
 inline static bool
@@ -109,11 +134,6 @@ is_valid(const nt::StopTime* st,
         st->vehicle_journey->accessible(vehicle_props);
 }
 
-static const type::JourneyPatternPoint*
-get_jpp(JppIdx jpp_idx, const type::Data& data) {
-    return data.pt_data->journey_pattern_points[jpp_idx.val];
-}
-
 /** Which is the first valid stop_time in this range ?
  *  Returns invalid_idx is none is
  */
@@ -144,96 +164,140 @@ next_valid_discrete_pick_up(const dataRAPTOR& dataRaptor,
     return {nullptr, DateTimeUtils::inf};
 }
 
+static const type::FrequencyVehicleJourney& get_freq_vj(const type::StopTime* st) {
+    return *static_cast<const type::FrequencyVehicleJourney*>(st->vehicle_journey);
+}
+
+/** The earliest passage of the frequency vjs of the jpp from dt, in the day of dt
+ *
+ * For the vjs running in the day, the first passage after dt is computed
+ * without branches from the arrays, the validity of the vj is only checked
+ * when it is better than the current one. The vjs running over midnight use
+ * get_next_departure.
+ */
 static std::pair<const type::StopTime*, DateTime>
-next_valid_frequency_pick_up(const type::JourneyPatternPoint* jpp,
-                             const DateTime dt,
-                             const bool adapted,
-                             const type::VehicleProperties &vehicle_props) {
-    // to find the next frequency VJ, for the moment we loop through all frequency VJ of the JP
-    // and for each jp, get compute the datetime on the jpp
+next_frequency_pick_up_in_day(const NextStopTimeData::FrequencyTimes& freq,
+                              const std::pair<uint32_t, uint32_t>& range,
+                              const DateTime dt,
+                              const bool adapted,
+                              const type::VehicleProperties &vehicle_props) {
     std::pair<const type::StopTime*, DateTime> best = {nullptr, DateTimeUtils::inf};
-    for (const auto& freq_vj: jpp->journey_pattern->frequency_vehicle_journey_list) {
-        const auto& st = freq_vj->stop_time_list[jpp->order];
-
-        if (! st.valid_begin(true) || ! freq_vj->accessible(vehicle_props)) {
-            continue;
-        }
-
-        const auto next_dt = get_next_departure(dt, *freq_vj, st, adapted);
-
-        if (next_dt < best.second) {
-            best = {&st, next_dt};
-        }
-    }
-
-    if (best.first == nullptr) {
-        const auto next_date = DateTimeUtils::set(DateTimeUtils::date(dt) + 1, 0);
-        for (const auto& freq_vj: jpp->journey_pattern->frequency_vehicle_journey_list) {
-            const auto& st = freq_vj->stop_time_list[jpp->order];
-
-            if (! st.valid_begin(true) || ! freq_vj->accessible(vehicle_props)) {
+    const uint32_t hour = DateTimeUtils::hour(dt);
+    const uint32_t date = DateTimeUtils::date(dt);
+    for (uint32_t i = range.first; i < range.second; ++i) {
+        const uint32_t begin = freq.begins[i];
+        const uint32_t end = freq.ends[i];
+        const auto* st = freq.stop_times[i];
+        DateTime next_dt;
+        if (begin <= end) {
+            // first passage at or after hour, none after the last one
+            const uint32_t headway = freq.headways[i];
+            const uint32_t nb_headways = (std::max(hour, begin) - begin + headway - 1) / headway;
+            next_dt = hour > end ? DateTimeUtils::inf : DateTimeUtils::set(date, begin + nb_headways * headway);
+            if (next_dt >= best.second) { continue; }
+            const auto& freq_vj = get_freq_vj(st);
+            if (! freq_vj.is_valid(date, adapted) || ! freq_vj.accessible(vehicle_props)) {
                 continue;
             }
-
-            const auto next_dt = get_next_departure(next_date, *freq_vj, st, adapted);
-
-            if (next_dt < best.second) {
-                best = {&st, next_dt};
-            }
+        } else {
+            const auto& freq_vj = get_freq_vj(st);
+            if (! freq_vj.accessible(vehicle_props)) { continue; }
+            next_dt = get_next_departure(dt, freq_vj, *st, adapted);
+            if (next_dt >= best.second) { continue; }
         }
+        best = {st, next_dt};
     }
     return best;
 }
 
 static std::pair<const type::StopTime*, DateTime>
-previous_valid_frequency_drop_off(const type::JourneyPatternPoint* jpp,
-                                  const DateTime dt,
-                                  const bool adapted,
-                                  const type::VehicleProperties &vehicle_props) {
-    std::pair<const type::StopTime*, DateTime> best = {nullptr, DateTimeUtils::not_valid};
-    for (const auto& freq_vj: jpp->journey_pattern->frequency_vehicle_journey_list) {
-        const auto& st = freq_vj->stop_time_list[jpp->order];
-
-        if (! st.valid_begin(false) || ! freq_vj->accessible(vehicle_props)) {
-            continue;
-        }
-
-        const auto previous_dt = get_previous_arrival(dt, *freq_vj, st, adapted);
-
-        if (previous_dt == DateTimeUtils::not_valid) {
-            continue;
-        }
-        if (best.second == DateTimeUtils::not_valid || previous_dt > best.second) {
-            best = {&st, previous_dt};
-        }
+next_valid_frequency_pick_up(const dataRAPTOR& dataRaptor,
+                             const JppIdx jpp_idx,
+                             const DateTime dt,
+                             const bool adapted,
+                             const type::VehicleProperties &vehicle_props) {
+    const auto& freq = dataRaptor.next_stop_time_data.frequency_forward();
+    const auto range = freq.range(jpp_idx);
+    if (range.first == range.second) {
+        return {nullptr, DateTimeUtils::inf};
     }
+    const auto best = next_frequency_pick_up_in_day(freq, range, dt, adapted, vehicle_props);
+    if (best.first != nullptr) {
+        return best;
+    }
+    const auto next_date = DateTimeUtils::set(DateTimeUtils::date(dt) + 1, 0);
+    return next_frequency_pick_up_in_day(freq, range, next_date, adapted, vehicle_props);
+}
 
-    if (best.first == nullptr) {
-        auto date = DateTimeUtils::date(dt);
-        if (date == 0) {
-            return best;
-        }
-        const auto previous_date = DateTimeUtils::set(date - 1, DateTimeUtils::SECONDS_PER_DAY - 1);
-        for (const auto& freq_vj: jpp->journey_pattern->frequency_vehicle_journey_list) {
-            const auto& st = freq_vj->stop_time_list[jpp->order];
-
-            if (! st.valid_begin(false) || ! freq_vj->accessible(vehicle_props)) {
+/** The tardiest passage of the frequency vjs of the jpp before dt, in the day of dt
+ *
+ * same as next_frequency_pick_up_in_day, backward
+ */
+static std::pair<const type::StopTime*, DateTime>
+previous_frequency_drop_off_in_day(const NextStopTimeData::FrequencyTimes& freq,
+                                   const std::pair<uint32_t, uint32_t>& range,
+                                   const DateTime dt,
+                                   const bool adapted,
+                                   const type::VehicleProperties &vehicle_props) {
+    std::pair<const type::StopTime*, DateTime> best = {nullptr, DateTimeUtils::not_valid};
+    const uint32_t hour = DateTimeUtils::hour(dt);
+    const uint32_t date = DateTimeUtils::date(dt);
+    for (uint32_t i = range.first; i < range.second; ++i) {
+        const uint32_t begin = freq.begins[i];
+        const uint32_t end = freq.ends[i];
+        const auto* st = freq.stop_times[i];
+        DateTime previous_dt;
+        if (begin <= end) {
+            // last passage at or before hour, none before the first one
+            const uint32_t headway = freq.headways[i];
+            const uint32_t nb_headways = (std::max(hour, begin) - begin) / headway;
+            const uint32_t passage = hour >= end ? end : begin + nb_headways * headway;
+            previous_dt = hour < begin ? DateTimeUtils::not_valid : DateTimeUtils::set(date, passage);
+            if (previous_dt == DateTimeUtils::not_valid ||
+                    (best.second != DateTimeUtils::not_valid && previous_dt <= best.second)) {
                 continue;
             }
-
-            const auto previous_dt = get_previous_arrival(previous_date, *freq_vj, st, adapted);
-
-            if (previous_dt == DateTimeUtils::not_valid) {
+            const auto& freq_vj = get_freq_vj(st);
+            if (! freq_vj.is_valid(date, adapted) || ! freq_vj.accessible(vehicle_props)) {
                 continue;
             }
-            if (best.second == DateTimeUtils::not_valid || previous_dt > best.second) {
-                best = {&st, previous_dt};
+        } else {
+            const auto& freq_vj = get_freq_vj(st);
+            if (! freq_vj.accessible(vehicle_props)) { continue; }
+            previous_dt = get_previous_arrival(dt, freq_vj, *st, adapted);
+            if (previous_dt == DateTimeUtils::not_valid ||
+                    (best.second != DateTimeUtils::not_valid && previous_dt <= best.second)) {
+                continue;
             }
         }
+        best = {st, previous_dt};
     }
     return best;
 }
 
+static std::pair<const type::StopTime*, DateTime>
+previous_valid_frequency_drop_off(const dataRAPTOR& dataRaptor,
+                                  const JppIdx jpp_idx,
+                                  const DateTime dt,
+                                  const bool adapted,
+                                  const type::VehicleProperties &vehicle_props) {
+    const auto& freq = dataRaptor.next_stop_time_data.frequency_backward();
+    const auto range = freq.range(jpp_idx);
+    if (range.first == range.second) {
+        return {nullptr, DateTimeUtils::not_valid};
+    }
+    const auto best = previous_frequency_drop_off_in_day(freq, range, dt, adapted, vehicle_props);
+    if (best.first != nullptr) {
+        return best;
+    }
+    auto date = DateTimeUtils::date(dt);
+    if (date == 0) {
+        return best;
+    }
+    const auto previous_date = DateTimeUtils::set(date - 1, DateTimeUtils::SECONDS_PER_DAY - 1);
+    return previous_frequency_drop_off_in_day(freq, range, previous_date, adapted, vehicle_props);
+}
+
 static std::pair<const type::StopTime*, DateTime>
 previous_valid_discrete_drop_off(const dataRAPTOR& dataRaptor,
                                  const JppIdx jpp_idx,
@@ -275,7 +339,7 @@ NextStopTime::earliest_stop_time(const JppIdx jpp_idx,
 
     if (check_freq) {
         const auto first_frequency_st_pair =
-            next_valid_frequency_pick_up(get_jpp(jpp_idx, data), dt, adapted, vehicle_props);
+            next_valid_frequency_pick_up(*data.dataRaptor, jpp_idx, dt, adapted, vehicle_props);
 
         if (first_frequency_st_pair.second < first_discrete_st_pair.second) {
             return first_frequency_st_pair;
@@ -297,7 +361,7 @@ NextStopTime::tardiest_stop_time(const JppIdx jpp_idx,
 
     if (check_freq) {
         const auto first_frequency_st_pair =
-            previous_valid_frequency_drop_off(get_jpp(jpp_idx, data), dt, adapted, vehicle_props);
+            previous_valid_frequency_drop_off(*data.dataRaptor, jpp_idx, dt, adapted, vehicle_props);
 
         // since the default value is DateTimeUtils::not_valid (== DateTimeUtils::max)
         // we need to check first that they are
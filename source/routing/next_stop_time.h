@@ -72,6 +72,32 @@ struct NextStopTimeData {
         return backward[jpp_idx].next_stop_time_range(dt);
     }
 
+    // The frequency vehicle journeys of all the jpps, as flat arrays, to
+    // compute their next passage without going through the vehicle journeys
+    struct FrequencyTimes {
+        // for each frequency vj of a jpp, in the order of the
+        // frequency_vehicle_journey_list of the jp: the hours of the
+        // first and last passage at the jpp and the headway.
+        // begins[i] > ends[i] if the vj runs over midnight
+        std::vector<uint32_t> begins;
+        std::vector<uint32_t> ends;
+        std::vector<uint32_t> headways;
+        std::vector<const type::StopTime*> stop_times;
+
+        // the range of the frequency vjs of a jpp in the arrays
+        inline std::pair<uint32_t, uint32_t> range(const JppIdx jpp_idx) const {
+            return ranges[jpp_idx];
+        }
+        template<typename Cmp> void load(const navitia::type::PT_Data &data, const Cmp& cmp);
+
+    private:
+        IdxMap<type::JourneyPatternPoint, std::pair<uint32_t, uint32_t>> ranges;
+    };
+    // departures of the frequency vjs
+    inline const FrequencyTimes& frequency_forward() const { return forward_frequency; }
+    // arrivals of the frequency vjs
+    inline const FrequencyTimes& frequency_backward() const { return backward_frequency; }
+
 private:
     struct Forward {
         template<typename T> inline bool
@@ -107,6 +133,8 @@ private:
     };
     IdxMap<type::JourneyPatternPoint, TimesStopTimes<Forward>> forward;
     IdxMap<type::JourneyPatternPoint, TimesStopTimes<Backward>> backward;
+    FrequencyTimes forward_frequency;
+    FrequencyTimes backward_frequency;
 };
 
 struct NextStopTime {
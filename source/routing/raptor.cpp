@@ -53,9 +53,9 @@ void RAPTOR::make_queue() {
  * we mark it.
  * If the given vj also has an extension we apply it.
  */
-template<typename Visitor>
-bool RAPTOR::apply_vj_extension(const Visitor& v, const bool global_pruning,
-                                const bool disruption_active, const RoutingState& state) {
+template<typename Visitor, typename DisruptionActive, typename GlobalPruning>
+bool RAPTOR::apply_vj_extension(const Visitor& v, DisruptionActive disruption_active, GlobalPruning global_pruning,
+                                const RoutingState& state) {
     auto& working_labels = labels[count];
     auto workingDt = state.workingDate;
     auto vj = state.vj;
@@ -112,8 +112,8 @@ bool RAPTOR::apply_vj_extension(const Visitor& v, const bool global_pruning,
 }
 
 
-template<typename Visitor>
-bool RAPTOR::foot_path(const Visitor & v) {
+template<typename Visitor, typename ZonalOdt>
+bool RAPTOR::foot_path(const Visitor & v, ZonalOdt zonal_odt) {
     bool result = false;
     auto &working_labels = labels[count];
     for (const auto& elt: best_jpp_by_sp) {
@@ -123,7 +123,9 @@ bool RAPTOR::foot_path(const Visitor & v) {
 
         // Now we apply all the connections
         const DateTime previous = working_labels.dt_pt(best_jpp_idx);
-        const auto best_is_odt = get_jpp(best_jpp_idx)->journey_pattern->odt_properties.is_zonal_odt();
+        // without any valid zonal odt, the jpp is not even read
+        const bool best_is_odt = zonal_odt &&
+            get_jpp(best_jpp_idx)->journey_pattern->odt_properties.is_zonal_odt();
 
         const auto& conns = v.clockwise() ?
             data.dataRaptor->connections.get_forward(sp_idx) :
@@ -158,13 +160,13 @@ bool RAPTOR::foot_path(const Visitor & v) {
 void RAPTOR::clear(const bool clockwise, const DateTime bound) {
     const int queue_value = clockwise ?  std::numeric_limits<int>::max() : -1;
     Q.assign(data.pt_data->journey_patterns.size(), queue_value);
-    if (labels.empty()) {
-        labels.resize(5);
-    }
     const Labels& clean_labels =
         clockwise ? data.dataRaptor->labels_const : data.dataRaptor->labels_const_reverse;
-    for(auto& lbl_list : labels) {
-        lbl_list.clear(clean_labels);
+    // the next rounds are cleaned by raptor_loop only if the computation reaches them
+    if (labels.empty()) {
+        labels.push_back(clean_labels);
+    } else {
+        labels[0].clear(clean_labels);
     }
 
     const size_t journey_pattern_points_size = data.pt_data->journey_pattern_points.size();
@@ -473,6 +475,7 @@ void RAPTOR::set_valid_jp_and_jpp(
             continue;
         }
     }
+    valid_zonal_odt = false;
     if (!allow_odt) {
         for(const type::JourneyPattern* journey_pattern : data.pt_data->journey_patterns) {
             if(journey_pattern->odt_properties.is_zonal_odt()){
@@ -507,6 +510,8 @@ void RAPTOR::set_valid_jp_and_jpp(
             }
             if (allowed_jp.count(journey_pattern) == 0) {
                 valid_journey_patterns.set(journey_pattern->idx, false);
+            } else if (valid_journey_patterns[journey_pattern->idx]) {
+                valid_zonal_odt = true;
             }
         }
     }
@@ -538,21 +543,22 @@ void RAPTOR::set_valid_jp_and_jpp(
     jpps_from_sp.filter_jpps(valid_journey_pattern_points);
 }
 
-template<typename Visitor>
-void RAPTOR::raptor_loop(Visitor visitor, const type::AccessibiliteParams & accessibilite_params, bool disruption_active,
-        bool global_pruning, uint32_t max_transfers) {
+template<typename Visitor, typename DisruptionActive, typename GlobalPruning, typename ZonalOdt>
+void RAPTOR::raptor_loop(Visitor visitor, const type::AccessibiliteParams & accessibilite_params,
+                         DisruptionActive disruption_active, GlobalPruning global_pruning, ZonalOdt zonal_odt,
+                         uint32_t max_transfers) {
     bool end_algorithm = false;
     count = 0; //< Count iteration of raptor algorithm
 
     while(!end_algorithm && count <= max_transfers) {
         ++count;
         end_algorithm = true;
+        const Labels& clean_labels = visitor.clockwise() ?
+            this->data.dataRaptor->labels_const : this->data.dataRaptor->labels_const_reverse;
         if(count == labels.size()) {
-            if(visitor.clockwise()) {
-                this->labels.push_back(this->data.dataRaptor->labels_const);
-            } else {
-                this->labels.push_back(this->data.dataRaptor->labels_const_reverse);
-            }
+            this->labels.push_back(clean_labels);
+        } else {
+            this->labels[count].clear(clean_labels);
         }
         const auto & prec_labels=labels[count -1];
         auto& working_labels = labels[this->count];
@@ -634,19 +640,51 @@ void RAPTOR::raptor_loop(Visitor visitor, const type::AccessibiliteParams & acce
             q_elt.second = visitor.init_queue_item();
         }
         for (auto state : states_stay_in) {
-            end_algorithm &= !apply_vj_extension(visitor, global_pruning, disruption_active, state);
+            end_algorithm &= !apply_vj_extension(visitor, disruption_active, global_pruning, state);
         }
-        end_algorithm &= !this->foot_path(visitor);
+        end_algorithm &= !this->foot_path(visitor, zonal_odt);
     }
 }
 
 
+template<typename Visitor>
+void RAPTOR::dispatch_raptor_loop(Visitor visitor, const type::AccessibiliteParams & accessibilite_params,
+                                  bool disruption_active, bool global_pruning, uint32_t max_transfers) {
+    if (! use_static_flags) {
+        // like before the static flags: every test is done at runtime and the zonal odt are always checked
+        raptor_loop(visitor, accessibilite_params, runtime_flag{disruption_active}, runtime_flag{global_pruning},
+                    runtime_flag{true}, max_transfers);
+        return;
+    }
+
+#define RAPTOR_LOOP(disruption, pruning, odt) \
+    raptor_loop(visitor, accessibilite_params, static_flag<disruption>(), static_flag<pruning>(), \
+                static_flag<odt>(), max_transfers)
+
+    if (disruption_active) {
+        if (global_pruning) {
+            if (valid_zonal_odt) { RAPTOR_LOOP(true, true, true); } else { RAPTOR_LOOP(true, true, false); }
+        } else {
+            if (valid_zonal_odt) { RAPTOR_LOOP(true, false, true); } else { RAPTOR_LOOP(true, false, false); }
+        }
+    } else {
+        if (global_pruning) {
+            if (valid_zonal_odt) { RAPTOR_LOOP(false, true, true); } else { RAPTOR_LOOP(false, true, false); }
+        } else {
+            if (valid_zonal_odt) { RAPTOR_LOOP(false, false, true); } else { RAPTOR_LOOP(false, false, false); }
+        }
+    }
+
+#undef RAPTOR_LOOP
+}
+
+
 void RAPTOR::boucleRAPTOR(const type::AccessibiliteParams & accessibilite_params, bool clockwise, bool disruption_active,
                           bool global_pruning, uint32_t max_transfers){
     if(clockwise) {
-        raptor_loop(raptor_visitor(), accessibilite_params, disruption_active, global_pruning, max_transfers);
+        dispatch_raptor_loop(raptor_visitor(), accessibilite_params, disruption_active, global_pruning, max_transfers);
     } else {
-        raptor_loop(raptor_reverse_visitor(), accessibilite_params, disruption_active, global_pruning, max_transfers);
+        dispatch_raptor_loop(raptor_reverse_visitor(), accessibilite_params, disruption_active, global_pruning, max_transfers);
     }
 }
 
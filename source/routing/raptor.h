@@ -32,6 +32,7 @@ www.navitia.io
 #include <unordered_map>
 #include <queue>
 #include <limits>
+#include <type_traits>
 #include "type/type.h"
 #include "type/data.h"
 #include "type/datetime.h"
@@ -59,6 +60,16 @@ struct RoutingState {
         vj(vj), boarding_jpp_idx(boarding_jpp_idx), l_zone(l_zone), workingDate(workingDate) {}
 };
 
+/// A flag of the raptor loop known at compile time, the code depending on it is compiled out
+template<bool value>
+using static_flag = std::integral_constant<bool, value>;
+
+/// A flag of the raptor loop tested at runtime, only used to measure the gain of the static flags
+struct runtime_flag {
+    bool value;
+    operator bool() const { return value; }
+};
+
 /** Worker Raptor : une instance par thread, les données sont modifiées par le calcul */
 struct RAPTOR
 {
@@ -67,6 +78,8 @@ struct RAPTOR
     NextStopTime next_st;
 
     ///Contient les heures d'arrivées, de départ, ainsi que la façon dont on est arrivé à chaque journey_pattern point à chaque tour
+    /// The rounds are allocated and cleaned when the computation reaches them (see raptor_loop),
+    /// only the rounds up to count are meaningful
     std::vector<Labels> labels;
     ///Contient les meilleures heures d'arrivées, de départ, ainsi que la façon dont on est arrivé à chaque journey_pattern point
     IdxMap<type::JourneyPatternPoint, DateTime> best_labels;
@@ -80,6 +93,10 @@ struct RAPTOR
     ///La journey_pattern est elle valide ?
     boost::dynamic_bitset<> valid_journey_patterns;
     boost::dynamic_bitset<> valid_journey_pattern_points;
+    /// Is there a zonal odt among the valid journey_patterns ? (set by set_valid_jp_and_jpp)
+    bool valid_zonal_odt = true;
+    /// If false, the raptor loop tests its flags at runtime (used by the benchmark as the baseline)
+    bool use_static_flags = true;
     dataRAPTOR::JppsFromSp jpps_from_sp;
     ///L'ordre du premier j: public AbstractRouterourney_pattern point de la journey_pattern
     IdxMap<type::JourneyPattern, int> Q;
@@ -93,9 +110,7 @@ struct RAPTOR
         best_jpp_by_sp(data.pt_data->stop_points.size()),
         valid_journey_patterns(data.pt_data->journey_patterns.size()),
         valid_journey_pattern_points(data.pt_data->journey_pattern_points.size()),
-        Q(data.pt_data->journey_patterns.size()) {
-            labels.assign(10, data.dataRaptor->labels_const);
-    }
+        Q(data.pt_data->journey_patterns.size()) {}
 
 
 
@@ -194,19 +209,28 @@ struct RAPTOR
 
     /// Apply foot pathes to labels
     /// Return true if it improves at least one label, false otherwise
-    template<typename Visitor> bool foot_path(const Visitor & v);
+    /// zonal_odt: can a valid journey pattern be a zonal odt, the checks are compiled out if it is a static false
+    template<typename Visitor, typename ZonalOdt> bool foot_path(const Visitor & v, ZonalOdt zonal_odt);
 
     /// Returns true if we improve at least one label, false otherwise
-    template<typename Visitor>
-    bool apply_vj_extension(const Visitor& v, const bool global_pruning,
-                            const bool disruption_active,
+    template<typename Visitor, typename DisruptionActive, typename GlobalPruning>
+    bool apply_vj_extension(const Visitor& v, DisruptionActive disruption_active, GlobalPruning global_pruning,
                             const RoutingState& state);
 
     void make_queue();
 
     ///Boucle principale
+    /// The flags are static_flag (one instance for each combination, the choice is made once by query
+    /// in dispatch_raptor_loop) or runtime_flag (the baseline of the benchmark)
+    template<typename Visitor, typename DisruptionActive, typename GlobalPruning, typename ZonalOdt>
+    void raptor_loop(Visitor visitor, const type::AccessibiliteParams & accessibilite_params,
+                     DisruptionActive disruption_active, GlobalPruning global_pruning, ZonalOdt zonal_odt,
+                     uint32_t max_transfers=std::numeric_limits<uint32_t>::max());
+
+    /// Calls the raptor_loop instanciated for the flags (or the runtime one if use_static_flags is false)
     template<typename Visitor>
-    void raptor_loop(Visitor visitor, const type::AccessibiliteParams & accessibilite_params, bool disruption_active, bool global_pruning = true, uint32_t max_transfers=std::numeric_limits<uint32_t>::max());
+    void dispatch_raptor_loop(Visitor visitor, const type::AccessibiliteParams & accessibilite_params,
+                              bool disruption_active, bool global_pruning, uint32_t max_transfers);
 
 
     /// Retourne à quel tour on a trouvé la meilleure solution pour ce journey_patternpoint
@@ -2006,3 +2006,67 @@ BOOST_FIXTURE_TEST_CASE(test_get_next_dep_overnight_midnight_case, midnight_freq
 }
 
 
+
+/*
+ * the passages of the frequency vjs are computed from the arrays of NextStopTimeData,
+ * they must be the ones of get_next_departure and get_previous_arrival on each vj
+ */
+BOOST_AUTO_TEST_CASE(freq_compact_same_as_vjs) {
+    ed::builder b("20120614");
+    b.frequency_vj("A", 8*3600, 12*3600, 7*60, "default_network", "11111111")
+            ("stop1", 8*3600)("stop2", 8*3600 + 10*60, 8*3600 + 11*60);
+    b.frequency_vj("A", 6*3600, 9*3600 + 30*60, 13*60, "default_network", "10101010")
+            ("stop1", 6*3600)("stop2", 6*3600 + 10*60, 6*3600 + 11*60);
+    b.frequency_vj("A", 22*3600, 26*3600, 20*60, "default_network", "11011011")
+            ("stop1", 22*3600)("stop2", 22*3600 + 10*60, 22*3600 + 11*60);
+    b.finish();
+    b.data->pt_data->index();
+    b.data->build_uri();
+    b.data->build_raptor();
+    NextStopTime next_st(*b.data);
+
+    auto brute_force_next = [](const type::JourneyPatternPoint* jpp, DateTime dt) {
+        std::pair<const type::StopTime*, DateTime> best = {nullptr, DateTimeUtils::inf};
+        for (const auto& freq_vj: jpp->journey_pattern->frequency_vehicle_journey_list) {
+            const auto& st = freq_vj->stop_time_list[jpp->order];
+            if (! st.valid_begin(true)) { continue; }
+            const auto next_dt = get_next_departure(dt, *freq_vj, st);
+            if (next_dt < best.second) { best = {&st, next_dt}; }
+        }
+        return best;
+    };
+    auto brute_force_previous = [](const type::JourneyPatternPoint* jpp, DateTime dt) {
+        std::pair<const type::StopTime*, DateTime> best = {nullptr, DateTimeUtils::not_valid};
+        for (const auto& freq_vj: jpp->journey_pattern->frequency_vehicle_journey_list) {
+            const auto& st = freq_vj->stop_time_list[jpp->order];
+            if (! st.valid_begin(false)) { continue; }
+            const auto previous_dt = get_previous_arrival(dt, *freq_vj, st);
+            if (previous_dt == DateTimeUtils::not_valid) { continue; }
+            if (best.second == DateTimeUtils::not_valid || previous_dt > best.second) {
+                best = {&st, previous_dt};
+            }
+        }
+        return best;
+    };
+
+    for (const auto* jpp: b.data->pt_data->journey_pattern_points) {
+        for (DateTime dt = DateTimeUtils::set(1, 0); dt < DateTimeUtils::set(5, 0); dt += 97) {
+            auto expected_next = brute_force_next(jpp, dt);
+            if (expected_next.first == nullptr) {
+                expected_next = brute_force_next(jpp, DateTimeUtils::set(DateTimeUtils::date(dt) + 1, 0));
+            }
+            const auto next = next_st.earliest_stop_time(JppIdx(*jpp), dt, false, false);
+            BOOST_CHECK_EQUAL(next.second, expected_next.second);
+            BOOST_CHECK(next.first == expected_next.first);
+
+            auto expected_previous = brute_force_previous(jpp, dt);
+            if (expected_previous.first == nullptr) {
+                expected_previous = brute_force_previous(jpp, DateTimeUtils::set(DateTimeUtils::date(dt) - 1,
+                                                                                 DateTimeUtils::SECONDS_PER_DAY - 1));
+            }
+            const auto previous = next_st.tardiest_stop_time(JppIdx(*jpp), dt, false, false);
+            BOOST_CHECK_EQUAL(previous.second, expected_previous.second);
+            BOOST_CHECK(previous.first == expected_previous.first);
+        }
+    }
+}
@@ -1495,3 +1495,40 @@ BOOST_AUTO_TEST_CASE(forbid_transfer_between_2_odt){
     auto res1 = raptor.compute(d.stop_areas[0], d.stop_areas[4], 7900, 0, DateTimeUtils::inf, false, true);
     BOOST_REQUIRE_EQUAL(res1.size(), 0);
 }
+
+/*
+ * The label rounds are allocated when the computation reaches them,
+ * and the rounds of a previous computation are cleaned before being reused
+ */
+BOOST_AUTO_TEST_CASE(labels_allocated_on_demand) {
+    ed::builder b("20120614");
+    b.vj("A")("stop1", 8000, 8050)("stop2", 8100, 8150)("stop3", 8200, 8250);
+    b.vj("B")("stop4", 8000, 8050)("stop2", 8300, 8350)("stop5", 8400, 8450);
+    b.connection("stop2", "stop2", 120);
+    b.data->pt_data->index();
+    b.finish();
+    b.data->build_raptor();
+    RAPTOR raptor(*(b.data));
+    type::PT_Data & d = *b.data->pt_data;
+    BOOST_CHECK(raptor.labels.empty());
+
+    // without transfer, stop5 cannot be reached, and only the first vj round is allocated
+    auto res = raptor.compute_all({{SpIdx(*b.sps["stop1"]), 0_s}},
+                                  {{SpIdx(*b.sps["stop5"]), 0_s}},
+                                  DateTimeUtils::set(0, 7900), false, true, DateTimeUtils::inf, 0);
+    BOOST_CHECK(res.empty());
+    BOOST_CHECK_LE(raptor.labels.size(), 2u);
+
+    res = raptor.compute(d.stop_areas_map["stop1"], d.stop_areas_map["stop5"], 7900, 0,
+                         DateTimeUtils::inf, false, true);
+    BOOST_REQUIRE_EQUAL(res.size(), 1);
+    BOOST_CHECK_EQUAL(res[0].items.size(), 3);
+    BOOST_CHECK_GE(raptor.labels.size(), 3u);
+
+    // the rounds used by the transfer must not pollute a direct journey
+    res = raptor.compute(d.stop_areas_map["stop1"], d.stop_areas_map["stop3"], 7900, 0,
+                         DateTimeUtils::inf, false, true);
+    BOOST_REQUIRE_EQUAL(res.size(), 1);
+    BOOST_REQUIRE_EQUAL(res[0].items.size(), 1);
+    BOOST_CHECK_EQUAL(res[0].items[0].arrival.time_of_day().total_seconds(), 8200);
+}
@@ -77,8 +77,11 @@ struct mock_kraken {
         }
 
 
+        navitia::ResponseCache response_cache(conf.autocomplete_cache_size());
+        navitia::timetables::DepartureBoardCache departure_board_cache(conf.departure_board_cache_size());
         // Launch only one thread for the tests
-        threads.create_thread(std::bind(&doWork, std::ref(context), std::ref(data_manager), conf));
+        threads.create_thread(std::bind(&doWork, std::ref(context), std::ref(data_manager), conf, &response_cache,
+                                        &departure_board_cache));
 
         // Connect work threads to client threads via a queue
         do {
@@ -0,0 +1,111 @@
+/* Copyright © 2001-2014, Canal TP and/or its affiliates. All rights reserved.
+  
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+ 
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+  
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+   
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+   
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+  
+Stay tuned using
+twitter @navitia 
+IRC #navitia on freenode
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#include "departure_board_cache.h"
+#include "type/pt_data.h"
+
+#include <algorithm>
+
+namespace navitia { namespace timetables {
+
+DepartureBoardCache::StopPointBoard
+make_stop_point_board(const type::StopPoint& stop_point, const DateTime& dt, const DateTime& max_dt,
+                      bool disruption_active, const type::Data& data) {
+    DepartureBoardCache::StopPointBoard board;
+    for (const auto* jpp: stop_point.journey_pattern_point_list) {
+        auto& route_board = board[jpp->journey_pattern->route->idx];
+        const auto* last_jpp = jpp->journey_pattern->journey_pattern_point_list.back();
+        route_board.is_terminus.push_back(last_jpp->stop_point->idx == stop_point.idx);
+        const uint32_t jpp_rank = route_board.is_terminus.size() - 1;
+        for (const auto& dt_st: get_stop_times({jpp->idx}, dt, max_dt, std::numeric_limits<size_t>::max(),
+                                               data, disruption_active)) {
+            route_board.departures.push_back({dt_st.first, dt_st.second, jpp_rank});
+        }
+    }
+    for (auto& route_board: board) {
+        auto& departures = route_board.second.departures;
+        std::stable_sort(departures.begin(), departures.end(),
+                         [](const DepartureBoardCache::Departure& d1, const DepartureBoardCache::Departure& d2) {
+            return d1.dt < d2.dt;
+        });
+    }
+    return board;
+}
+
+DepartureBoardCache::DepartureBoardCache(size_t max_size): max_size(max_size), hits(0), misses(0) {}
+
+void DepartureBoardCache::set_data(const type::Data& new_data) {
+    if (&new_data == data && new_data.data_identifier == data_identifier) { return; }
+    index.clear();
+    entries.clear();
+    data = &new_data;
+    data_identifier = new_data.data_identifier;
+}
+
+std::shared_ptr<const DepartureBoardCache::StopPointBoard>
+DepartureBoardCache::get(const type::StopPoint& stop_point, uint32_t day,
+                         bool disruption_active, const type::Data& data) {
+    const Key key = (Key(stop_point.idx) << 33) | (Key(day) << 1) | Key(disruption_active);
+    if (enabled()) {
+        std::lock_guard<std::mutex> lock(mutex);
+        set_data(data);
+        auto it = index.find(key);
+        if (it != index.end()) {
+            entries.splice(entries.begin(), entries, it->second);
+            ++hits;
+            return it->second->second;
+        }
+    }
+    ++misses;
+    // the board is computed without the lock
+    auto board = std::make_shared<const StopPointBoard>(
+                make_stop_point_board(stop_point, DateTimeUtils::set(day, 0), DateTimeUtils::set(day + 1, 0) - 1,
+                                      disruption_active, data));
+    if (! enabled()) { return board; }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    set_data(data);
+    if (index.find(key) == index.end()) {
+        entries.emplace_front(key, board);
+        index[key] = entries.begin();
+        if (index.size() > max_size) {
+            index.erase(entries.back().first);
+            entries.pop_back();
+        }
+    }
+    return board;
+}
+
+size_t DepartureBoardCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return index.size();
+}
+
+}}
@@ -0,0 +1,107 @@
+/* Copyright © 2001-2014, Canal TP and/or its affiliates. All rights reserved.
+  
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+ 
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+  
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+   
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+   
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+  
+Stay tuned using
+twitter @navitia 
+IRC #navitia on freenode
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#pragma once
+#include "get_stop_times.h"
+
+#include <list>
+#include <unordered_map>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <limits>
+
+namespace navitia { namespace timetables {
+
+/** The departures of the stop points, computed once per day and shared by the workers
+ *
+ * The stop_schedules are polled again and again by the screens of the stations, and
+ * their answers only change with the data. The departures of a stop point for a day
+ * are thus computed on the first request, and the following requests only look for
+ * their time window in them.
+ *
+ * The boards are kept in a LRU, cleared when it is used with another data.
+ */
+class DepartureBoardCache {
+public:
+    struct Departure {
+        DateTime dt;
+        const type::StopTime* st;
+        uint32_t jpp_rank; //< position of the jpp in RouteBoard::is_terminus
+    };
+
+    /// The departures of a route at the stop point, sorted by datetime
+    struct RouteBoard {
+        /// for each jpp of the route at the stop point (in the order of the stop point), is it the terminus
+        std::vector<bool> is_terminus;
+        std::vector<Departure> departures;
+    };
+
+    /// The boards of the routes, by route idx
+    typedef std::map<type::idx_t, RouteBoard> StopPointBoard;
+
+    /// max_size: number of (stop point, day) boards kept, 0 to disable the cache
+    DepartureBoardCache(size_t max_size = 0);
+
+    bool enabled() const { return max_size > 0; }
+
+    /// The departures of the stop point during the day (DateTimeUtils::date), computed if needed
+    std::shared_ptr<const StopPointBoard> get(const type::StopPoint& stop_point, uint32_t day,
+                                              bool disruption_active, const type::Data& data);
+
+    size_t nb_hits() const { return hits; }
+    size_t nb_misses() const { return misses; }
+    size_t size() const;
+
+private:
+    typedef uint64_t Key;
+    typedef std::list<std::pair<Key, std::shared_ptr<const StopPointBoard>>> Entries;
+
+    size_t max_size;
+    mutable std::mutex mutex;
+    const type::Data* data = nullptr;
+    size_t data_identifier = std::numeric_limits<size_t>::max();
+    /// the most recently used are in the front
+    Entries entries;
+    std::unordered_map<Key, Entries::iterator> index;
+    std::atomic<size_t> hits;
+    std::atomic<size_t> misses;
+
+    /// to call with the lock
+    void set_data(const type::Data& data);
+};
+
+/// Compute the departures of the stop point between the two datetimes
+DepartureBoardCache::StopPointBoard
+make_stop_point_board(const type::StopPoint& stop_point, const DateTime& dt, const DateTime& max_dt,
+                      bool disruption_active, const type::Data& data);
+
+}}
@@ -36,6 +36,8 @@ www.navitia.io
 #include "boost/date_time/posix_time/posix_time.hpp"
 #include "utils/paginate.h"
 
+#include <set>
+
 namespace pt = boost::posix_time;
 
 namespace navitia { namespace timetables {
@@ -103,7 +105,7 @@ departure_board(const std::string& request,
                 uint32_t max_date_times,
                 int interface_version,
                 int count, int start_page, const type::Data &data, bool disruption_active,
-                bool show_codes) {
+                bool show_codes, DepartureBoardCache* board_cache) {
 
     RequestHandle handler("DEPARTURE_BOARD", request, forbidden_uris, date,  duration, data, calendar_id);
 
@@ -127,16 +129,13 @@ departure_board(const std::string& request,
     std::map<stop_point_line, vector_dt_st> map_route_stop_point;
     //Mapping route/stop_point
     std::vector<stop_point_line> sps_routes;
+    std::set<stop_point_line> seen_sps_routes;
     for(auto jpp_idx : handler.journey_pattern_points) {
         auto jpp = data.pt_data->journey_pattern_points[jpp_idx];
         auto route_idx  = jpp->journey_pattern->route->idx;
         auto sp_idx = jpp->stop_point->idx;
         stop_point_line key = stop_point_line(sp_idx, route_idx);
-        auto find_predicate = [&](stop_point_line spl) {
-            return spl.first == key.first && spl.second == key.second;
-        };
-        auto it = std::find_if(sps_routes.begin(), sps_routes.end(), find_predicate);
-        if(it == sps_routes.end()){
+        if(seen_sps_routes.insert(key).second){
             sps_routes.push_back(key);
         }
     }
@@ -150,30 +149,63 @@ departure_board(const std::string& request,
     // au meme couple (stop_point, route)
     // On veut en effet afficher les départs regroupés par route
     // (une route étant une vague direction commerciale
+    auto update_status = [&response_status](const type::Route* route, bool is_terminus) {
+        auto it = response_status.find(route->idx);
+        if (is_terminus) {
+            if (it == response_status.end()) {
+                response_status[route->idx] = pbnavitia::ResponseStatus::terminus;
+            } else {
+                response_status[route->idx] = pbnavitia::ResponseStatus::partial_terminus;
+            }
+        } else {
+            if (it != response_status.end() && it->second == pbnavitia::ResponseStatus::terminus) {
+                response_status[route->idx] = pbnavitia::ResponseStatus::partial_terminus;
+            } else {
+                response_status[route->idx] = pbnavitia::ResponseStatus::none;
+            }
+        }
+    };
     for(auto sp_route : sps_routes) {
         std::vector<datetime_stop_time> stop_times;
         const type::StopPoint* stop_point = data.pt_data->stop_points[sp_route.first];
         const type::Route* route = data.pt_data->routes[sp_route.second];
+        if (board_cache && ! calendar_id) {
+            // the departures are taken from the boards of the days of the period
+            std::vector<size_t> nb_by_jpp;
+            for (auto day = DateTimeUtils::date(handler.date_time);
+                 day <= DateTimeUtils::date(handler.max_datetime); ++day) {
+                const auto board = board_cache->get(*stop_point, day, disruption_active, data);
+                const auto route_board = board->find(route->idx);
+                if (route_board == board->end()) { continue; }
+                const auto& departures = route_board->second.departures;
+                if (nb_by_jpp.empty()) {
+                    for (const bool is_terminus: route_board->second.is_terminus) {
+                        update_status(route, is_terminus);
+                    }
+                    nb_by_jpp.resize(route_board->second.is_terminus.size(), 0);
+                }
+                auto it = std::lower_bound(departures.begin(), departures.end(), handler.date_time,
+                                           [](const DepartureBoardCache::Departure& d, const DateTime dt) {
+                    return d.dt < dt;
+                });
+                for (; it != departures.end() && it->dt <= handler.max_datetime; ++it) {
+                    // as get_stop_times, at most max_date_times departures by jpp
+                    if (nb_by_jpp[it->jpp_rank] < max_date_times) {
+                        ++nb_by_jpp[it->jpp_rank];
+                        stop_times.push_back({it->dt, it->st});
+                    }
+                }
+            }
+            map_route_stop_point.insert({sp_route, stop_times});
+            continue;
+        }
         auto jpps = stop_point->journey_pattern_point_list;
         for(auto jpp : jpps) {
             if(jpp->journey_pattern->route != route) {
                 continue;
             }
-            if(stop_point->idx == jpp->journey_pattern->journey_pattern_point_list.back()->stop_point->idx) { // for terminus
-                auto it = response_status.find(route->idx);
-                if (it == response_status.end()) {
-                    response_status[route->idx] = pbnavitia::ResponseStatus::terminus;
-                } else {
-                    response_status[route->idx] = pbnavitia::ResponseStatus::partial_terminus;
-                }
-            } else {
-                auto it = response_status.find(route->idx);
-                if (it != response_status.end() && it->second == pbnavitia::ResponseStatus::terminus) {
-                    response_status[route->idx] = pbnavitia::ResponseStatus::partial_terminus;
-                } else {
-                    response_status[route->idx] = pbnavitia::ResponseStatus::none;
-                }
-            }
+            // for terminus
+            update_status(route, stop_point->idx == jpp->journey_pattern->journey_pattern_point_list.back()->stop_point->idx);
             std::vector<datetime_stop_time> tmp;
             if (! calendar_id) {
                 tmp = get_stop_times({jpp->idx}, handler.date_time,
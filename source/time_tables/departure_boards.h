@@ -32,6 +32,7 @@ www.navitia.io
 #include "type/pb_converter.h"
 #include "routing/routing.h"
 #include "get_stop_times.h"
+#include "departure_board_cache.h"
 
 
 namespace navitia { namespace timetables {
@@ -47,7 +48,8 @@ pbnavitia::Response departure_board(const std::string &filter,
                                     uint32_t depth, uint32_t max_date_times,
                                     int interface_version,
                                     int count, int start_page, const type::Data &data, bool disruption_active,
-                                    bool show_codes=false);
+                                    bool show_codes=false,
+                                    DepartureBoardCache* board_cache=nullptr);
 }
 
 }
@@ -30,7 +30,9 @@ www.navitia.io
 
 #include "get_stop_times.h"
 #include "routing/next_stop_time.h"
+#include "routing/dataraptor.h"
 #include "type/pb_converter.h"
+#include <tuple>
 
 namespace navitia { namespace timetables {
 
@@ -42,42 +44,50 @@ std::vector<datetime_stop_time> get_stop_times(const std::vector<type::idx_t>& j
                                                bool disruption_active,
                                                const type::AccessibiliteParams& accessibilite_params) {
     std::vector<datetime_stop_time> result;
-    auto test_add = true;
     routing::NextStopTime next_st = routing::NextStopTime(data);
 
-    // Next departure for the next stop: we use it not to have twice the same stop_time
-    // We init it with the wanted date time
-    std::map<type::idx_t, DateTime> next_requested_datetime;
-    for(auto jpp_idx : journey_pattern_points){
-        next_requested_datetime[jpp_idx] = dt;
+    // k-way merge of the departures of each jpp: the heap holds the next departure of each jpp,
+    // the earliest is popped and replaced by the following departure of the same jpp.
+    // Ties are broken by the position of the jpp in the list
+    struct next_departure {
+        DateTime dt;
+        size_t rank;
+        const type::StopTime* st;
+        bool operator>(const next_departure& other) const {
+            return std::tie(dt, rank) > std::tie(other.dt, other.rank);
+        }
+    };
+    std::vector<next_departure> heap;
+    heap.reserve(journey_pattern_points.size());
+    auto push_next = [&](const size_t rank, const DateTime from) {
+        const type::JourneyPatternPoint* jpp = data.pt_data->journey_pattern_points[journey_pattern_points[rank]];
+        const auto st = next_st.earliest_stop_time(routing::JppIdx(*jpp), from, disruption_active,
+                                                   accessibilite_params.vehicle_properties);
+        if (st.first != nullptr && st.second <= max_dt) {
+            heap.push_back({st.second, rank, st.first});
+            std::push_heap(heap.begin(), heap.end(), std::greater<next_departure>());
+        }
+    };
+    if (max_departures == 0) {
+        return result;
+    }
+    for (size_t rank = 0; rank < journey_pattern_points.size(); ++rank) {
+        const type::JourneyPatternPoint* jpp = data.pt_data->journey_pattern_points[journey_pattern_points[rank]];
+        if(!jpp->stop_point->accessible(accessibilite_params.properties)) {
+            continue;
+        }
+        push_next(rank, dt);
     }
 
-    while(test_add && result.size() < max_departures) {
-        test_add = false;
-        for(auto jpp_idx : journey_pattern_points) {
-            const type::JourneyPatternPoint* jpp = data.pt_data->journey_pattern_points[jpp_idx];
-            if(!jpp->stop_point->accessible(accessibilite_params.properties)) {
-                continue;
-            }
-            auto st = next_st.earliest_stop_time(routing::JppIdx(*jpp),
-                                                 next_requested_datetime[jpp_idx],
-                                                 disruption_active,
-                                                 accessibilite_params.vehicle_properties);
-
-            if (st.first != nullptr) {
-                DateTime dt_temp = st.second;
-                if (dt_temp <= max_dt) {
-                    result.push_back(std::make_pair(dt_temp, st.first));
-                    test_add = true;
-                    // The next stop time must be at least one second after
-                    next_requested_datetime[jpp_idx] = dt_temp + 1;
-                }
-            }
+    while (! heap.empty() && result.size() < max_departures) {
+        std::pop_heap(heap.begin(), heap.end(), std::greater<next_departure>());
+        const next_departure departure = heap.back();
+        heap.pop_back();
+        result.push_back(std::make_pair(departure.dt, departure.st));
+        if (result.size() < max_departures) {
+            // The next stop time must be at least one second after
+            push_next(departure.rank, departure.dt + 1);
         }
-     }
-    std::sort(result.begin(), result.end(),[](datetime_stop_time dst1, datetime_stop_time dst2) {return dst1.first < dst2.first;});
-    if (result.size() > max_departures) {
-        result.resize(max_departures);
     }
 
     return result;
@@ -97,12 +107,16 @@ std::vector<datetime_stop_time> get_stop_times(const std::vector<type::idx_t>& j
         if(!jpp->stop_point->accessible(accessibilite_params.properties)) {
             continue;
         }
-        auto st = get_all_stop_times(jpp, calendar_id, accessibilite_params.vehicle_properties);
+        // the stop times of the calendar are precomputed for each jpp
+        const auto& st = data.dataRaptor->calendar_stop_times.get(calendar_id, routing::JppIdx(*jpp));
 
         //afterward we filter the datetime not in [dt, max_dt]
         //the difficult part comes from the fact that for calendar dt are max_dt are not really datetime,
         //there are time but max_dt can be the day after like [today 4:00, tomorow 3:00]
-        for (auto& res: st) {
+        for (const auto& res: st) {
+            if (! res.second->vehicle_journey->accessible(accessibilite_params.vehicle_properties)) {
+                continue; //the stop time must be accessible
+            }
             auto time = DateTimeUtils::hour(res.first);
             if (max_time > begining_time) {
                 // we keep the st in [dt, max_dt]
@@ -152,36 +166,14 @@ get_all_stop_times(const type::JourneyPatternPoint* jpp,
         return {};
     }
 
-    std::vector<std::pair<DateTime, const type::StopTime*>> res;
+    std::vector<std::pair<uint32_t, const type::StopTime*>> res;
     for (const auto vj: vjs) {
         //loop through stop times for stop jpp->stop_point
         const auto& st = *(vj->stop_time_list.begin() + jpp->order);
         if (! st.vehicle_journey->accessible(vehicle_properties)) {
             continue; //the stop time must be accessible
         }
-        if (st.is_frequency()) {
-            //if it is a frequency, we got to expand the timetable
-
-            //Note: end can be lower than start, so we have to cycle through the day
-            const auto freq_vj = static_cast<const type::FrequencyVehicleJourney*>(vj);
-            bool is_looping = (freq_vj->start_time > freq_vj->end_time);
-            auto stop_loop = [freq_vj, is_looping](u_int32_t t) {
-                if (! is_looping)
-                    return t <= freq_vj->end_time;
-                return t > freq_vj->end_time;
-            };
-            for (auto time = freq_vj->start_time; stop_loop(time); time += freq_vj->headway_secs) {
-                if (is_looping && time > DateTimeUtils::SECONDS_PER_DAY) {
-                    time -= DateTimeUtils::SECONDS_PER_DAY;
-                }
-
-                //we need to convert this to local there since we do not have a precise date (just a period)
-                res.push_back({time + freq_vj->utc_to_local_offset, &st});
-            }
-        } else {
-            //same utc tranformation
-            res.push_back({st.departure_time + vj->utc_to_local_offset, &st});
-        }
+        routing::add_calendar_times(res, st);
     }
 
     return res;
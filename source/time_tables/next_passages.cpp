@@ -35,12 +35,83 @@ www.navitia.io
 #include "type/datetime.h"
 #include "ptreferential/ptreferential.h"
 #include "utils/paginate.h"
+#include <unordered_map>
 
 
 namespace pt = boost::posix_time;
 
 namespace navitia { namespace timetables {
 
+namespace {
+
+struct vis_next_departures {
+    struct predicate_t {
+        const type::Data &data;
+        predicate_t(const type::Data& data) : data(data){}
+        bool operator()(const type::idx_t jppidx) const {
+            auto jpp = data.pt_data->journey_pattern_points[jppidx];
+            auto last_jpp = jpp->journey_pattern->journey_pattern_point_list.back();
+            return jpp == last_jpp;
+        }
+    };
+    std::string api_str;
+    pbnavitia::API api_pb;
+    predicate_t predicate;
+    vis_next_departures(const type::Data& data) :
+        api_str("NEXT_DEPARTURES"), api_pb(pbnavitia::NEXT_DEPARTURES), predicate(data) {}
+};
+
+struct vis_next_arrivals {
+    struct predicate_t {
+        const type::Data &data;
+        predicate_t(const type::Data& data) : data(data){}
+        bool operator()(const type::idx_t jppidx) const{
+            return data.pt_data->journey_pattern_points[jppidx]->order == 0;
+        }
+    };
+    std::string api_str;
+    pbnavitia::API api_pb;
+    predicate_t predicate;
+    vis_next_arrivals(const type::Data& data) :
+        api_str("NEXT_ARRIVALS"), api_pb(pbnavitia::NEXT_ARRIVALS), predicate(data) {}
+};
+
+}
+
+static void fill_passage(pbnavitia::Passage* passage,
+                         const datetime_stop_time& dt_stop_time,
+                         const type::Data& data, const int depth,
+                         const pt::ptime& now, const pt::time_period& action_period,
+                         const bool show_codes) {
+    auto departure_date = navitia::to_posix_timestamp(dt_stop_time.first, data);
+    auto arrival_date = navitia::to_posix_timestamp(dt_stop_time.first, data);
+    passage->mutable_stop_date_time()->set_departure_date_time(departure_date);
+    passage->mutable_stop_date_time()->set_arrival_date_time(arrival_date);
+    const type::JourneyPatternPoint* jpp = dt_stop_time.second->journey_pattern_point;
+    fill_pb_object(jpp->stop_point, data, passage->mutable_stop_point(),
+            depth, now, action_period);
+    const type::VehicleJourney* vj = dt_stop_time.second->vehicle_journey;
+    const type::JourneyPattern* jp = vj->journey_pattern;
+    const type::Route* route = jp->route;
+    const type::Line* line = route->line;
+    const type::PhysicalMode* physical_mode = jp->physical_mode;
+    auto m_vj = passage->mutable_vehicle_journey();
+    auto m_route = m_vj->mutable_route();
+    auto m_physical_mode = m_vj->mutable_journey_pattern()->mutable_physical_mode();
+    fill_pb_object(vj, data, m_vj, 0, now, action_period, show_codes);
+    fill_pb_object(route, data, m_route, 0, now, action_period, show_codes);
+    fill_pb_object(line, data, m_route->mutable_line(), 0, now, action_period, show_codes);
+    fill_pb_object(physical_mode, data, m_physical_mode, 0, now, action_period);
+}
+
+static void fill_pagination(pbnavitia::Pagination* pagination, size_t total_result,
+                            uint32_t count, uint32_t start_page, size_t items_on_page) {
+    pagination->set_totalresult(total_result);
+    pagination->set_startpage(start_page);
+    pagination->set_itemsperpage(count);
+    pagination->set_itemsonpage(items_on_page);
+}
+
 template<typename Visitor>
 pbnavitia::Response
 next_passages(const std::string &request,
@@ -74,34 +145,97 @@ next_passages(const std::string &request,
             passage = handler.pb_response.add_next_arrivals();
         else
             passage = handler.pb_response.add_next_departures();
-        auto departure_date = navitia::to_posix_timestamp(dt_stop_time.first, data);
-        auto arrival_date = navitia::to_posix_timestamp(dt_stop_time.first, data);
-        passage->mutable_stop_date_time()->set_departure_date_time(departure_date);
-        passage->mutable_stop_date_time()->set_arrival_date_time(arrival_date);
-        const type::JourneyPatternPoint* jpp = dt_stop_time.second->journey_pattern_point;
-        fill_pb_object(jpp->stop_point, data, passage->mutable_stop_point(),
-                depth, now, action_period);
-        const type::VehicleJourney* vj = dt_stop_time.second->vehicle_journey;
-        const type::JourneyPattern* jp = vj->journey_pattern;
-        const type::Route* route = jp->route;
-        const type::Line* line = route->line;
-        const type::PhysicalMode* physical_mode = jp->physical_mode;
-        auto m_vj = passage->mutable_vehicle_journey();
-        auto m_route = m_vj->mutable_route();
-        auto m_physical_mode = m_vj->mutable_journey_pattern()->mutable_physical_mode();
-        fill_pb_object(vj, data, m_vj, 0, now, action_period, show_codes);
-        fill_pb_object(route, data, m_route, 0, now, action_period, show_codes);
-        fill_pb_object(line, data, m_route->mutable_line(), 0, now, action_period, show_codes);
-        fill_pb_object(physical_mode, data, m_physical_mode, 0, now, action_period);
+        fill_passage(passage, dt_stop_time, data, depth, now, action_period, show_codes);
     }
-    auto pagination = handler.pb_response.mutable_pagination();
-    pagination->set_totalresult(total_result);
-    pagination->set_startpage(start_page);
-    pagination->set_itemsperpage(count);
-    pagination->set_itemsonpage(passages_dt_st.size());
+    fill_pagination(handler.pb_response.mutable_pagination(), total_result, count, start_page,
+                    passages_dt_st.size());
     return handler.pb_response;
 }
 
+/*
+ * The passages of each filter, as next_passages would give them.
+ * The jpps of all the filters are merged: the passages of a jpp present in several
+ * filters are computed once, then each filter merges the passages of its jpps.
+ */
+template<typename Visitor>
+pbnavitia::Response
+next_passages_batch(const std::vector<std::string>& requests,
+                    const std::vector<std::string>& forbidden_uris,
+                    const pt::ptime datetime,
+                    uint32_t duration, uint32_t nb_stoptimes, const int depth,
+                    const type::AccessibiliteParams & accessibilite_params,
+                    const type::Data & data, bool disruption_active, Visitor vis, uint32_t count,
+                    uint32_t start_page, const bool show_codes) {
+    pbnavitia::Response response;
+    std::vector<RequestHandle> handlers;
+    handlers.reserve(requests.size());
+    // the passages of each jpp of the filters, a jpp never gives more than nb_stoptimes of them
+    std::unordered_map<type::idx_t, std::vector<datetime_stop_time>> passages_by_jpp;
+    for (const auto& request: requests) {
+        handlers.emplace_back(vis.api_str, request, forbidden_uris, datetime, duration, data,
+                              boost::optional<const std::string>());
+        auto& handler = handlers.back();
+        if(handler.pb_response.has_error()) {
+            continue;
+        }
+        std::remove_if(handler.journey_pattern_points.begin(),
+                       handler.journey_pattern_points.end(), vis.predicate);
+        for (const auto jpp_idx: handler.journey_pattern_points) {
+            passages_by_jpp[jpp_idx];
+        }
+    }
+    // the datetimes only depend on datetime and duration, they are the same for all the filters
+    const auto handler_it = std::find_if(handlers.begin(), handlers.end(),
+                                         [](const RequestHandle& h) { return ! h.pb_response.has_error(); });
+    if (handler_it == handlers.end()) {
+        for (size_t i = 0; i < requests.size(); ++i) {
+            auto* group = response.add_passages_groups();
+            group->set_filter(requests[i]);
+            *group->mutable_error() = handlers[i].pb_response.error();
+        }
+        return response;
+    }
+    for (auto& jpp_passages: passages_by_jpp) {
+        jpp_passages.second = get_stop_times({jpp_passages.first}, handler_it->date_time,
+                                             handler_it->max_datetime, nb_stoptimes, data,
+                                             disruption_active, accessibilite_params);
+    }
+
+    auto now = pt::second_clock::local_time();
+    pt::time_period action_period(navitia::to_posix_time(handler_it->date_time, data),
+                                  navitia::to_posix_time(handler_it->max_datetime, data));
+    for (size_t i = 0; i < requests.size(); ++i) {
+        const auto& handler = handlers[i];
+        auto* group = response.add_passages_groups();
+        group->set_filter(requests[i]);
+        if(handler.pb_response.has_error()) {
+            *group->mutable_error() = handler.pb_response.error();
+            continue;
+        }
+        // the passages of the jpps are sorted, a stable sort on the datetimes keeps,
+        // like get_stop_times, the order of the jpps for the same datetime
+        std::vector<datetime_stop_time> passages_dt_st;
+        for (const auto jpp_idx: handler.journey_pattern_points) {
+            const auto& jpp_passages = passages_by_jpp[jpp_idx];
+            passages_dt_st.insert(passages_dt_st.end(), jpp_passages.begin(), jpp_passages.end());
+        }
+        std::stable_sort(passages_dt_st.begin(), passages_dt_st.end(),
+                         [](const datetime_stop_time& a, const datetime_stop_time& b) {
+                             return a.first < b.first;
+                         });
+        if (passages_dt_st.size() > nb_stoptimes) {
+            passages_dt_st.resize(nb_stoptimes);
+        }
+        size_t total_result = passages_dt_st.size();
+        passages_dt_st = paginate(passages_dt_st, count, start_page);
+        for(const auto& dt_stop_time : passages_dt_st) {
+            fill_passage(group->add_passages(), dt_stop_time, data, depth, now, action_period, show_codes);
+        }
+        fill_pagination(group->mutable_pagination(), total_result, count, start_page, passages_dt_st.size());
+    }
+    return response;
+}
+
 
 pbnavitia::Response next_departures(const std::string &request,
         const std::vector<std::string>& forbidden_uris,
@@ -109,23 +243,6 @@ pbnavitia::Response next_departures(const std::string &request,
         const int depth, const type::AccessibiliteParams & accessibilite_params,
         const type::Data & data, bool disruption_active, uint32_t count, uint32_t start_page,
         const bool show_codes) {
-
-    struct vis_next_departures {
-        struct predicate_t {
-            const type::Data &data;
-            predicate_t(const type::Data& data) : data(data){}
-            bool operator()(const type::idx_t jppidx) const {
-                auto jpp = data.pt_data->journey_pattern_points[jppidx];
-                auto last_jpp = jpp->journey_pattern->journey_pattern_point_list.back();
-                return jpp == last_jpp;
-            }
-        };
-        std::string api_str;
-        pbnavitia::API api_pb;
-        predicate_t predicate;
-        vis_next_departures(const type::Data& data) :
-            api_str("NEXT_DEPARTURES"), api_pb(pbnavitia::NEXT_DEPARTURES), predicate(data) {}
-    };
     vis_next_departures vis(data);
     return next_passages(request, forbidden_uris, datetime, duration, nb_stoptimes, depth,
                          accessibilite_params, data, disruption_active, vis, count, start_page, show_codes);
@@ -138,25 +255,34 @@ pbnavitia::Response next_arrivals(const std::string &request,
         const int depth, const type::AccessibiliteParams & accessibilite_params,
         const type::Data & data, bool disruption_active, uint32_t count, uint32_t start_page,
         const bool show_codes) {
-
-    struct vis_next_arrivals {
-        struct predicate_t {
-            const type::Data &data;
-            predicate_t(const type::Data& data) : data(data){}
-            bool operator()(const type::idx_t jppidx) const{
-                return data.pt_data->journey_pattern_points[jppidx]->order == 0;
-            }
-        };
-        std::string api_str;
-        pbnavitia::API api_pb;
-        predicate_t predicate;
-        vis_next_arrivals(const type::Data& data) :
-            api_str("NEXT_ARRIVALS"), api_pb(pbnavitia::NEXT_ARRIVALS), predicate(data) {}
-    };
     vis_next_arrivals vis(data);
     return next_passages(request, forbidden_uris, datetime, duration, nb_stoptimes, depth,
             accessibilite_params, data, disruption_active, vis,count , start_page, show_codes);
 }
 
 
+pbnavitia::Response next_departures_batch(const std::vector<std::string>& requests,
+        const std::vector<std::string>& forbidden_uris,
+        const pt::ptime datetime, uint32_t duration, uint32_t nb_stoptimes,
+        const int depth, const type::AccessibiliteParams & accessibilite_params,
+        const type::Data & data, bool disruption_active, uint32_t count, uint32_t start_page,
+        const bool show_codes) {
+    vis_next_departures vis(data);
+    return next_passages_batch(requests, forbidden_uris, datetime, duration, nb_stoptimes, depth,
+                               accessibilite_params, data, disruption_active, vis, count, start_page, show_codes);
+}
+
+
+pbnavitia::Response next_arrivals_batch(const std::vector<std::string>& requests,
+        const std::vector<std::string>& forbidden_uris,
+        const pt::ptime datetime, uint32_t duration, uint32_t nb_stoptimes,
+        const int depth, const type::AccessibiliteParams & accessibilite_params,
+        const type::Data & data, bool disruption_active, uint32_t count, uint32_t start_page,
+        const bool show_codes) {
+    vis_next_arrivals vis(data);
+    return next_passages_batch(requests, forbidden_uris, datetime, duration, nb_stoptimes, depth,
+                               accessibilite_params, data, disruption_active, vis, count, start_page, show_codes);
+}
+
+
 } }
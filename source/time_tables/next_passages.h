@@ -46,4 +46,19 @@ pbnavitia::Response next_arrivals(const std::string &request,
         const type::Data & data, bool disruption_active, uint32_t count, uint32_t start_page,
         const bool show_codes);
 
+/// the next departures of each filter, in a passages_group
+pbnavitia::Response next_departures_batch(const std::vector<std::string>& requests,
+        const std::vector<std::string>& forbidden_uris,
+        const boost::posix_time::ptime datetime, uint32_t duration, uint32_t nb_stoptimes,
+        const int depth, const type::AccessibiliteParams & accessibilite_params,
+        const type::Data & data, bool disruption_active, uint32_t count, uint32_t start_page,
+        const bool show_codes);
+/// the next arrivals of each filter, in a passages_group
+pbnavitia::Response next_arrivals_batch(const std::vector<std::string>& requests,
+        const std::vector<std::string>& forbidden_uris,
+        const boost::posix_time::ptime datetime, uint32_t duration, uint32_t nb_stoptimes,
+        const int depth, const type::AccessibiliteParams & accessibilite_params,
+        const type::Data & data, bool disruption_active, uint32_t count, uint32_t start_page,
+        const bool show_codes);
+
 }}
@@ -34,8 +34,10 @@ www.navitia.io
 #include "type/pb_converter.h"
 #include "ptreferential/ptreferential.h"
 #include "utils/paginate.h"
+#include "utils/parallel.h"
 #include "type/datetime.h"
 #include <boost/range/adaptor/reversed.hpp>
+#include <boost/dynamic_bitset.hpp>
 
 namespace pt = boost::posix_time;
 
@@ -174,13 +176,70 @@ make_matrice(const std::vector<std::vector<datetime_stop_time> >& stop_times,
     return result;
 }
 
+static void
+fill_route_schedule(pbnavitia::RouteSchedule* schedule,
+                    const type::Route* route,
+                    const vector_idx& jps,
+                    const DateTime date_time,
+                    const DateTime max_datetime,
+                    uint32_t interface_version,
+                    const uint32_t max_depth,
+                    const pt::ptime& now,
+                    const pt::time_period& action_period,
+                    const type::Data& d,
+                    bool disruption_active,
+                    const bool show_codes) {
+    //On récupère les stop_times
+    auto stop_times = get_all_stop_times(jps, date_time,
+                                         max_datetime, d, disruption_active);
+    // the thermometers are computed once for each list of journey patterns
+    const auto thermometer_ptr = d.thermometers->get(jps, *d.pt_data);
+    const Thermometer& thermometer = *thermometer_ptr;
+    //On génère la matrice
+    auto  matrice = make_matrice(stop_times, thermometer, d);
+    pbnavitia::Table *table = schedule->mutable_table();
+    auto m_pt_display_informations = schedule->mutable_pt_display_informations();
+    fill_pb_object(route, d, m_pt_display_informations, 0, now, action_period);
+
+    std::vector<bool> is_vj_set(stop_times.size(), false);
+    for(unsigned int i=0; i < thermometer.get_thermometer().size(); ++i) {
+        type::idx_t spidx=thermometer.get_thermometer()[i];
+        const type::StopPoint* sp = d.pt_data->stop_points[spidx];
+        //version v1
+        pbnavitia::RouteScheduleRow* row = table->add_rows();
+        fill_pb_object(sp, d, row->mutable_stop_point(), max_depth,
+                       now, action_period, show_codes);
+        for(unsigned int j=0; j<stop_times.size(); ++j) {
+            datetime_stop_time dt_stop_time  = matrice[i][j];
+            if (!is_vj_set[j] && dt_stop_time.second != nullptr) {
+                pbnavitia::Header* header = table->add_headers();
+                pbnavitia::PtDisplayInfo* vj_display_information = header->mutable_pt_display_informations();
+                pbnavitia::addInfoVehicleJourney* add_info_vehicle_journey = header->mutable_add_info_vehicle_journey();
+                auto vj = dt_stop_time.second->vehicle_journey;
+                fill_pb_object(vj, d, vj_display_information, 0, now, action_period);
+                fill_pb_object(vj, d, {}, add_info_vehicle_journey, 0, now, action_period);
+                is_vj_set[j] = true;
+            }
+            if(interface_version == 1) {
+                auto pb_dt = row->add_date_times();
+                fill_pb_object(dt_stop_time.second, d, pb_dt, max_depth,
+                               now, action_period, dt_stop_time.first);
+            } else if(interface_version == 0) {
+                row->add_stop_times(navitia::iso_string(dt_stop_time.first, d));
+            }
+        }
+    }
+    fill_pb_object(route->shape, schedule->mutable_geojson());
+}
+
 pbnavitia::Response
 route_schedule(const std::string& filter,
                const std::vector<std::string>& forbidden_uris,
                const pt::ptime datetime,
                uint32_t duration, uint32_t interface_version,
                const uint32_t max_depth, int count, int start_page,
-               const type::Data &d, bool disruption_active, const bool show_codes) {
+               const type::Data &d, bool disruption_active, const bool show_codes,
+               size_t nb_threads) {
     RequestHandle handler("ROUTE_SCHEDULE", filter, forbidden_uris, datetime, duration, d, {});
 
     if(handler.pb_response.has_error()) {
@@ -190,62 +249,45 @@ route_schedule(const std::string& filter,
     auto pt_datetime = to_posix_time(handler.date_time, d);
     auto pt_max_datetime = to_posix_time(handler.max_datetime, d);
     pt::time_period action_period(pt_datetime, pt_max_datetime);
-    Thermometer thermometer;
     auto routes_idx = ptref::make_query(type::Type_e::Route, filter, forbidden_uris, d);
     size_t total_result = routes_idx.size();
     routes_idx = paginate(routes_idx, count, start_page);
-    for(type::idx_t route_idx : routes_idx) {
-        auto route = d.pt_data->routes[route_idx];
-        auto jps =  ptref::make_query(type::Type_e::JourneyPattern, filter+" and route.uri="+route->uri, forbidden_uris, d);
-        //On récupère les stop_times
-        auto stop_times = get_all_stop_times(jps, handler.date_time,
-                                             handler.max_datetime, d, disruption_active);
-        std::vector<vector_idx> stop_points;
-        for(auto jp_idx : jps) {
-            auto jp = d.pt_data->journey_patterns[jp_idx];
-            stop_points.push_back(vector_idx());
-            for(auto jpp : jp->journey_pattern_point_list) {
-                stop_points.back().push_back(jpp->stop_point->idx);
-            }
-        }
-        thermometer.generate_thermometer(stop_points);
-        //On génère la matrice
-        auto  matrice = make_matrice(stop_times, thermometer, d);
-        auto schedule = handler.pb_response.add_route_schedules();
-        pbnavitia::Table *table = schedule->mutable_table();
-        auto m_pt_display_informations = schedule->mutable_pt_display_informations();
-        fill_pb_object(route, d, m_pt_display_informations, 0, now, action_period);
 
-        std::vector<bool> is_vj_set(stop_times.size(), false);
-        for(unsigned int i=0; i < thermometer.get_thermometer().size(); ++i) {
-            type::idx_t spidx=thermometer.get_thermometer()[i];
-            const type::StopPoint* sp = d.pt_data->stop_points[spidx];
-            //version v1
-            pbnavitia::RouteScheduleRow* row = table->add_rows();
-            fill_pb_object(sp, d, row->mutable_stop_point(), max_depth,
-                           now, action_period, show_codes);
-            for(unsigned int j=0; j<stop_times.size(); ++j) {
-                datetime_stop_time dt_stop_time  = matrice[i][j];
-                if (!is_vj_set[j] && dt_stop_time.second != nullptr) {
-                    pbnavitia::Header* header = table->add_headers();
-                    pbnavitia::PtDisplayInfo* vj_display_information = header->mutable_pt_display_informations();
-                    pbnavitia::addInfoVehicleJourney* add_info_vehicle_journey = header->mutable_add_info_vehicle_journey();
-                    auto vj = dt_stop_time.second->vehicle_journey;
-                    fill_pb_object(vj, d, vj_display_information, 0, now, action_period);
-                    fill_pb_object(vj, d, {}, add_info_vehicle_journey, 0, now, action_period);
-                    is_vj_set[j] = true;
-                }
-                if(interface_version == 1) {
-                    auto pb_dt = row->add_date_times();
-                    fill_pb_object(dt_stop_time.second, d, pb_dt, max_depth,
-                                   now, action_period, dt_stop_time.first);
-                } else if(interface_version == 0) {
-                    row->add_stop_times(navitia::iso_string(dt_stop_time.first, d));
+    // the journey patterns of the filter are computed once, those of each route
+    // are then taken from its journey_pattern_list
+    std::vector<vector_idx> routes_jps(routes_idx.size());
+    if (! routes_idx.empty()) {
+        boost::dynamic_bitset<> filtered_jps(d.pt_data->journey_patterns.size());
+        for (auto jp_idx : ptref::make_query(type::Type_e::JourneyPattern, filter, forbidden_uris, d)) {
+            filtered_jps.set(jp_idx);
+        }
+        for (size_t i = 0; i < routes_idx.size(); ++i) {
+            auto& jps = routes_jps[i];
+            for (const auto* jp : d.pt_data->routes[routes_idx[i]]->journey_pattern_list) {
+                if (filtered_jps.test(jp->idx)) {
+                    jps.push_back(jp->idx);
                 }
             }
+            // like the query of the journey patterns of the route would do
+            if (jps.empty()) {
+                throw ptref::ptref_error("Filters: Unable to find object");
+            }
+            std::sort(jps.begin(), jps.end());
+            jps.erase(std::unique(jps.begin(), jps.end()), jps.end());
         }
-        fill_pb_object(route->shape, schedule->mutable_geojson());
     }
+
+    // the routes are independent, their schedules are built in parallel
+    std::vector<pbnavitia::RouteSchedule> schedules(routes_idx.size());
+    for_each_in_threads(routes_idx.size(), nb_threads, [&](size_t i) {
+        const type::Route* route = d.pt_data->routes[routes_idx[i]];
+        fill_route_schedule(&schedules[i], route, routes_jps[i], handler.date_time, handler.max_datetime,
+                            interface_version, max_depth, now, action_period, d, disruption_active, show_codes);
+    });
+    for (auto& schedule : schedules) {
+        handler.pb_response.add_route_schedules()->Swap(&schedule);
+    }
+
     auto pagination = handler.pb_response.mutable_pagination();
     pagination->set_totalresult(total_result);
     pagination->set_startpage(start_page);
@@ -43,6 +43,6 @@ pbnavitia::Response route_schedule(const std::string & line_externalcode,
         const std::vector<std::string>& forbidden_uris,
         const boost::posix_time::ptime datetime, uint32_t duration, uint32_t interface_version,
         const uint32_t max_depth, int count, int start_page, const type::Data &d, bool disruption_active,
-        const bool show_codes);
+        const bool show_codes, size_t nb_threads = 1);
 
 }}
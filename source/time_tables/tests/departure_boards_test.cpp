@@ -127,6 +127,74 @@ BOOST_AUTO_TEST_CASE(partial_terminus_test1) {
 }
 
 
+/*
+ * The stop schedules computed with the cache of the daily departures are the same as without it
+ *
+ * line A: stop1 -> stop2 -> stop3 every hour, and one vj stop1 -> stop2 only
+ * line B: stop1 -> stop4 with a departure after midnight
+ */
+BOOST_AUTO_TEST_CASE(departure_board_cache_test) {
+    ed::builder b("20120614");
+    for (int h = 6; h < 23; ++h) {
+        b.vj("A")("stop1", h * 3600, h * 3600 + 60)("stop2", h * 3600 + 600, h * 3600 + 660)("stop3", h * 3600 + 1200, h * 3600 + 1200);
+    }
+    b.vj("A", "11111111", "", true, "vj_short", "", "jp_short")("stop1", 12 * 3600 + 1800, 12 * 3600 + 1800)("stop2", 12 * 3600 + 2400, 12 * 3600 + 2400);
+    b.vj("B")("stop1", 23 * 3600 + 1800, 23 * 3600 + 1800)("stop4", 24 * 3600 + 900, 24 * 3600 + 900);
+    b.vj("B")("stop1", 24 * 3600 + 1200, 24 * 3600 + 1200)("stop4", 25 * 3600, 25 * 3600);
+    b.finish();
+    b.data->pt_data->index();
+    b.data->build_raptor();
+    b.data->meta->production_date = boost::gregorian::date_period(date("20120613"), date("20120630"));
+
+    DepartureBoardCache cache(100);
+    struct query { std::string filter; std::string datetime; uint32_t duration; uint32_t max_date_times; };
+    const std::vector<query> queries = {
+        {"stop_point.uri=stop1", "20120615T094500", 86400, std::numeric_limits<int>::max()},
+        {"stop_point.uri=stop1", "20120615T094500", 86400, 3},
+        {"stop_point.uri=stop1", "20120615T230000", 7200, std::numeric_limits<int>::max()},
+        {"stop_point.uri=stop2", "20120615T120000", 3600, std::numeric_limits<int>::max()},
+        {"stop_point.uri=stop2", "20120615T120000", 3 * 86400, 5},
+        {"stop_point.uri=stop3", "20120615T094500", 86400, std::numeric_limits<int>::max()},
+        {"line.uri=B", "20120615T000000", 86400, std::numeric_limits<int>::max()},
+    };
+    for (const auto& q: queries) {
+        const auto expected = departure_board(q.filter, {}, {}, d(q.datetime), q.duration, 0, q.max_date_times,
+                                              1, 10, 0, *(b.data), false);
+        // the second time, the departures come from the cache
+        for (int i = 0; i < 2; ++i) {
+            const auto resp = departure_board(q.filter, {}, {}, d(q.datetime), q.duration, 0, q.max_date_times,
+                                              1, 10, 0, *(b.data), false, false, &cache);
+            BOOST_REQUIRE_EQUAL(resp.stop_schedules_size(), expected.stop_schedules_size());
+            for (int s = 0; s < resp.stop_schedules_size(); ++s) {
+                const auto& schedule = resp.stop_schedules(s);
+                const auto& expected_schedule = expected.stop_schedules(s);
+                BOOST_CHECK_EQUAL(schedule.route().uri(), expected_schedule.route().uri());
+                BOOST_CHECK_EQUAL(schedule.response_status(), expected_schedule.response_status());
+                BOOST_REQUIRE_EQUAL(schedule.date_times_size(), expected_schedule.date_times_size());
+                for (int t = 0; t < schedule.date_times_size(); ++t) {
+                    BOOST_CHECK_EQUAL(schedule.date_times(t).date(), expected_schedule.date_times(t).date());
+                    BOOST_CHECK_EQUAL(schedule.date_times(t).time(), expected_schedule.date_times(t).time());
+                }
+            }
+        }
+    }
+    BOOST_CHECK(cache.nb_hits() > 0);
+    BOOST_CHECK(cache.size() > 0);
+
+    // another data clears the cache
+    ed::builder other("20120614");
+    other.vj("C")("stop1", 36000, 36000)("stop2", 37000, 37000);
+    other.finish();
+    other.data->pt_data->index();
+    other.data->build_raptor();
+    other.data->meta->production_date = boost::gregorian::date_period(date("20120613"), date("20120630"));
+    const auto resp = departure_board("stop_point.uri=stop1", {}, {}, d("20120615T094500"), 3600, 0,
+                                      std::numeric_limits<int>::max(), 1, 10, 0, *(other.data), false, false, &cache);
+    BOOST_REQUIRE_EQUAL(resp.stop_schedules_size(), 1);
+    BOOST_CHECK_EQUAL(resp.stop_schedules(0).date_times_size(), 1);
+    BOOST_CHECK_EQUAL(cache.size(), 1);
+}
+
 BOOST_FIXTURE_TEST_CASE(test_data_set, calendar_fixture) {
     //simple test on the data set creation
 
@@ -33,6 +33,7 @@ www.navitia.io
 #include <boost/test/unit_test.hpp>
 #include "time_tables/get_stop_times.h"
 #include "ed/build_helper.h"
+#include "routing/dataraptor.h"
 
 using namespace navitia::timetables;
 using namespace navitia;
@@ -52,6 +53,53 @@ BOOST_AUTO_TEST_CASE(test1){
 
 }
 
+/**
+ * the departures of several jpp are merged in time order and cut at max_departures and max_dt
+ *
+ * line A leaves stop1 every 1000s from 8000, line B every 1500s from 8200, line C once at 20000
+ */
+BOOST_AUTO_TEST_CASE(departures_of_many_jpps_merged) {
+    ed::builder b("20120614");
+    for (int i = 0; i < 5; ++i) {
+        b.vj("A")("stop1", 8000 + i * 1000, 8000 + i * 1000)("stop2", 9000 + i * 1000, 9000 + i * 1000);
+    }
+    for (int i = 0; i < 4; ++i) {
+        b.vj("B")("stop1", 8200 + i * 1500, 8200 + i * 1500)("stop3", 9000 + i * 1500, 9000 + i * 1500);
+    }
+    b.vj("C")("stop1", 20000, 20000)("stop4", 21000, 21000);
+    b.finish();
+    b.data->pt_data->index();
+    b.data->build_raptor();
+
+    std::vector<navitia::type::idx_t> jpps;
+    for (auto jpp : b.data->pt_data->journey_pattern_points) {
+        if (jpp->stop_point->uri == "stop1") { jpps.push_back(jpp->idx); }
+    }
+    BOOST_REQUIRE_EQUAL(jpps.size(), 3);
+
+    auto result = get_stop_times(jpps, DateTimeUtils::set(0, 0), DateTimeUtils::inf, 100, *b.data, false);
+    BOOST_REQUIRE_EQUAL(result.size(), 10);
+    for (size_t i = 1; i < result.size(); ++i) {
+        BOOST_CHECK(result[i - 1].first <= result[i].first);
+    }
+    BOOST_CHECK_EQUAL(result.back().first, DateTimeUtils::set(0, 20000));
+
+    // only the first departures are computed
+    result = get_stop_times(jpps, DateTimeUtils::set(0, 0), DateTimeUtils::inf, 4, *b.data, false);
+    BOOST_REQUIRE_EQUAL(result.size(), 4);
+    std::vector<DateTime> expected = {DateTimeUtils::set(0, 8000), DateTimeUtils::set(0, 8200),
+                                      DateTimeUtils::set(0, 9000), DateTimeUtils::set(0, 9700)};
+    for (size_t i = 0; i < expected.size(); ++i) {
+        BOOST_CHECK_EQUAL(result[i].first, expected[i]);
+    }
+
+    // the departures after max_dt are not kept
+    result = get_stop_times(jpps, DateTimeUtils::set(0, 9000), DateTimeUtils::set(0, 11000), 100, *b.data, false);
+    BOOST_REQUIRE_EQUAL(result.size(), 4);
+    BOOST_CHECK_EQUAL(result.front().first, DateTimeUtils::set(0, 9000));
+    BOOST_CHECK_EQUAL(result.back().first, DateTimeUtils::set(0, 11000));
+}
+
 /**
  * Test get_all_stop_times for one calendar
  *
@@ -332,3 +380,81 @@ BOOST_AUTO_TEST_CASE(test_frequency_over_midnight_for_calendar) {
     BOOST_REQUIRE_EQUAL(res.size(), (90001 - 70000) / headway_sec + 1 );
 
 }
+
+/**
+ * Test the stop times of the calendars precomputed for each jpp
+ *
+ * vj1 and vj2 are associated to cal1, vj2 and vj3 to cal2
+ *
+ * ==========     =====
+ * stop point     sp1
+ * === ========== =====
+ * vj1 departure  8000
+ * === ========== =====
+ * vj2 departure  8100
+ * === ========== =====
+ * vj3 departure  9000
+ * === ========== =====
+ *
+ */
+BOOST_AUTO_TEST_CASE(test_calendar_stop_times_index) {
+    ed::builder b("20120614");
+    std::string spa1 = "stop1";
+    b.vj("A", "1010", "", true, "vj3")(spa1, 9000, 9000)("useless_stop", 10000, 10000);
+    b.vj("A", "1010", "", true, "vj2")(spa1, 8100, 8100)("useless_stop", 10000, 10000);
+    b.vj("A", "1010", "", true, "vj1")(spa1, 8000, 8000)("useless_stop", 10000, 10000);
+
+    auto cal1(new type::Calendar(b.data->meta->production_date.begin()));
+    cal1->uri="cal1";
+    auto cal2(new type::Calendar(b.data->meta->production_date.begin()));
+    cal2->uri="cal2";
+
+    b.finish();
+
+    auto associate = [&](const std::string& vj_name, const type::Calendar* cal) {
+        auto associated_cal = new type::AssociatedCalendar();
+        associated_cal->calendar = cal;
+        b.data->pt_data->meta_vj[vj_name]->associated_calendars.insert({cal->uri, associated_cal});
+    };
+    associate("vj1", cal1);
+    associate("vj2", cal1);
+    associate("vj2", cal2);
+    associate("vj3", cal2);
+
+    b.data->pt_data->index();
+    b.data->build_uri();
+    b.data->build_raptor();
+
+    auto jpp1 = b.data->pt_data->stop_areas_map[spa1]
+                ->stop_point_list.front()
+                ->journey_pattern_point_list.front();
+    const auto& calendar_stop_times = b.data->dataRaptor->calendar_stop_times;
+
+    auto get_times = [&](const std::string& calendar) {
+        std::vector<uint32_t> res;
+        for (const auto& time_st: calendar_stop_times.get(calendar, routing::JppIdx(*jpp1))) {
+            BOOST_CHECK_EQUAL(time_st.first, time_st.second->departure_time);
+            res.push_back(time_st.first);
+        }
+        return res;
+    };
+    //the stop times are sorted
+    const auto cal1_times = get_times("cal1");
+    const std::vector<uint32_t> expected_cal1 = {8000, 8100};
+    BOOST_CHECK_EQUAL_COLLECTIONS(cal1_times.begin(), cal1_times.end(), expected_cal1.begin(), expected_cal1.end());
+    const auto cal2_times = get_times("cal2");
+    const std::vector<uint32_t> expected_cal2 = {8100, 9000};
+    BOOST_CHECK_EQUAL_COLLECTIONS(cal2_times.begin(), cal2_times.end(), expected_cal2.begin(), expected_cal2.end());
+    BOOST_CHECK(get_times("bob_the_calendar").empty());
+
+    //same stop times as get_all_stop_times
+    auto all_st = get_all_stop_times(jpp1, "cal2");
+    using p = std::pair<uint32_t, const type::StopTime*>;
+    std::sort(all_st.begin(), all_st.end(), [](const p& p1, const p& p2) { return p1.first < p2.first; });
+    const auto& indexed_st = calendar_stop_times.get("cal2", routing::JppIdx(*jpp1));
+    BOOST_CHECK(all_st == indexed_st);
+
+    //the time window is applied on the precomputed stop times
+    BOOST_CHECK_EQUAL(get_stop_times({jpp1->idx}, 8050, 8500, *b.data, "cal1").size(), 1);
+    BOOST_CHECK_EQUAL(get_stop_times({jpp1->idx}, 0, 86399, *b.data, "cal2").size(), 2);
+}
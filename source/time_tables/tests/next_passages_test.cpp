@@ -0,0 +1,86 @@
+/* Copyright © 2001-2014, Canal TP and/or its affiliates. All rights reserved.
+  
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+ 
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+  
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+   
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+   
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+  
+Stay tuned using
+twitter @navitia 
+IRC #navitia on freenode
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE test_next_passages
+#include <boost/test/unit_test.hpp>
+#include "ed/build_helper.h"
+#include "type/type.h"
+#include "time_tables/next_passages.h"
+
+static boost::posix_time::ptime d(std::string str) {
+    return boost::posix_time::from_iso_string(str);
+}
+
+/*
+ * each group of a batch must have the same passages as the request of its filter alone,
+ * even when the filters share some jpps
+ */
+BOOST_AUTO_TEST_CASE(next_departures_batch_test) {
+    ed::builder b("20120614");
+    b.vj("A")("stop1", 8*3600)("stop2", 8*3600 + 10*60)("stop3", 8*3600 + 20*60);
+    b.vj("A")("stop1", 9*3600)("stop2", 9*3600 + 10*60)("stop3", 9*3600 + 20*60);
+    b.vj("B")("stop2", 8*3600 + 10*60)("stop4", 8*3600 + 30*60);
+    b.vj("B")("stop2", 8*3600 + 40*60)("stop4", 9*3600);
+    b.finish();
+    b.data->pt_data->index();
+    b.data->build_raptor();
+    b.data->build_uri();
+    b.data->build_jointures();
+
+    const std::vector<std::string> filters = {"stop_area.uri=stop2", "stop_point.uri=stop1",
+                                              "line.uri=A", "stop_area.uri=bob"};
+    const auto datetime = d("20120615T070000");
+    const size_t nb_stoptimes = 3;
+    const auto resp = navitia::timetables::next_departures_batch(filters, {}, datetime, 86400, nb_stoptimes, 1,
+                                                                 navitia::type::AccessibiliteParams(),
+                                                                 *b.data, false, 10, 0, false);
+    BOOST_REQUIRE_EQUAL(resp.passages_groups_size(), filters.size());
+    for (size_t i = 0; i < filters.size(); ++i) {
+        const auto& group = resp.passages_groups(i);
+        BOOST_CHECK_EQUAL(group.filter(), filters[i]);
+        const auto single = navitia::timetables::next_departures(filters[i], {}, datetime, 86400, nb_stoptimes, 1,
+                                                                navitia::type::AccessibiliteParams(),
+                                                                *b.data, false, 10, 0, false);
+        BOOST_REQUIRE_EQUAL(group.has_error(), single.has_error());
+        if (single.has_error()) {
+            BOOST_CHECK_EQUAL(group.error().id(), single.error().id());
+            continue;
+        }
+        BOOST_REQUIRE_EQUAL(group.passages_size(), single.next_departures_size());
+        for (int j = 0; j < group.passages_size(); ++j) {
+            BOOST_CHECK_EQUAL(group.passages(j).SerializeAsString(), single.next_departures(j).SerializeAsString());
+        }
+        BOOST_CHECK_EQUAL(group.pagination().totalresult(), single.pagination().totalresult());
+    }
+    // the 2 B and the 2 A leaving stop2, limited to nb_stoptimes
+    BOOST_CHECK_EQUAL(resp.passages_groups(0).passages_size(), nb_stoptimes);
+    BOOST_CHECK(resp.passages_groups(3).has_error());
+}
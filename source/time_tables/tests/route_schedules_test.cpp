@@ -35,6 +35,7 @@ www.navitia.io
 #include "type/type.h"
 #include "tests/utils_test.h"
 #include "time_tables/route_schedules.h"
+#include "ptreferential/ptreferential.h"
 //for more concice test
 static pt::ptime d(std::string str) {
     return boost::posix_time::from_iso_string(str);
@@ -96,3 +97,71 @@ BOOST_AUTO_TEST_CASE(test1) {
 }
 
 
+
+/*
+ * the journey patterns of each route are those of the filter: the JP of the line A
+ * that does not stop at stopB is not in its schedule.
+ * The routes are computed in parallel, the response must not depend on the number of threads
+ */
+BOOST_AUTO_TEST_CASE(routes_schedules_in_parallel) {
+    ed::builder b("20120614");
+    b.vj("A", "1111111", "", true, "A1", "A1", "JPA1")("stopC", 8*3600 + 5*60)("stopD", 9*3600 + 30*60);
+    b.vj("A", "1111111", "", true, "A2", "A2", "JPA2")("stopA", 8*3600)("stopB", 8*3600 + 10*60);
+    b.vj("B", "1111111", "", true, "B1", "B1", "JPB1")("stopB", 9*3600)("stopD", 9*3600 + 10*60);
+    b.vj("C", "1111111", "", true, "C1", "C1", "JPC1")("stopA", 10*3600)("stopB", 10*3600 + 10*60);
+    b.vj("C", "1111111", "", true, "C2", "C2", "JPC1")("stopA", 11*3600)("stopB", 11*3600 + 10*60);
+    b.finish();
+    b.data->pt_data->index();
+    b.data->build_raptor();
+    b.data->build_jointures();
+    b.data->meta->production_date = boost::gregorian::date_period(
+                boost::gregorian::date_from_iso_string("20120613"),
+                boost::gregorian::date_from_iso_string("20120630"));
+
+    auto get_schedules = [&](size_t nb_threads) {
+        return navitia::timetables::route_schedule("stop_point.uri=stopB", {}, d("20120615T070000"), 86400, 1, 3,
+                                                   10, 0, *(b.data), false, false, nb_threads);
+    };
+    const auto resp = get_schedules(1);
+    BOOST_REQUIRE_EQUAL(resp.route_schedules().size(), 3);
+    BOOST_CHECK_EQUAL(resp.pagination().totalresult(), 3);
+
+    std::vector<std::string> vjs;
+    for (const auto& route_schedule: resp.route_schedules()) {
+        for (const auto& header: route_schedule.table().headers()) {
+            vjs.push_back(header.pt_display_informations().uris().vehicle_journey());
+        }
+    }
+    const std::vector<std::string> expected_vjs = {"A2", "B1", "C1", "C2"};
+    BOOST_CHECK_EQUAL_COLLECTIONS(vjs.begin(), vjs.end(), expected_vjs.begin(), expected_vjs.end());
+
+    for (size_t nb_threads: {2, 4, 8}) {
+        const auto parallel_resp = get_schedules(nb_threads);
+        BOOST_CHECK_EQUAL(parallel_resp.SerializeAsString(), resp.SerializeAsString());
+    }
+}
+
+/*
+ * like when the journey patterns were queried route by route,
+ * a route of the filter without journey pattern is an error
+ */
+BOOST_AUTO_TEST_CASE(route_schedules_route_without_journey_pattern) {
+    ed::builder b("20120614");
+    b.vj("A", "1111111", "", true, "A1", "A1", "JPA1")("stopA", 8*3600)("stopB", 8*3600 + 10*60);
+    auto* route = new navitia::type::Route();
+    route->uri = "route_without_jp";
+    route->line = b.lines["A"];
+    route->line->route_list.push_back(route);
+    b.data->pt_data->routes.push_back(route);
+    b.finish();
+    b.data->pt_data->index();
+    b.data->build_raptor();
+    b.data->build_jointures();
+    b.data->meta->production_date = boost::gregorian::date_period(
+                boost::gregorian::date_from_iso_string("20120613"),
+                boost::gregorian::date_from_iso_string("20120630"));
+
+    BOOST_CHECK_THROW(navitia::timetables::route_schedule("line.uri=A", {}, d("20120615T070000"), 86400, 1, 3,
+                                                          10, 0, *(b.data), false, false),
+                      navitia::ptref::ptref_error);
+}
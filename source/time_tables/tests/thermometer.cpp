@@ -326,6 +326,34 @@ BOOST_AUTO_TEST_CASE(tmp) {
     BOOST_REQUIRE_EQUAL(result.size(), 10);
 }
 
+BOOST_AUTO_TEST_CASE(thermometer_cache) {
+    ed::builder b("20120614");
+    b.vj("A", "11111111", "", true, "vj1", "", "jp1")("stop1", 8000)("stop2", 8100)("stop3", 8200);
+    b.vj("A", "11111111", "", true, "vj2", "", "jp2")("stop1", 9000)("stop4", 9100)("stop3", 9200);
+    b.vj("A", "11111111", "", true, "vj3", "", "jp3")("stop2", 10000)("stop3", 10100);
+    b.finish();
+    b.data->pt_data->index();
+    const auto* route = b.data->pt_data->routes.front();
+    BOOST_REQUIRE_EQUAL(route->journey_pattern_list.size(), 3);
+
+    Thermometer expected;
+    expected.generate_thermometer(route);
+    const auto thermometer = b.data->thermometers->get(route, *b.data->pt_data);
+    BOOST_CHECK(thermometer->get_thermometer() == expected.get_thermometer());
+    BOOST_CHECK_EQUAL(thermometer->get_thermometer().size(), 4);
+
+    // computed only once
+    BOOST_CHECK_EQUAL(b.data->thermometers->get(route, *b.data->pt_data), thermometer);
+    BOOST_CHECK_EQUAL(b.data->thermometers->size(), 1);
+
+    // another list of journey patterns has its own thermometer
+    const vector_idx jps = {route->journey_pattern_list.back()->idx};
+    const auto other = b.data->thermometers->get(jps, *b.data->pt_data);
+    BOOST_CHECK(other != thermometer);
+    BOOST_CHECK_EQUAL(other->get_thermometer().size(), 2);
+    BOOST_CHECK_EQUAL(b.data->thermometers->size(), 2);
+}
+
 //        BOOST_AUTO_TEST_CASE(lower_bound){
 //            BOOST_CHECK_LE(get_lower_bound({}), 0);
 //            BOOST_CHECK_LE(get_lower_bound({{1}}), 1);
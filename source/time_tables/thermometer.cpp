@@ -29,6 +29,7 @@ www.navitia.io
 */
 
 #include "thermometer.h"
+#include "type/pt_data.h"
 #include "ptreferential/ptreferential.h"
 #include "time.h"
 
@@ -156,7 +157,7 @@ void Thermometer::generate_thermometer(const std::vector<vector_idx> &journey_pa
 }
 
 
-vector_idx Thermometer::get_thermometer() const {
+const vector_idx& Thermometer::get_thermometer() const {
     return thermometer;
 }
 
@@ -215,6 +216,47 @@ vector_idx Thermometer::generate_possibilities(const std::vector<vector_idx> &jo
     }
 }
 
+std::shared_ptr<const Thermometer>
+ThermometerCache::get(const vector_idx& journey_patterns, const type::PT_Data& pt_data) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto it = thermometers.find(journey_patterns);
+        if (it != thermometers.end()) {
+            return it->second;
+        }
+    }
+    // the thermometer is computed without the lock, the first one stored is kept
+    std::vector<vector_idx> stop_points;
+    for (auto jp_idx : journey_patterns) {
+        stop_points.push_back(vector_idx());
+        for (auto jpp : pt_data.journey_patterns[jp_idx]->journey_pattern_point_list) {
+            stop_points.back().push_back(jpp->stop_point->idx);
+        }
+    }
+    auto thermometer = std::make_shared<Thermometer>();
+    thermometer->generate_thermometer(stop_points);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (thermometers.size() >= max_size) {
+        thermometers.clear();
+    }
+    return thermometers.insert({journey_patterns, std::move(thermometer)}).first->second;
+}
+
+std::shared_ptr<const Thermometer>
+ThermometerCache::get(const type::Route* route, const type::PT_Data& pt_data) {
+    vector_idx journey_patterns;
+    for (auto jp : route->journey_pattern_list) {
+        journey_patterns.push_back(jp->idx);
+    }
+    return get(journey_patterns, pt_data);
+}
+
+size_t ThermometerCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return thermometers.size();
+}
+
 std::vector<uint32_t> Thermometer::untail(std::vector<vector_idx> &journey_patterns, type::idx_t spidx, std::vector<vector_size> &pre_computed_lb) {
     std::vector<uint32_t> result;
     if(spidx != type::invalid_idx) {
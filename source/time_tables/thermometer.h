@@ -31,6 +31,9 @@ www.navitia.io
 #pragma once
 #include "type/data.h"
 #include "boost/functional/hash.hpp"
+#include <map>
+#include <memory>
+#include <mutex>
 namespace navitia { namespace timetables {
 
 typedef std::vector<type::idx_t> vector_idx;
@@ -39,7 +42,7 @@ typedef std::vector<uint16_t> vector_size;
 struct Thermometer {
     void generate_thermometer(const std::vector<vector_idx> &journey_patterns);
     void generate_thermometer(const type::Route* route);
-    vector_idx get_thermometer() const;
+    const vector_idx& get_thermometer() const;
     std::vector<uint32_t> match_journey_pattern(const type::JourneyPattern & journey_pattern) const;
     std::vector<uint32_t> match_journey_pattern(const vector_idx &journey_pattern) const;
 
@@ -64,6 +67,28 @@ private :
 };
 uint32_t get_lower_bound(std::vector<vector_size> &pre_computed_lb, vector_size mins, type::idx_t max_sp);
 
+/** The thermometers already computed, by list of journey patterns
+ *
+ * A thermometer only depends on the stop points of the journey patterns, but its search
+ * can be very long for the routes with many branches, so each one is computed only once.
+ * Owned by Data (so emptied when the data change) and shared by the workers.
+ */
+class ThermometerCache {
+public:
+    /// The thermometer of the journey patterns (by idx, in this order)
+    std::shared_ptr<const Thermometer> get(const vector_idx& journey_patterns, const type::PT_Data& pt_data);
+    /// The thermometer of all the journey patterns of the route
+    std::shared_ptr<const Thermometer> get(const type::Route* route, const type::PT_Data& pt_data);
+
+    size_t size() const;
+
+private:
+    /// the cache is cleared past this size, the lists of journey patterns come from the requests
+    static const size_t max_size = 100000;
+    mutable std::mutex mutex;
+    std::map<vector_idx, std::shared_ptr<const Thermometer>> thermometers;
+};
+
 
 
 }}
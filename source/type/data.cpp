@@ -51,6 +51,8 @@ www.navitia.io
 
 #include "pt_data.h"
 #include "routing/dataraptor.h"
+#include "ptreferential/ptref_graph.h"
+#include "time_tables/thermometer.h"
 #include "georef/georef.h"
 #include "fare/fare.h"
 #include "type/meta_data.h"
@@ -69,6 +71,7 @@ Data::Data(size_t data_identifier) :
     geo_ref(std::make_unique<navitia::georef::GeoRef>()),
     dataRaptor(std::make_unique<navitia::routing::dataRAPTOR>()),
     fare(std::make_unique<navitia::fare::Fare>()),
+    thermometers(std::make_unique<navitia::timetables::ThermometerCache>()),
     find_admins(
             [&](const GeographicalCoord &c){
             return geo_ref->find_admins(c);
@@ -100,6 +103,8 @@ bool Data::load(const std::string& filename,
         if (chaos_database) {
             fill_disruption_from_database(*chaos_database, *pt_data, *meta, contributors);
         }
+        // once the disruptions have added and removed their objects
+        build_jointures();
     } catch(const wrong_version& ex) {
         LOG4CPLUS_ERROR(logger, "Cannot load data: " << ex.what());
         last_load = false;
@@ -229,8 +234,10 @@ void  Data::build_administrative_regions(){
 }
 
 void Data::build_autocomplete(){
-    pt_data->build_autocomplete(*geo_ref);
-    geo_ref->build_autocomplete_list();
+    navitia::autocomplete::build_in_parallel({
+        [&]() { pt_data->build_autocomplete(*geo_ref); },
+        [&]() { geo_ref->build_autocomplete_list(); }
+    });
     pt_data->compute_score_autocomplete(*geo_ref);
 }
 
@@ -238,6 +245,10 @@ void Data::build_raptor() {
     dataRaptor->load(*this->pt_data);
 }
 
+void Data::build_jointures() {
+    jointures = std::make_unique<navitia::ptref::Jointures>(*this);
+}
+
 ValidityPattern* Data::get_similar_validity_pattern(ValidityPattern* vp) const{
     auto find_vp_predicate = [&](ValidityPattern* vp1) { return ((*vp) == (*vp1));};
     auto it = std::find_if(this->pt_data->validity_patterns.begin(),
@@ -529,7 +540,7 @@ template<> std::vector<type_name*> & \
 Data::get_data<type_name>() {\
     return this->pt_data->collection_name;\
 }\
-template<> std::vector<type_name *> \
+template<> const std::vector<type_name *>& \
 Data::get_data<type_name>() const {\
     return this->pt_data->collection_name;\
 }
@@ -539,7 +550,7 @@ template<> std::vector<georef::POI*> &
 Data::get_data<georef::POI>() {
     return this->geo_ref->pois;
 }
-template<> std::vector<georef::POI*>
+template<> const std::vector<georef::POI*>&
 Data::get_data<georef::POI>() const {
     return this->geo_ref->pois;
 }
@@ -548,7 +559,7 @@ template<> std::vector<georef::POIType*> &
 Data::get_data<georef::POIType>() {
     return this->geo_ref->poitypes;
 }
-template<> std::vector<georef::POIType*>
+template<> const std::vector<georef::POIType*>&
 Data::get_data<georef::POIType>() const {
     return this->geo_ref->poitypes;
 }
@@ -557,25 +568,27 @@ template<> std::vector<StopPointConnection*> &
 Data::get_data<StopPointConnection>() {
     return this->pt_data->stop_point_connections;
 }
-template<> std::vector<StopPointConnection*>
+template<> const std::vector<StopPointConnection*>&
 Data::get_data<StopPointConnection>() const {
     return this->pt_data->stop_point_connections;
 }
 
 
-std::vector<idx_t> Data::get_all_index(Type_e type) const {
-    size_t num_elements = 0;
+size_t Data::get_nb_obj(Type_e type) const {
     switch(type){
     #define GET_NUM_ELEMENTS(type_name, collection_name)\
     case Type_e::type_name:\
-        num_elements = this->pt_data->collection_name.size();break;
+        return this->pt_data->collection_name.size();
     ITERATE_NAVITIA_PT_TYPES(GET_NUM_ELEMENTS)
-    case Type_e::POI: num_elements = this->geo_ref->pois.size(); break;
-    case Type_e::POIType: num_elements = this->geo_ref->poitypes.size(); break;
-    case Type_e::Connection:
-        num_elements = this->pt_data->stop_point_connections.size(); break;
-    default:  break;
+    case Type_e::POI: return this->geo_ref->pois.size();
+    case Type_e::POIType: return this->geo_ref->poitypes.size();
+    case Type_e::Connection: return this->pt_data->stop_point_connections.size();
+    default: return 0;
     }
+}
+
+std::vector<idx_t> Data::get_all_index(Type_e type) const {
+    const size_t num_elements = get_nb_obj(type);
     std::vector<idx_t> indexes(num_elements);
     for(size_t i=0; i < num_elements; i++)
         indexes[i] = i;
@@ -54,6 +54,12 @@ namespace navitia{
     namespace type{
         struct MetaData;
     }
+    namespace ptref{
+        struct Jointures;
+    }
+    namespace timetables{
+        class ThermometerCache;
+    }
 }
 
 namespace navitia { namespace type {
@@ -74,7 +80,7 @@ struct wrong_version : public navitia::exception {
 class Data : boost::noncopyable{
 public:
 
-    static const unsigned int data_version = 34; //< Data version number. *INCREMENT* every time serialized data are modified
+    static const unsigned int data_version = 42; //< Data version number. *INCREMENT* every time serialized data are modified
     unsigned int version = 0; //< Version of loaded data
     std::atomic<bool> loaded; //< have the data been loaded ?
     std::atomic<bool> loading; //< Is the data being loaded
@@ -95,13 +101,18 @@ public:
     /// Fare data
     std::unique_ptr<navitia::fare::Fare> fare;
 
+    /// precomputed relations between the pt objects, for ptref
+    std::unique_ptr<navitia::ptref::Jointures> jointures;
+
+    /// thermometers of the routes, computed by the requests (thread safe)
+    std::unique_ptr<navitia::timetables::ThermometerCache> thermometers;
+
     // functor to find admins
     std::function<std::vector<georef::Admin*>(const GeographicalCoord&)> find_admins;
 
     /** Retourne la structure de données associée au type */
-    /// TODO : attention aux perfs à faire la copie
     template<typename T> std::vector<T*> & get_data();
-    template<typename T> std::vector<T*> get_data() const;
+    template<typename T> const std::vector<T*>& get_data() const;
 
     /** Retourne tous les indices d'un type donné
       *
@@ -109,6 +120,9 @@ public:
       */
     std::vector<idx_t> get_all_index(Type_e type) const;
 
+    /// Le nombre d'objets d'un type donné
+    size_t get_nb_obj(Type_e type) const;
+
 
     /** Étant donné une liste d'indexes pointant vers source,
       * retourne une liste d'indexes pointant vers target
@@ -147,8 +161,10 @@ public:
             throw wrong_version(msg.str());
         }
         ar & pt_data & geo_ref & meta & fare & last_load_at & loaded & last_load & is_connected_to_rabbitmq;
+        pt_data->build_name_index();
         //@TODO: remove this, this done twice when we load data from rabbitmq
         build_raptor();
+        // the jointures are built by the caller, once all the modifications of the data are done
     }
     BOOST_SERIALIZATION_SPLIT_MEMBER()
 
@@ -174,6 +190,12 @@ public:
     /** Construit les données raptor */
     void build_raptor();
 
+    /** Construit les relations entre les objets TC, pour ptref
+      *
+      * It must be called again after each modification of the pt objects (e.g. the disruptions)
+      */
+    void build_jointures();
+
     void build_associated_calendar();
 
     void aggregate_odt();
@@ -451,10 +451,9 @@ void fill_pb_object(const nt::Route* r, const nt::Data& data,
 
     fill_pb_object(r->shape, route->mutable_geojson());
 
-    auto thermometer = timetables::Thermometer();
-    thermometer.generate_thermometer(r);
     if (depth>2) {
-        for(auto idx : thermometer.get_thermometer()) {
+        const auto thermometer = data.thermometers->get(r, *data.pt_data);
+        for(auto idx : thermometer->get_thermometer()) {
             auto stop_point = data.pt_data->stop_points[idx];
                 fill_pb_object(stop_point, data, route->add_stop_points(), depth-1,
                         now, action_period, show_codes);
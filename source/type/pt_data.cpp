@@ -30,6 +30,9 @@ www.navitia.io
 
 #include "pt_data.h"
 #include "utils/functions.h"
+
+#include <numeric>
+#include <limits>
 namespace navitia{namespace type {
 
 
@@ -49,88 +52,178 @@ void PT_Data::sort(){
     for(auto* vj: this->vehicle_journeys){
         std::sort(vj->stop_time_list.begin(), vj->stop_time_list.end());
     }
+    renumber_for_locality();
+    // the idx have changed
+    build_name_index();
 }
 
 
-void PT_Data::build_autocomplete(const navitia::georef::GeoRef & georef){
-    this->stop_area_autocomplete.clear();
-    for(const StopArea* sa : this->stop_areas){
-        // A ne pas ajouter dans le disctionnaire si pas ne nom
-        if ((!sa->name.empty()) && (sa->visible)) {
-            std::string key="";
-            for( navitia::georef::Admin* admin : sa->admin_list){
-                if (admin->level ==8){key +=" " + admin->name;}
+/// index of the point (x, y) on the hilbert curve filling a n*n grid (n being a power of 2)
+static uint64_t hilbert_index(const uint32_t n, uint32_t x, uint32_t y) {
+    uint64_t d = 0;
+    for (uint32_t s = n / 2; s > 0; s /= 2) {
+        const uint32_t rx = (x & s) > 0;
+        const uint32_t ry = (y & s) > 0;
+        d += uint64_t(s) * s * ((3 * rx) ^ ry);
+        // we rotate the quadrant to have the curve in the right direction
+        if (ry == 0) {
+            if (rx == 1) {
+                x = n - 1 - x;
+                y = n - 1 - y;
             }
-            this->stop_area_autocomplete.add_string(sa->name + " " + key, sa->idx, georef.synonyms);
+            std::swap(x, y);
         }
     }
-    this->stop_area_autocomplete.build();
-
-    this->stop_point_autocomplete.clear();
-    for(const StopPoint* sp : this->stop_points){
-        // A ne pas ajouter dans le disctionnaire si pas ne nom
-        if ((!sp->name.empty()) && ((sp->stop_area == nullptr) || (sp->stop_area->visible))) {
-            std::string key="";
-            for(navitia::georef::Admin* admin : sp->admin_list){
-                if (admin->level == 8){key += key + " " + admin->name;}
-            }
-            this->stop_point_autocomplete.add_string(sp->name + " " + key, sp->idx, georef.synonyms);
-        }
+    return d;
+}
+
+void PT_Data::renumber_for_locality() {
+    const uint32_t grid_size = 1 << 16;
+
+    // bounding box of the stop points, the ones without coord are put at the end
+    double min_lon = std::numeric_limits<double>::max(), min_lat = std::numeric_limits<double>::max();
+    double max_lon = std::numeric_limits<double>::lowest(), max_lat = std::numeric_limits<double>::lowest();
+    for (const StopPoint* sp: stop_points) {
+        if (! sp->coord.is_initialized()) { continue; }
+        min_lon = std::min(min_lon, sp->coord.lon());
+        max_lon = std::max(max_lon, sp->coord.lon());
+        min_lat = std::min(min_lat, sp->coord.lat());
+        max_lat = std::max(max_lat, sp->coord.lat());
     }
-    this->stop_point_autocomplete.build();
-
-    this->line_autocomplete.clear();
-    for(const Line* line : this->lines){
-        if (!line->name.empty()){
-            std::string key="";
-            if (line->network){key = line->network->name;}
-            if (line->commercial_mode) {key += " " + line->commercial_mode->name;}
-            key += " " + line->code;
-            this->line_autocomplete.add_string(key + " " + line->name, line->idx, georef.synonyms);
-        }
+    const auto to_grid = [&](double val, double min, double max) {
+        if (max <= min) { return uint32_t(0); }
+        return std::min(uint32_t((val - min) / (max - min) * grid_size), grid_size - 1);
+    };
+    std::vector<uint64_t> sp_keys(stop_points.size(), std::numeric_limits<uint64_t>::max());
+    for (const StopPoint* sp: stop_points) {
+        if (! sp->coord.is_initialized()) { continue; }
+        sp_keys[sp->idx] = hilbert_index(grid_size,
+                                         to_grid(sp->coord.lon(), min_lon, max_lon),
+                                         to_grid(sp->coord.lat(), min_lat, max_lat));
     }
-    this->line_autocomplete.build();
+    // the sorts are stable to keep the order of sort() between the equivalent objects
+    std::stable_sort(stop_points.begin(), stop_points.end(),
+                     [&](const StopPoint* sp1, const StopPoint* sp2) {
+        return sp_keys[sp1->idx] < sp_keys[sp2->idx];
+    });
+    std::for_each(stop_points.begin(), stop_points.end(), Indexer<idx_t>());
 
-    this->network_autocomplete.clear();
-    for(const Network* network : this->networks){
-        if (!network->name.empty()){
-            this->network_autocomplete.add_string(network->name, network->idx, georef.synonyms);
-        }
-    }
-    this->network_autocomplete.build();
+    const auto first_sp = [](const JourneyPattern* jp) {
+        if (jp->journey_pattern_point_list.empty()) { return std::numeric_limits<idx_t>::max(); }
+        return jp->journey_pattern_point_list.front()->stop_point->idx;
+    };
+    std::stable_sort(journey_patterns.begin(), journey_patterns.end(),
+                     [&](const JourneyPattern* jp1, const JourneyPattern* jp2) {
+        return first_sp(jp1) < first_sp(jp2);
+    });
+    std::for_each(journey_patterns.begin(), journey_patterns.end(), Indexer<idx_t>());
 
-    this->mode_autocomplete.clear();
-    for(const CommercialMode* mode : this->commercial_modes){
-        if (!mode->name.empty()){
-            this->mode_autocomplete.add_string(mode->name, mode->idx, georef.synonyms);
+    // the points of a journey pattern are contiguous, in their order
+    std::sort(journey_pattern_points.begin(), journey_pattern_points.end(),
+              [](const JourneyPatternPoint* jpp1, const JourneyPatternPoint* jpp2) {
+        if (jpp1->journey_pattern->idx != jpp2->journey_pattern->idx) {
+            return jpp1->journey_pattern->idx < jpp2->journey_pattern->idx;
         }
-    }
-    this->mode_autocomplete.build();
-
-    this->route_autocomplete.clear();
-    for(const Route* route : this->routes){
-        if (!route->name.empty()){
-            std::string key="";
-            if (route->line){
-                if (route->line->network){key = route->line->network->name;}
-                if (route->line->commercial_mode) {key += " " + route->line->commercial_mode->name;}
-                key += " " + route->line->code;
+        return jpp1->order < jpp2->order;
+    });
+    std::for_each(journey_pattern_points.begin(), journey_pattern_points.end(), Indexer<idx_t>());
+}
+
+void PT_Data::build_autocomplete(const navitia::georef::GeoRef & georef){
+    const navitia::autocomplete::SynonymAutomaton synonyms(georef.synonyms);
+    // each type has its own index, they are built at the same time
+    navitia::autocomplete::build_in_parallel({
+        [&]() {
+            this->stop_area_autocomplete.clear();
+            for(const StopArea* sa : this->stop_areas){
+                // A ne pas ajouter dans le disctionnaire si pas ne nom
+                if ((!sa->name.empty()) && (sa->visible)) {
+                    std::string key="";
+                    for( navitia::georef::Admin* admin : sa->admin_list){
+                        if (admin->level ==8){key +=" " + admin->name;}
+                    }
+                    this->stop_area_autocomplete.add_string(sa->name + " " + key, sa->idx, synonyms);
+                }
+            }
+            this->stop_area_autocomplete.build();
+            this->stop_area_autocomplete.build_admin_index(this->stop_areas, georef.admins.size());
+        },
+        [&]() {
+            this->stop_point_autocomplete.clear();
+            for(const StopPoint* sp : this->stop_points){
+                // A ne pas ajouter dans le disctionnaire si pas ne nom
+                if ((!sp->name.empty()) && ((sp->stop_area == nullptr) || (sp->stop_area->visible))) {
+                    std::string key="";
+                    for(navitia::georef::Admin* admin : sp->admin_list){
+                        if (admin->level == 8){key += key + " " + admin->name;}
+                    }
+                    this->stop_point_autocomplete.add_string(sp->name + " " + key, sp->idx, synonyms);
+                }
+            }
+            this->stop_point_autocomplete.build();
+            this->stop_point_autocomplete.build_admin_index(this->stop_points, georef.admins.size());
+        },
+        [&]() {
+            this->line_autocomplete.clear();
+            for(const Line* line : this->lines){
+                if (!line->name.empty()){
+                    std::string key="";
+                    if (line->network){key = line->network->name;}
+                    if (line->commercial_mode) {key += " " + line->commercial_mode->name;}
+                    key += " " + line->code;
+                    this->line_autocomplete.add_string(key + " " + line->name, line->idx, synonyms);
+                }
+            }
+            this->line_autocomplete.build();
+        },
+        [&]() {
+            this->network_autocomplete.clear();
+            for(const Network* network : this->networks){
+                if (!network->name.empty()){
+                    this->network_autocomplete.add_string(network->name, network->idx, synonyms);
+                }
+            }
+            this->network_autocomplete.build();
+        },
+        [&]() {
+            this->mode_autocomplete.clear();
+            for(const CommercialMode* mode : this->commercial_modes){
+                if (!mode->name.empty()){
+                    this->mode_autocomplete.add_string(mode->name, mode->idx, synonyms);
+                }
+            }
+            this->mode_autocomplete.build();
+        },
+        [&]() {
+            this->route_autocomplete.clear();
+            for(const Route* route : this->routes){
+                if (!route->name.empty()){
+                    std::string key="";
+                    if (route->line){
+                        if (route->line->network){key = route->line->network->name;}
+                        if (route->line->commercial_mode) {key += " " + route->line->commercial_mode->name;}
+                        key += " " + route->line->code;
+                    }
+                    this->route_autocomplete.add_string(key + " " + route->name, route->idx, synonyms);
+                }
             }
-            this->route_autocomplete.add_string(key + " " + route->name, route->idx, georef.synonyms);
+            this->route_autocomplete.build();
         }
-    }
-    this->route_autocomplete.build();
+    });
 }
 
 void PT_Data::compute_score_autocomplete(navitia::georef::GeoRef& georef){
     //Compute admin score using stop_point count in each admin
     georef.fl_admin.compute_score((*this), georef, type::Type_e::Admin);
     //use the score of each admin for it's objects like "POI", "way" and "stop_point"
-    georef.fl_way.compute_score((*this), georef, type::Type_e::Way);
-    georef.fl_poi.compute_score((*this), georef, type::Type_e::POI);
-    this->stop_point_autocomplete.compute_score((*this), georef, type::Type_e::StopPoint);
-    //Compute stop_area score using it's stop_point count
-    this->stop_area_autocomplete.compute_score((*this), georef, type::Type_e::StopArea);
+    //the admin scores are only read from now, the other indexes can be scored at the same time
+    navitia::autocomplete::build_in_parallel({
+        [&]() { georef.fl_way.compute_score((*this), georef, type::Type_e::Way); },
+        [&]() { georef.fl_poi.compute_score((*this), georef, type::Type_e::POI); },
+        [&]() { this->stop_point_autocomplete.compute_score((*this), georef, type::Type_e::StopPoint); },
+        //Compute stop_area score using it's stop_point count
+        [&]() { this->stop_area_autocomplete.compute_score((*this), georef, type::Type_e::StopArea); }
+    });
 }
 
 
@@ -185,6 +278,22 @@ void PT_Data::build_uri() {
     fill_ext_code_map(ext_codes_map, vehicle_journeys, pbnavitia::PlaceCodeRequest::VehicleJourney);
     fill_ext_code_map(ext_codes_map, stop_points, pbnavitia::PlaceCodeRequest::StopPoint);
     fill_ext_code_map(ext_codes_map, calendars, pbnavitia::PlaceCodeRequest::Calendar);
+    build_name_index();
+}
+
+template<typename T>
+static void fill_name_index(std::vector<idx_t>& by_name, const std::vector<T*>& objects) {
+    by_name.resize(objects.size());
+    std::iota(by_name.begin(), by_name.end(), idx_t(0));
+    std::sort(by_name.begin(), by_name.end(), [&](idx_t a, idx_t b) {
+        if (objects[a]->name != objects[b]->name) { return objects[a]->name < objects[b]->name; }
+        return a < b;
+    });
+}
+
+void PT_Data::build_name_index() {
+#define FILL_NAME_INDEX(type_name, collection_name) fill_name_index(collection_name##_by_name, collection_name);
+    ITERATE_NAVITIA_PT_NAMED_TYPES(FILL_NAME_INDEX)
 }
 
 /** Foncteur fixe le membre "idx" d'un objet en incrémentant toujours de 1
@@ -202,6 +311,7 @@ struct Indexer{
 void PT_Data::index(){
 #define INDEX(type_name, collection_name) std::for_each(collection_name.begin(), collection_name.end(), Indexer());
     ITERATE_NAVITIA_PT_TYPES(INDEX)
+    build_name_index();
 }
 
 PT_Data::~PT_Data() {
@@ -53,6 +53,21 @@ namespace type {
 typedef std::map<std::string, std::string> code_value_map_type;
 typedef std::map<std::string, code_value_map_type> type_code_codes_map_type;
 typedef flat_enum_map<pbnavitia::PlaceCodeRequest::Type, type_code_codes_map_type> ext_codes_map_type;
+
+/// Les types indexés par nom pour les filtres de ptref
+/// The vehicle journeys and the journey patterns are changed by the disruptions, they are not indexed
+#define ITERATE_NAVITIA_PT_NAMED_TYPES(FUN)\
+    FUN(Line, lines)\
+    FUN(StopPoint, stop_points)\
+    FUN(StopArea, stop_areas)\
+    FUN(Network, networks)\
+    FUN(PhysicalMode, physical_modes)\
+    FUN(CommercialMode, commercial_modes)\
+    FUN(Company, companies)\
+    FUN(Route, routes)\
+    FUN(Contributor, contributors)\
+    FUN(Calendar, calendars)
+
 struct PT_Data : boost::noncopyable{
 #define COLLECTION_AND_MAP(type_name, collection_name) std::vector<type_name*> collection_name; std::unordered_map<std::string, type_name *> collection_name##_map;
     ITERATE_NAVITIA_PT_TYPES(COLLECTION_AND_MAP)
@@ -78,6 +93,12 @@ struct PT_Data : boost::noncopyable{
     ITERATE_NAVITIA_PT_TYPES(ERASE_OBJ)
 
     ext_codes_map_type ext_codes_map;
+
+    /// idx des objets triés par nom (then by idx), to find the objects of a name by a binary search
+    /// They are not serialized: they are built at load, and again each time the idx change (sort, index)
+#define NAME_INDEX(type_name, collection_name) std::vector<idx_t> collection_name##_by_name;
+    ITERATE_NAVITIA_PT_NAMED_TYPES(NAME_INDEX)
+
     std::vector<StopPointConnection*> stop_point_connections;
 
     // meta vj map
@@ -124,7 +145,8 @@ struct PT_Data : boost::noncopyable{
         ar
         #define SERIALIZE_ELEMENTS(type_name, collection_name) & collection_name & collection_name##_map
                 ITERATE_NAVITIA_PT_TYPES(SERIALIZE_ELEMENTS)
-                & ext_codes_map & stop_area_autocomplete & stop_point_autocomplete & line_autocomplete
+                & ext_codes_map
+                & stop_area_autocomplete & stop_point_autocomplete & line_autocomplete
                 & network_autocomplete & mode_autocomplete & route_autocomplete
                 & stop_area_proximity_list & stop_point_proximity_list
                 & stop_point_connections
@@ -142,6 +164,9 @@ struct PT_Data : boost::noncopyable{
     /** Construit l'indexe ExternelCode */
     void build_uri();
 
+    /** Construit les indexes par nom */
+    void build_name_index();
+
     /** Construit l'indexe Autocomplete */
     void build_autocomplete(const navitia::georef::GeoRef&);
 
@@ -151,9 +176,23 @@ struct PT_Data : boost::noncopyable{
     /** Construit l'indexe ProximityList */
     void build_proximity_list();
     void build_admins_stop_areas();
-    /// tris les collections et affecte un idx a chaque élément
+    /** tris les collections et affecte un idx a chaque élément
+      *
+      * The stop points, journey patterns and their points are then renumbered for the locality
+      * (see renumber_for_locality), so a new sort keeps the same order. The index based structures
+      * (proximity lists, autocomplete, raptor, jointures) must be built after it.
+      */
     void sort();
 
+    /** Renumber the stop points, the journey patterns and their points so that
+      * the objects close in the network are close in memory (for raptor's label arrays)
+      *
+      * The stop points follow a hilbert curve on their coordinates, the journey patterns
+      * follow their first stop point and the journey pattern points follow their journey pattern.
+      * Called by sort()
+      */
+    void renumber_for_locality();
+
     size_t nb_stop_times() const {
         size_t nb = 0;
         for (const auto jp:journey_patterns) {
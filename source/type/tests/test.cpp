@@ -35,9 +35,12 @@ www.navitia.io
 #include "type/type.h"
 #include "type/message.h"
 #include "type/data.h"
+#include "type/pt_data.h"
 
 #include <boost/geometry.hpp>
 #include <boost/make_shared.hpp>
+#include <boost/range/algorithm/find_if.hpp>
+#include <set>
 
 namespace pt = boost::posix_time;
 namespace bg = boost::gregorian;
@@ -203,3 +206,95 @@ BOOST_AUTO_TEST_CASE(vj_is_odt) {
     vj_odt.vehicle_journey_type = VehicleJourneyType::odt_point_to_point;
     BOOST_CHECK(vj_odt.is_odt());
 }
+
+/*
+ * 2 clusters of stop points, created alternatively, and a journey pattern by cluster,
+ * the one in the south being created first
+ */
+static void add_two_clusters(navitia::type::PT_Data& pt_data) {
+    const std::vector<GeographicalCoord> coords = {{2.35, 48.85}, {5.37, 43.29}, {2.36, 48.86},
+                                                   {5.38, 43.30}, {2.35, 48.86}, {5.37, 43.30}};
+    for (size_t i = 0; i < coords.size(); ++i) {
+        auto* sp = new StopPoint();
+        sp->uri = "sp" + std::to_string(i);
+        sp->coord = coords[i];
+        pt_data.stop_points.push_back(sp);
+    }
+    for (const auto& sp_uris: std::vector<std::vector<std::string>>{{"sp5", "sp3", "sp1"}, {"sp0", "sp2", "sp4"}}) {
+        auto* jp = new JourneyPattern();
+        jp->uri = "jp" + std::to_string(pt_data.journey_patterns.size());
+        pt_data.journey_patterns.push_back(jp);
+        uint16_t order = 0;
+        for (const auto& sp_uri: sp_uris) {
+            auto* jpp = new JourneyPatternPoint();
+            jpp->journey_pattern = jp;
+            jpp->order = order++;
+            jpp->stop_point = *boost::find_if(pt_data.stop_points,
+                                              [&](const StopPoint* sp) { return sp->uri == sp_uri; });
+            jp->journey_pattern_point_list.push_back(jpp);
+            pt_data.journey_pattern_points.push_back(jpp);
+        }
+    }
+}
+
+/*
+ * the stop points are renumbered along a hilbert curve, the journey patterns follow
+ * their first stop point and the journey pattern points are contiguous by journey pattern
+ */
+BOOST_AUTO_TEST_CASE(renumber_for_locality) {
+    navitia::type::PT_Data pt_data;
+    add_two_clusters(pt_data);
+    pt_data.sort();
+
+    // the stop points of a cluster are contiguous
+    std::set<char> first_half, second_half;
+    for (size_t i = 0; i < 3; ++i) {
+        first_half.insert(pt_data.stop_points[i]->coord.lon() < 3 ? 'n' : 's');
+        second_half.insert(pt_data.stop_points[i + 3]->coord.lon() < 3 ? 'n' : 's');
+    }
+    BOOST_CHECK_EQUAL(first_half.size(), 1);
+    BOOST_CHECK_EQUAL(second_half.size(), 1);
+    BOOST_CHECK(first_half != second_half);
+
+    // the indexes are consistent
+    for (size_t i = 0; i < pt_data.stop_points.size(); ++i) {
+        BOOST_CHECK_EQUAL(pt_data.stop_points[i]->idx, i);
+    }
+    for (size_t i = 0; i < pt_data.journey_patterns.size(); ++i) {
+        BOOST_CHECK_EQUAL(pt_data.journey_patterns[i]->idx, i);
+    }
+    // the journey patterns follow their first stop point and their points follow them
+    BOOST_CHECK_LT(pt_data.journey_patterns[0]->journey_pattern_point_list.front()->stop_point->idx,
+                   pt_data.journey_patterns[1]->journey_pattern_point_list.front()->stop_point->idx);
+    for (size_t i = 0; i < pt_data.journey_pattern_points.size(); ++i) {
+        const auto* jpp = pt_data.journey_pattern_points[i];
+        BOOST_CHECK_EQUAL(jpp->idx, i);
+        BOOST_CHECK_EQUAL(jpp->journey_pattern->idx, i / 3);
+        BOOST_CHECK_EQUAL(jpp->order, i % 3);
+    }
+}
+
+/*
+ * the data are sorted again after Data::complete() (by nav2rt after the disruptions),
+ * the renumbering for the locality must not be lost
+ */
+BOOST_AUTO_TEST_CASE(sort_again_keeps_the_order) {
+    navitia::type::PT_Data pt_data;
+    add_two_clusters(pt_data);
+    pt_data.sort();
+    const auto stop_points = pt_data.stop_points;
+    const auto journey_patterns = pt_data.journey_patterns;
+    const auto journey_pattern_points = pt_data.journey_pattern_points;
+
+    pt_data.sort();
+
+    BOOST_CHECK(pt_data.stop_points == stop_points);
+    BOOST_CHECK(pt_data.journey_patterns == journey_patterns);
+    BOOST_CHECK(pt_data.journey_pattern_points == journey_pattern_points);
+    for (size_t i = 0; i < pt_data.stop_points.size(); ++i) {
+        BOOST_CHECK_EQUAL(pt_data.stop_points[i]->idx, i);
+    }
+    for (size_t i = 0; i < pt_data.journey_pattern_points.size(); ++i) {
+        BOOST_CHECK_EQUAL(pt_data.journey_pattern_points[i]->idx, i);
+    }
+}
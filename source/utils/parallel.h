@@ -0,0 +1,92 @@
+/* Copyright © 2001-2014, Canal TP and/or its affiliates. All rights reserved.
+  
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+ 
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+  
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+   
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+   
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+  
+Stay tuned using
+twitter @navitia 
+IRC #navitia on freenode
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace navitia {
+
+/*
+ * Call f(state, i) for each i in [0, nb_elements), the elements being shared between
+ * nb_threads threads, the calling thread being one of them.
+ *
+ * Each thread takes the next element to compute, and has its own state built by make_state().
+ * The first exception thrown stops the distribution of the elements, it is rethrown
+ * once all the threads are over.
+ */
+template<typename MakeState, typename F>
+void for_each_in_threads(size_t nb_elements, size_t nb_threads, MakeState make_state, F f) {
+    std::atomic<size_t> next_element(0);
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    auto worker = [&]() {
+        try {
+            auto state = make_state();
+            for (size_t i = next_element++; i < nb_elements; i = next_element++) {
+                f(state, i);
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            if (! error) { error = std::current_exception(); }
+            next_element = nb_elements;
+        }
+    };
+
+    nb_threads = std::max(size_t(1), std::min(nb_threads, nb_elements));
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < nb_threads; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread: threads) {
+        thread.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+/*
+ * Call f(i) for each i in [0, nb_elements), the elements being shared between nb_threads threads
+ */
+template<typename F>
+void for_each_in_threads(size_t nb_elements, size_t nb_threads, F f) {
+    struct NoState {};
+    for_each_in_threads(nb_elements, nb_threads, []() { return NoState(); },
+                        [&](NoState&, size_t i) { f(i); });
+}
+
+} // namespace navitia